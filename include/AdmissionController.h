@@ -0,0 +1,68 @@
+#ifndef ADMISSIONCONTROLLER_H
+#define ADMISSIONCONTROLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+namespace Zork {
+
+    enum class Priority {
+        NORMAL,
+        LOW         // From a client that has been spending its rate limit fast
+    };
+
+    // Server-wide load shedding. Counts the requests handed to the pool
+    // and not yet answered, and keeps a latency histogram that tick()
+    // closes into a window about once a second. The server is overloaded
+    // while too many requests are in flight, or while the last window's
+    // p99 was over the limit. Then new sessions and LOW commands are
+    // refused; NORMAL commands are refused only at twice the in-flight
+    // limit, so well-behaved players keep being served while the noisy
+    // ones back off. Limits of 0 are unlimited.
+    class AdmissionController {
+    private:
+        static const size_t LATENCY_BUCKETS = 128;   // Four per power of two microseconds, to about 70 minutes
+        static const uint64_t MIN_SAMPLES = 20;      // Fewer in a window say nothing about its p99
+
+        size_t maxInFlight_;
+        std::chrono::microseconds maxP99_;
+        std::atomic<size_t> inFlight_;
+        std::atomic<uint64_t> window_[LATENCY_BUCKETS];
+        std::atomic<bool> slow_;
+        std::atomic<uint64_t> p50_;                  // Of the last window, in microseconds
+        std::atomic<uint64_t> p99_;
+        std::atomic<uint64_t> completed_;
+        std::atomic<uint64_t> shedSessions_;
+        std::atomic<uint64_t> shedCommands_;
+        std::mutex tickMutex_;
+
+        bool admit(size_t limit, std::atomic<uint64_t>& shed);
+
+    public:
+        AdmissionController(size_t maxInFlight, int maxP99Ms);
+
+        // Before first use
+        void configure(size_t maxInFlight, int maxP99Ms);
+
+        // Each admitted request must be followed by finished()
+        bool admitSession();
+        bool admitCommand(Priority priority);
+        void finished(std::chrono::steady_clock::duration latency);
+
+        // Closes the current latency window
+        void tick();
+
+        bool overloaded() const;
+        size_t inFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+        uint64_t p50Micros() const { return p50_.load(std::memory_order_relaxed); }
+        uint64_t p99Micros() const { return p99_.load(std::memory_order_relaxed); }
+        uint64_t getCompleted() const { return completed_.load(std::memory_order_relaxed); }
+        uint64_t getShedSessions() const { return shedSessions_.load(std::memory_order_relaxed); }
+        uint64_t getShedCommands() const { return shedCommands_.load(std::memory_order_relaxed); }
+    };
+}
+
+#endif // ADMISSIONCONTROLLER_H
@@ -0,0 +1,60 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+namespace Zork {
+
+    // Monotonic bump allocator. Deallocation is a no-op; memory is handed
+    // back in whole blocks by reset() or when the arena is destroyed.
+    class Arena : public std::pmr::memory_resource {
+    private:
+        struct Block {
+            Block* next;
+            size_t size;
+        };
+
+        Block* head_;
+        char* cursor_;
+        char* end_;
+        size_t blockSize_;
+        size_t bytesUsed_;
+        size_t bytesReserved_;
+
+        void grow(size_t minBytes);
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void*, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    public:
+        explicit Arena(size_t blockSize = 4096);
+        ~Arena() override;
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // Drops everything allocated so far but keeps the newest (largest)
+        // block, so a per-turn scratch arena settles at zero mallocs.
+        void reset();
+
+        size_t getBytesUsed() const { return bytesUsed_; }
+        size_t getBytesReserved() const { return bytesReserved_; }
+
+        // Object and shared_ptr control block live in one arena chunk.
+        // The arena must outlive every copy of the returned pointer.
+        template <typename T, typename... Args>
+        std::shared_ptr<T> makeShared(Args&&... args) {
+            return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(this),
+                                           std::forward<Args>(args)...);
+        }
+    };
+}
+
+#endif // ARENA_H
@@ -27,8 +27,8 @@ namespace Zork {
     public:
         Command(const std::string& input);
         
-        std::string getVerb() const { return verb_; }
-        std::vector<std::string> getArgs() const { return args_; }
+        const std::string& getVerb() const { return verb_; }
+        const std::vector<std::string>& getArgs() const { return args_; }
         std::string getArgsAsString() const;
         bool hasArgs() const { return !args_.empty(); }
     };
@@ -39,12 +39,28 @@ namespace Zork {
         std::map<std::string, std::vector<std::string>> commandAliases_;
         
         void setupAliases();
-        std::string normalizeVerb(const std::string& verb);
+        std::string normalizeVerb(const std::string& verb) const;
+        void splitObjects(const Command& cmd, std::string& item, std::string& with) const;
+        // For commands whose only changes come from rules and triggers
+        void recordRuleDelta(int scoreBefore);
         
     public:
         CommandParser(Game* game);
         
         CommandResult parse(const std::string& input);
+        CommandResult execute(const Command& cmd);
+        
+        // Splits pipelined input ("n. e, take lamp then up") into single
+        // commands; '.', ',' and the word "then" separate them
+        static std::vector<std::string> splitPipeline(const std::string& input);
+        
+        // splitPipeline plus tokenizing; needs no game, so the server does
+        // it on the I/O thread before handing commands to a worker
+        static std::vector<Command> parsePipeline(const std::string& input);
+        
+        // "n" -> "north", "get" -> "take" and so on, for code that runs
+        // commands without a Game
+        static std::string canonicalVerb(const std::string& verb);
         
         // Command handlers
         CommandResult handleMove(const Command& cmd);
@@ -54,12 +70,16 @@ namespace Zork {
         CommandResult handleDrop(const Command& cmd);
         CommandResult handleInventory(const Command& cmd);
         CommandResult handleUse(const Command& cmd);
+        CommandResult handleOpen(const Command& cmd);
+        CommandResult handleCombine(const Command& cmd);
         CommandResult handleAttack(const Command& cmd);
         CommandResult handleScore(const Command& cmd);
         CommandResult handleSave(const Command& cmd);
         CommandResult handleLoad(const Command& cmd);
         CommandResult handleHelp(const Command& cmd);
         CommandResult handleQuit(const Command& cmd);
+        CommandResult handleUndo(const Command& cmd);
+        CommandResult handleRedo(const Command& cmd);
         
         std::string getHelpText() const;
     };
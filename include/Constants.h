@@ -2,6 +2,7 @@
 #define CONSTANTS_H
 
 #include <string>
+#include <cstddef>
 
 namespace Zork {
     namespace Constants {
@@ -11,12 +12,44 @@ namespace Zork {
         const int INITIAL_PLAYER_HEALTH = 100;
         const std::string GAME_VERSION = "1.0.0";
         const std::string SAVE_FILE_EXTENSION = ".sav";
+        const int UNDO_HISTORY_SIZE = 32;
+        const std::string DATA_DIRECTORY = "./data/";
+        
+        // Paged grid world (--grid)
+        const std::string GRID_ENTRANCE = "cellar";   // Its "down" exit leads into the grid
+        const int GRID_REGION_SIZE = 32;              // Rooms along each side of a region
+        const size_t RESIDENT_REGIONS = 16;           // Regions kept in memory at once
+        
+        // Server
+        const int HIBERNATE_AFTER_SECONDS = 300;  // Idle time before a session is written out
+        const int IDLE_CHECK_INTERVAL_MS = 1000;
+        const size_t SESSION_QUEUE_DEPTH = 64;    // Commands waiting per session before 429; one
+                                                  // connection never has more in flight
+        const size_t COMPLETION_QUEUE_DEPTH = 4096;
+        const size_t REGIONS_PER_WORKER = 4;      // Shared world regions per pool thread
+        const size_t REGION_QUEUE_DEPTH = 4096;   // Messages waiting per region before they back off
+        const size_t SESSION_SOFT_BUDGET_BYTES = 512 * 1024;       // Hibernate after the turn
+        const size_t SESSION_HARD_BUDGET_BYTES = 4 * 1024 * 1024;  // Close the session
+        const size_t MEMORY_BUDGET_BYTES = 192 * 1024 * 1024;      // All sessions; pod limit is 256Mi
+        const double SESSION_COMMAND_RATE = 10;       // Commands a second per session, after
+        const double SESSION_COMMAND_BURST = 30;      // a burst of this many
+        const double ADDRESS_REQUEST_RATE = 100;      // Requests a second per client address
+        const double ADDRESS_REQUEST_BURST = 200;
+        const size_t MAX_IN_FLIGHT = 2048;            // Requests on the pool before shedding
+        const int MAX_P99_MS = 500;                   // Turn latency before shedding
+        
+        // Lighting
+        const int LAMP_FUEL = 300;
+        const int LOW_FUEL_WARNING = 20;
+        const int GRUE_GRACE_TURNS = 2;   // Turns in the dark before a grue may strike
+        const int GRUE_CHANCE = 35;       // Percent per turn after that
         
         // Scoring
         const int SCORE_ITEM_PICKUP = 5;
         const int SCORE_ROOM_DISCOVERED = 10;
         const int SCORE_PUZZLE_SOLVED = 25;
         const int SCORE_ENEMY_DEFEATED = 50;
+        const int SCORE_MILESTONE = 50;       // Leaderboard update every this many points
         
         // Combat
         const int BASE_ATTACK_DAMAGE = 10;
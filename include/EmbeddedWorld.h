@@ -0,0 +1,76 @@
+#ifndef EMBEDDEDWORLD_H
+#define EMBEDDEDWORLD_H
+
+#include <cstddef>
+#include <cstdint>
+#include "Item.h"
+
+namespace Zork {
+
+    // The flagship world, compiled into the binary. The tables are generated
+    // from data/rooms.json, items.json and enemies.json by zork-worldgen at
+    // build time and live in read-only data; content errors fail the build.
+    // Rooms, exits and items refer to each other by index, like WorldSnapshot.
+    // rules.json is carried as text and compiled once when first needed.
+    struct EmbeddedRoom {
+        const char* id;
+        const char* name;
+        const char* description;
+        bool lit;
+        bool locked;
+        uint32_t firstExit;   // Exits of a room are contiguous
+        uint32_t exitCount;
+    };
+
+    struct EmbeddedExit {
+        const char* direction;
+        uint32_t room;
+    };
+
+    struct EmbeddedItem {
+        const char* name;
+        const char* description;
+        int weight;
+        bool takeable;
+        ItemType type;
+        int value;
+        int damage;
+        int defense;
+        bool lightSource;
+        bool lightOn;
+        int fuel;
+        int lightRadius;
+        uint32_t room;        // NO_ROOM for items defined but not placed
+    };
+
+    struct EmbeddedEnemy {
+        const char* name;
+        const char* description;
+        int health;
+        int attackPower;
+        int defense;
+        int experienceReward;
+        bool hostile;
+        uint32_t room;        // NO_ROOM for wandering or unplaced enemies
+        bool darkRooms;       // Lurks in any unlit room
+    };
+
+    struct EmbeddedWorld {
+        static constexpr uint32_t NO_ROOM = 0xffffffff;
+
+        const EmbeddedRoom* rooms;
+        size_t roomCount;
+        const EmbeddedExit* exits;
+        size_t exitCount;
+        const EmbeddedItem* items;
+        size_t itemCount;
+        const EmbeddedEnemy* enemies;
+        size_t enemyCount;
+        uint32_t startRoom;
+        const char* rules;    // rules.json, or nullptr if there was none
+    };
+
+    extern const EmbeddedWorld EMBEDDED_WORLD;
+}
+
+#endif // EMBEDDEDWORLD_H
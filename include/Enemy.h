@@ -25,8 +25,8 @@ namespace Zork {
               int defense);
         
         // Getters
-        std::string getName() const { return name_; }
-        std::string getDescription() const { return description_; }
+        const std::string& getName() const { return name_; }
+        const std::string& getDescription() const { return description_; }
         int getHealth() const { return health_; }
         int getMaxHealth() const { return maxHealth_; }
         int getAttackPower() const { return attackPower_; }
@@ -4,42 +4,90 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <random>
+#include <functional>
+#include <iosfwd>
+#include "Arena.h"
 #include "Player.h"
 #include "Room.h"
 #include "Command.h"
 #include "Enemy.h"
+#include "Snapshot.h"
+#include "History.h"
+#include "WorldPager.h"
+#include "WorldWatcher.h"
+#include "SaveManager.h"
+#include "RuleEngine.h"
+#include "Triggers.h"
+#include "Lighting.h"
 
 namespace Zork {
     
     class CommandParser; // Forward declaration
+    struct EmbeddedWorld;
+    class Game;
+    
+    using TriggerCallback = std::function<void(Game&, std::string&)>;
+    // Called when the score passes a milestone and when the game ends
+    using ScoreCallback = std::function<void(const Game&, bool finished)>;
     
     class Game {
     private:
+        // Declared first so they outlive every object allocated from them
+        Arena worldArena_;
+        Arena scratchArena_;
+        
         PlayerPtr player_;
         std::map<std::string, RoomPtr> rooms_;
+        std::unique_ptr<WorldPager> pager_;
+        std::string pagerEntrance_;         // Room with a way down into the paged rooms
         std::unique_ptr<CommandParser> parser_;
         bool running_;
         int score_;
         int moves_;
         EnemyPtr currentEnemy_;
         bool inCombat_;
+        std::mt19937 rng_;
+        UndoHistory history_;
+        RuleProgramPtr rules_;
+        std::vector<uint8_t> ruleFlags_;
+        std::vector<RuleEffect> ruleEffects_;   // Not yet part of a recorded delta
+        TriggerRegistry triggerHooks_;
+        std::vector<TriggerCallback> triggerCallbacks_;
+        Lighting lighting_;
+        int darkTurns_;
+        ScoreCallback scoreObserver_;
+        int reportedScore_;
+        std::string output_;
+        std::ostream* out_;
+        const WorldWatcher* worldSource_;
+        uint64_t worldVersion_;
         
+        void applyDelta(const Delta& delta, bool forward);
+        void applyEffect(const RuleEffect& effect, bool forward);
+        void checkGrue();
         void setupWorld();
-        void createRooms();
-        void createItems();
-        void connectRooms();
+        void restoreSnapshot(const WorldSnapshot& snapshot);
+        void releaseWorld();
+        void migrateWorld();
+        void bindEmbeddedWorld(const EmbeddedWorld& world);
+        void connectPager();
         
     public:
         Game();
+        explicit Game(const WorldSnapshot& snapshot);
         ~Game();
         
+        Game(const Game&) = delete;
+        Game& operator=(const Game&) = delete;
+        
         // Getters
-        PlayerPtr getPlayer() const { return player_; }
+        const PlayerPtr& getPlayer() const { return player_; }
         int getScore() const { return score_; }
         int getMoves() const { return moves_; }
         bool isRunning() const { return running_; }
         bool isInCombat() const { return inCombat_; }
-        EnemyPtr getCurrentEnemy() const { return currentEnemy_; }
+        const EnemyPtr& getCurrentEnemy() const { return currentEnemy_; }
         
         // Setters
         void addScore(int points) { score_ += points; }
@@ -48,15 +96,37 @@ namespace Zork {
         void setInCombat(bool combat) { inCombat_ = combat; }
         void setCurrentEnemy(EnemyPtr enemy) { currentEnemy_ = enemy; }
         
+        // Memory
+        Arena& getWorldArena() { return worldArena_; }
+        Arena& getScratchArena() { return scratchArena_; }
+        
         // Room management
         RoomPtr getRoom(const std::string& roomId);
         void addRoom(RoomPtr room);
         
+        // Rooms not in rooms_ are faulted in from the source on demand.
+        // Paged rooms are not part of snapshots. With an entrance, that
+        // room gets a "down" exit to the source's entry room.
+        void enablePaging(std::unique_ptr<RegionSource> source, size_t maxResidentRegions,
+                          const std::string& entrance = "");
+        WorldPager* getPager() const { return pager_.get(); }
+        
+        // Output is collected per command (or batch of pipelined commands)
+        // and written out in one go. With no stream set it is kept for
+        // takeOutput() instead.
+        void print(const std::string& text) { output_ += text; }
+        void setOutput(std::ostream* out) { out_ = out; }
+        void flushOutput();
+        std::string takeOutput();
+        
         // Game flow
         void start();
         void run();
         void displayRoom();
-        void processCommand(const std::string& input);
+        // Returns the result of the last command that ran
+        CommandResult processCommand(const std::string& input);
+        // Same, for input already split and tokenized by parsePipeline
+        CommandResult processCommands(const std::vector<Command>& commands);
         void gameOver(bool victory = false);
         
         // Combat
@@ -64,6 +134,48 @@ namespace Zork {
         void processCombatTurn(const std::string& action);
         void endCombat(bool playerVictory);
         
+        // Lighting
+        bool isRoomLit(const RoomPtr& room);
+        bool setLightOn(const ItemPtr& item, bool on);
+        const Lighting& getLighting() const { return lighting_; }
+        
+        // Interaction rules
+        void setRules(RuleProgramPtr rules);
+        RuleOutcome runRule(const std::string& verb, const std::string& item,
+                            const std::string& with, std::string& message);
+        
+        // Triggers fire after an event ("take", "drop", "examine", "enter")
+        // has happened in the current room. Data-driven triggers come from
+        // the rule program; callbacks are per game and are not cloned.
+        void addTrigger(const std::string& room, const std::string& event,
+                        const std::string& object, TriggerCallback callback);
+        size_t fireTriggers(const std::string& event, const std::string& object, std::string& message);
+        
+        // Leaderboard hook; see ScoreCallback
+        void setScoreObserver(ScoreCallback observer) { scoreObserver_ = std::move(observer); }
+        
+        // Undo/redo. The rule program notes each change it makes, and the
+        // next recorded delta takes them over; commands that only run rules
+        // record a RULE delta. Notes left over at the next command are
+        // dropped.
+        void noteRuleEffect(RuleEffect effect) { ruleEffects_.push_back(std::move(effect)); }
+        bool hasRuleEffects() const { return !ruleEffects_.empty(); }
+        void recordDelta(Delta delta);
+        bool undo(std::string& message);
+        bool redo(std::string& message);
+        
+        // Snapshots
+        SnapshotPtr snapshot() const;
+        std::unique_ptr<Game> clone() const;
+        void reseed(uint32_t seed) { rng_.seed(seed); }
+        
+        // Hot reload: when the source publishes a new template, the game
+        // rebuilds itself from it before the next command and carries the
+        // player's progress across by room id and item name
+        void setWorldSource(const WorldWatcher* source);
+        void exportState(GameState& state) const;
+        void importState(const GameState& state);
+        
         // Save/Load
         bool saveGame(const std::string& filename);
         bool loadGame(const std::string& filename);
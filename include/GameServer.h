@@ -0,0 +1,76 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <string>
+#include "HttpServer.h"
+#include "SessionManager.h"
+#include "ThreadPool.h"
+#include "Leaderboard.h"
+#include "RateLimiter.h"
+#include "AdmissionController.h"
+
+namespace Zork {
+
+    // JSON turn API on top of HttpServer:
+    //   POST   /session               start a game ({"name": "..."} optional)
+    //   POST   /session/{id}/command  run {"command": "..."} (or a text body)
+    //   DELETE /session/{id}          end a game
+    //   GET    /leaderboard?limit=N   best scores
+    //   GET    /leaderboard/{name}    one player's rank
+    //   GET    /health                liveness probe and session counts
+    //   GET    /metrics               load, latency and how much was refused
+    //
+    // Every request but the probes spends a token from its client
+    // address's bucket, and a command spends one per command in its
+    // pipeline from its session's bucket as well; an empty bucket is
+    // answered with 429. A client that has spent more than half of either
+    // bucket is LOW priority to the AdmissionController, which answers with
+    // 503 the work it sheds.
+    class GameServer {
+    private:
+        SessionManager& sessions_;
+        ThreadPool* pool_;
+        Leaderboard* leaderboard_;
+        HttpServer http_;
+        std::atomic<bool> sweeping_;
+        std::chrono::seconds hibernateAfter_;
+        RateLimiter sessionLimiter_;
+        RateLimiter addressLimiter_;
+        AdmissionController admission_;
+
+        void housekeeping();
+        void handle(const HttpRequest& request, const HttpReply& reply);
+        void handleLeaderboard(const HttpRequest& request, HttpResponse& response);
+        // addressLeft is what the address bucket held after handle took
+        // the request's first token
+        void handleCommand(const HttpRequest& request, const HttpReply& reply, const std::string& id,
+                           double addressLeft);
+        std::string metricsJson();
+        static std::string replyJson(const TurnReply& reply, const std::string& sessionId);
+        static void error(HttpResponse& response, int status, const std::string& message);
+
+    public:
+        // Game work (new sessions, turns, hibernation) runs on pool when
+        // given, leaving the HTTP loop to do only I/O
+        explicit GameServer(SessionManager& sessions, ThreadPool* pool = nullptr,
+                            Leaderboard* leaderboard = nullptr);
+
+        // Sessions idle this long are hibernated; 0 keeps them all resident
+        void setHibernateAfter(int seconds);
+
+        // Tokens a second and bucket sizes; a rate of 0 is unlimited. Call
+        // before listen().
+        void setRateLimits(double sessionRate, double sessionBurst, double addressRate, double addressBurst);
+        // Requests waiting on the pool and p99 turn latency past which work
+        // is shed; 0 is unlimited. Call before listen().
+        void setAdmissionLimits(size_t maxInFlight, int maxP99Ms);
+
+        bool listen(const std::string& address, uint16_t port) { return http_.listen(address, port); }
+        void run() { http_.run(); }
+        void stop() { http_.stop(); }
+
+        HttpServer& getHttp() { return http_; }
+    };
+}
+
+#endif // GAMESERVER_H
@@ -0,0 +1,84 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Room.h"
+#include "Item.h"
+#include "Enemy.h"
+
+namespace Zork {
+
+    enum class DeltaType {
+        MOVE,
+        TAKE,
+        DROP,
+        COMBAT,
+        RULE          // use, open, combine or examine, through the rule program
+    };
+
+    // One change a rule or trigger made, with the value it replaced
+    struct RuleEffect {
+        enum class Kind {
+            FLAG,         // ruleFlags[flag]
+            LIT,          // room lit
+            LOCKED,       // room locked
+            CONSUMED,     // item gone from the inventory
+            LIGHT         // light source item switched on
+        };
+
+        Kind kind;
+        uint16_t flag;
+        RoomPtr room;
+        ItemPtr item;
+        bool before;
+        bool after;
+    };
+
+    // Reversible record of what a single command changed. Only the fields
+    // relevant to the delta type are set.
+    struct Delta {
+        DeltaType type;
+        RoomPtr fromRoom;
+        RoomPtr toRoom;       // MOVE destination; TAKE/DROP room
+        ItemPtr item;
+        EnemyPtr enemy;
+        bool firstVisit;
+        bool wasInCombat;
+        int scoreDelta;
+        int movesDelta;
+        std::vector<RuleEffect> effects;    // Made by rules and triggers, in order
+
+        Delta(DeltaType t = DeltaType::MOVE)
+            : type(t), firstVisit(false), wasInCombat(false),
+              scoreDelta(0), movesDelta(0) {}
+    };
+
+    // Fixed-capacity ring of deltas with an undo cursor. Recording a new
+    // delta discards anything that could have been redone; once full, the
+    // oldest delta is overwritten.
+    class UndoHistory {
+    private:
+        std::vector<Delta> ring_;
+        size_t head_;     // Oldest stored delta
+        size_t size_;     // Stored deltas
+        size_t cursor_;   // Deltas currently applied (undoable)
+
+        size_t slot(size_t offset) const { return (head_ + offset) % ring_.size(); }
+
+    public:
+        explicit UndoHistory(size_t capacity);
+
+        void record(Delta delta);
+        const Delta* undo();
+        const Delta* redo();
+        void clear();
+
+        size_t getCapacity() const { return ring_.size(); }
+        size_t getUndoCount() const { return cursor_; }
+        size_t getRedoCount() const { return size_ - cursor_; }
+    };
+}
+
+#endif // HISTORY_H
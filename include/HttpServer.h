@@ -0,0 +1,163 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "RingQueue.h"
+
+namespace Zork {
+
+    struct HttpRequest {
+        std::string method;
+        std::string path;
+        std::string query;      // After '?', undecoded
+        std::string body;
+        std::string peer;       // Client address, as text
+        bool keepAlive;
+
+        HttpRequest() : keepAlive(true) {}
+    };
+
+    struct HttpResponse {
+        int status;
+        std::string contentType;
+        std::string body;
+
+        HttpResponse() : status(200), contentType("application/json") {}
+    };
+
+    class HttpServer;
+
+    // Answers one request. It may be kept and used later from any thread;
+    // send() must be called exactly once.
+    class HttpReply {
+    private:
+        HttpServer* server_;
+        int fd_;
+        uint64_t connection_;
+        uint64_t sequence_;
+
+    public:
+        HttpReply(HttpServer* server, int fd, uint64_t connection, uint64_t sequence)
+            : server_(server), fd_(fd), connection_(connection), sequence_(sequence) {}
+
+        void send(HttpResponse response) const;
+    };
+
+    using HttpHandler = std::function<void(const HttpRequest&, HttpReply)>;
+
+    // Minimal HTTP/1.1 server on a single epoll loop. Connections are kept
+    // alive by default and may pipeline requests; handlers may answer
+    // asynchronously, and responses still go out in request order. Only
+    // what the game API needs is supported: no chunked bodies, no TLS, no
+    // request bodies over MAX_REQUEST_SIZE.
+    class HttpServer {
+    private:
+        friend class HttpReply;
+
+        // A response slot, in request order
+        struct Pending {
+            std::string bytes;
+            bool done;
+            bool close;       // Connection: close once this is sent
+
+            Pending() : done(false), close(false) {}
+        };
+
+        struct Connection {
+            uint64_t id;      // fds are reused; ids are not
+            std::string peer;
+            std::string in;
+            std::string out;
+            size_t written;
+            bool closeAfterWrite;
+            bool watchingRead;    // EPOLLIN is registered
+            bool watchingWrite;   // EPOLLOUT is registered
+            std::deque<Pending> pending;
+            uint64_t firstSequence;   // Sequence number of pending.front()
+
+            Connection()
+                : id(0), written(0), closeAfterWrite(false), watchingRead(true),
+                  watchingWrite(false), firstSequence(0) {}
+        };
+
+        // A response finished off the loop thread
+        struct Completion {
+            int fd;
+            uint64_t connection;
+            uint64_t sequence;
+            HttpResponse response;
+
+            Completion() : fd(-1), connection(0), sequence(0) {}
+        };
+
+        HttpHandler handler_;
+        std::function<void()> idleCallback_;
+        std::chrono::milliseconds idleInterval_;
+        int listenFd_;
+        int epollFd_;
+        int wakeFd_;
+        uint16_t port_;
+        std::atomic<bool> stopping_;
+        std::unordered_map<int, Connection> connections_;
+        uint64_t nextConnectionId_;
+        std::thread::id loopThread_;
+        RingQueue<Completion> completions_;   // Workers to the loop thread
+        std::atomic<bool> wakePending_;        // An eventfd write is on its way
+        std::atomic<uint64_t> requests_;
+        std::string error_;
+
+        bool fail(const std::string& message);
+        void acceptConnections();
+        void closeConnection(int fd);
+        void readConnection(int fd);
+        void writeConnection(int fd);
+        void updateInterest(int fd, Connection& connection);
+        void drainCompletions();
+
+        // Fills a response slot and moves every finished slot at the front
+        // into the output buffer
+        void complete(int fd, uint64_t connection, uint64_t sequence, const HttpResponse& response);
+        void flushReady(Connection& connection);
+
+        // Parses every complete request in `in`; returns false when the
+        // connection must be dropped after what was already answered
+        bool processInput(int fd, Connection& connection);
+
+    public:
+        static const size_t MAX_REQUEST_SIZE = 64 * 1024;
+        static const size_t MAX_IN_FLIGHT = 64;   // Per connection; reading pauses beyond this
+
+        explicit HttpServer(HttpHandler handler);
+        ~HttpServer();
+
+        HttpServer(const HttpServer&) = delete;
+        HttpServer& operator=(const HttpServer&) = delete;
+
+        // Binds and listens; port 0 picks a free port (see getPort)
+        bool listen(const std::string& address, uint16_t port);
+
+        // Runs callback on the loop thread about every intervalMs, between
+        // batches of events; used for housekeeping such as hibernation
+        void setIdleCallback(std::function<void()> callback, int intervalMs);
+
+        // Serves until stop() is called from another thread
+        void run();
+        void stop();
+
+        uint16_t getPort() const { return port_; }
+        uint64_t getRequestCount() const { return requests_.load(std::memory_order_relaxed); }
+        const std::string& getError() const { return error_; }
+
+        static const char* statusText(int status);
+    };
+}
+
+#endif // HTTPSERVER_H
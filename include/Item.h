@@ -25,6 +25,10 @@ namespace Zork {
         int value_;
         int damage_;  // For weapons
         int defense_; // For armor
+        bool lightSource_;
+        bool lightOn_;
+        int fuel_;        // Turns of light left; negative means it never runs out
+        int lightRadius_; // 0 lights the room it is in, 1 also the rooms next door
         
     public:
         Item(const std::string& name, 
@@ -34,19 +38,28 @@ namespace Zork {
              ItemType type = ItemType::MISC);
         
         // Getters
-        std::string getName() const { return name_; }
-        std::string getDescription() const { return description_; }
+        const std::string& getName() const { return name_; }
+        const std::string& getDescription() const { return description_; }
         int getWeight() const { return weight_; }
         bool isTakeable() const { return takeable_; }
         ItemType getType() const { return type_; }
         int getValue() const { return value_; }
         int getDamage() const { return damage_; }
         int getDefense() const { return defense_; }
+        bool isLightSource() const { return lightSource_; }
+        bool isLightOn() const { return lightOn_; }
+        int getFuel() const { return fuel_; }
+        int getLightRadius() const { return lightRadius_; }
+        bool isEmittingLight() const { return lightSource_ && lightOn_ && fuel_ != 0; }
         
         // Setters
         void setValue(int value) { value_ = value; }
         void setDamage(int damage) { damage_ = damage; }
         void setDefense(int defense) { defense_ = defense; }
+        void setLightSource(bool source) { lightSource_ = source; }
+        void setLightOn(bool on) { lightOn_ = on; }
+        void setFuel(int fuel) { fuel_ = fuel; }
+        void setLightRadius(int radius) { lightRadius_ = radius; }
         
         // Methods
         std::string getTypeString() const;
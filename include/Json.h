@@ -0,0 +1,76 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+
+namespace Zork {
+
+    class JsonValue;
+
+    // Receives one element of a top-level array: the member's key, the
+    // element's position and the element itself; false stops the parse
+    using JsonElementCallback = std::function<bool(const std::string& key, size_t index, const JsonValue& element)>;
+
+    // Minimal JSON document model, enough for the game data files.
+    // Missing keys and out-of-range indices yield a shared null value, so
+    // lookups can be chained without checks.
+    class JsonValue {
+    public:
+        enum class Type {
+            NUL,
+            BOOL,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT
+        };
+
+    private:
+        Type type_;
+        bool bool_;
+        double number_;
+        std::string string_;
+        std::vector<JsonValue> array_;
+        std::vector<std::pair<std::string, JsonValue>> object_;
+
+        friend class JsonParser;
+
+    public:
+        JsonValue() : type_(Type::NUL), bool_(false), number_(0) {}
+
+        static bool parse(const std::string& text, JsonValue& out, std::string& error);
+
+        // For documents too large to hold as a tree: text must be an object,
+        // and each array member is handed to onElement one element at a
+        // time instead of being stored (out keeps it as an empty array).
+        // Other members end up in out as usual.
+        static bool parseStreaming(const std::string& text, JsonValue& out,
+                                   const JsonElementCallback& onElement, std::string& error);
+
+        Type getType() const { return type_; }
+        bool isNull() const { return type_ == Type::NUL; }
+        bool isObject() const { return type_ == Type::OBJECT; }
+        bool isArray() const { return type_ == Type::ARRAY; }
+        bool isString() const { return type_ == Type::STRING; }
+        bool isNumber() const { return type_ == Type::NUMBER; }
+        bool isBool() const { return type_ == Type::BOOL; }
+
+        size_t size() const;
+        bool has(const std::string& key) const;
+        const JsonValue& operator[](const std::string& key) const;
+        const JsonValue& operator[](size_t index) const;
+        const std::vector<std::pair<std::string, JsonValue>>& members() const { return object_; }
+
+        std::string asString(const std::string& fallback = "") const;
+        int asInt(int fallback = 0) const;
+        double asNumber(double fallback = 0) const;
+        bool asBool(bool fallback = false) const;
+
+        static std::string escape(const std::string& text);
+    };
+}
+
+#endif // JSON_H
@@ -0,0 +1,135 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <atomic>
+#include "RingQueue.h"
+
+namespace Zork {
+
+    struct LeaderboardEntry {
+        std::string player;
+        int score;
+        int moves;
+
+        LeaderboardEntry() : score(0), moves(0) {}
+        LeaderboardEntry(const std::string& p, int s, int m) : player(p), score(s), moves(m) {}
+    };
+
+    // Indexable skip list ordered best first: higher score, then fewer
+    // moves, then player name. Every link records how many entries it
+    // skips, so rank and position lookups are O(log n) like search.
+    class RankedSkipList {
+    private:
+        static const int MAX_LEVEL = 32;
+
+        struct Node;
+        struct Link {
+            Node* next;
+            size_t width;   // Entries passed by following this link
+        };
+        struct Node {
+            LeaderboardEntry entry;
+            std::vector<Link> links;
+        };
+
+        Node head_;
+        int level_;
+        size_t size_;
+        std::mt19937 rng_;
+
+        int randomLevel();
+
+    public:
+        RankedSkipList();
+        ~RankedSkipList();
+
+        RankedSkipList(const RankedSkipList&) = delete;
+        RankedSkipList& operator=(const RankedSkipList&) = delete;
+
+        // True if a ranks ahead of b
+        static bool before(const LeaderboardEntry& a, const LeaderboardEntry& b);
+
+        void insert(const LeaderboardEntry& entry);
+        bool erase(const LeaderboardEntry& entry);
+
+        // 1-based position of an entry that is in the list, 0 if it is not
+        size_t rankOf(const LeaderboardEntry& entry) const;
+
+        // Up to count entries starting at 0-based position first
+        void range(size_t first, size_t count, std::vector<LeaderboardEntry>& out) const;
+
+        size_t size() const { return size_; }
+    };
+
+    // Global best-score table shared by every session. Games never wait on
+    // it: record() only pushes onto a lock-free ring, and a writer thread
+    // applies updates in batches and appends them to a write-ahead log in
+    // the saves directory, synced once per batch. Queries take a shared
+    // lock and run concurrently. On start the log is replayed, skipping
+    // lines whose checksum fails and cutting off a torn last line; it is
+    // rewritten compactly once it grows well past the number of players.
+    class Leaderboard {
+    private:
+        RankedSkipList list_;
+        std::unordered_map<std::string, LeaderboardEntry> best_;   // Player -> current entry
+        mutable std::shared_mutex mutex_;
+
+        RingQueue<LeaderboardEntry> updates_;
+        std::atomic<bool> wakePending_;
+        std::atomic<uint64_t> queued_;
+        uint64_t applied_;   // Writer thread only, published under wakeMutex_
+        std::mutex wakeMutex_;
+        std::condition_variable wake_;
+        std::condition_variable appliedSignal_;
+        bool stopping_;
+        std::thread writer_;
+
+        std::string logPath_;
+        int logFd_;
+        size_t logRecords_;
+
+        // Applies an update if it beats the player's current entry;
+        // called with mutex_ held exclusively
+        bool apply(const LeaderboardEntry& entry);
+        void replay();
+        void compact();
+        void writerLoop();
+
+    public:
+        static constexpr size_t UPDATE_QUEUE_DEPTH = 8192;
+        static constexpr size_t BATCH_SIZE = 256;
+        static constexpr size_t COMPACT_MIN_RECORDS = 4096;
+
+        // Keeps its log in directory (created if missing); an empty
+        // directory keeps the board in memory only
+        explicit Leaderboard(const std::string& directory);
+        ~Leaderboard();
+
+        Leaderboard(const Leaderboard&) = delete;
+        Leaderboard& operator=(const Leaderboard&) = delete;
+
+        // Queues a result; only kept if it is the player's best so far
+        void record(const std::string& player, int score, int moves);
+
+        // Blocks until everything recorded before the call is applied
+        void sync();
+
+        std::vector<LeaderboardEntry> top(size_t count) const;
+
+        // 1-based rank of the player's best entry; false if unknown
+        bool rank(const std::string& player, size_t& position, LeaderboardEntry& entry) const;
+
+        size_t size() const;
+    };
+}
+
+#endif // LEADERBOARD_H
@@ -0,0 +1,52 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Room.h"
+#include "Player.h"
+
+namespace Zork {
+
+    // Decides whether a room can be seen in. A room is lit by its ambient
+    // light, by a light source lying in it or carried there, or by a radiant
+    // source (radius 1) in a room its exits lead to. Results are cached on
+    // each Room and only recomputed after the room was invalidated (a light
+    // source moved or changed) or the whole cache was dropped.
+    class Lighting {
+    private:
+        uint32_t epoch_;                // Never 0; Room uses 0 for "stale"
+        std::vector<ItemPtr> burning_;  // Lit sources with finite fuel
+        size_t recomputes_;
+
+        bool compute(const Room& room, const Player* player) const;
+        void untrack(const ItemPtr& item);
+
+    public:
+        Lighting();
+
+        bool isLit(Room& room, const Player* player);
+
+        // Drops every cached value, e.g. after a source went out somewhere
+        // we cannot see
+        void invalidateAll();
+
+        // `where` is the room the item is in or carried in, if known
+        bool setLightOn(const ItemPtr& item, bool on, Room* where);
+
+        // Call after a world rebuild so fuel keeps burning for sources that
+        // arrived already lit
+        void track(const ItemPtr& item);
+        void clear();
+
+        // Burns one turn of fuel from every lit source and reports what the
+        // player can notice
+        void tick(const Player& player, std::string& message);
+
+        size_t getBurningCount() const { return burning_.size(); }
+        size_t getRecomputes() const { return recomputes_; }
+    };
+}
+
+#endif // LIGHTING_H
@@ -0,0 +1,64 @@
+#ifndef MEMORYACCOUNT_H
+#define MEMORYACCOUNT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Zork {
+
+    class MemoryAccount;
+
+    struct MemoryAccountRelease {
+        void operator()(MemoryAccount* account) const;
+    };
+
+    using MemoryAccountPtr = std::unique_ptr<MemoryAccount, MemoryAccountRelease>;
+
+    // Heap bytes attributed to one owner, such as a server session. The
+    // global operator new is replaced: while a Scope is active on a thread,
+    // every allocation made there is charged to its account, and the block
+    // remembers which account it belongs to, so freeing it on any thread
+    // credits the right one. An account lives until both its owner and its
+    // last block are gone.
+    class MemoryAccount {
+    private:
+        std::atomic<size_t> bytes_;
+        std::atomic<size_t> references_;   // The owner's handle plus live blocks
+        std::atomic<uint64_t> allocations_;
+
+        MemoryAccount() : bytes_(0), references_(1), allocations_(0) {}
+
+    public:
+        static MemoryAccountPtr create();
+
+        // Called by the allocation hooks
+        void charge(size_t bytes);
+        void credit(size_t bytes);
+        void release();
+
+        size_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+        // Blocks ever charged, freed or not; counts allocations per operation
+        uint64_t allocations() const { return allocations_.load(std::memory_order_relaxed); }
+
+        // Everything currently charged to any account
+        static size_t totalBytes();
+
+        // Charges this thread's allocations to account (or to nobody when
+        // null) until destroyed; scopes nest
+        class Scope {
+        private:
+            MemoryAccount* previous_;
+
+        public:
+            explicit Scope(MemoryAccount* account);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        };
+    };
+}
+
+#endif // MEMORYACCOUNT_H
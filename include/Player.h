@@ -4,11 +4,14 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 #include "Room.h"
 #include "Item.h"
 
 namespace Zork {
     
+    using RoomResolver = std::function<RoomPtr(const std::string&)>;
+    
     class Player {
     private:
         std::string name_;
@@ -21,24 +24,30 @@ namespace Zork {
         int maxHealth_;
         int attackPower_;
         int defense_;
+        RoomResolver resolver_;
+        
+        void enterRoom(RoomPtr room);
         
     public:
         Player(const std::string& name, RoomPtr startingRoom);
         
         // Getters
-        std::string getName() const { return name_; }
-        RoomPtr getCurrentRoom() const { return currentRoom_; }
+        const std::string& getName() const { return name_; }
+        const RoomPtr& getCurrentRoom() const { return currentRoom_; }
         int getHealth() const { return health_; }
         int getMaxHealth() const { return maxHealth_; }
         int getAttackPower() const { return attackPower_; }
         int getDefense() const { return defense_; }
         int getCurrentWeight() const { return currentWeight_; }
         int getMaxCarryWeight() const { return maxCarryWeight_; }
-        std::vector<ItemPtr> getInventory() const { return inventory_; }
+        const std::vector<ItemPtr>& getInventory() const { return inventory_; }
         
         // Setters
-        void setCurrentRoom(RoomPtr room) { currentRoom_ = room; }
+        void setName(const std::string& name) { name_ = name; }
+        void setCurrentRoom(RoomPtr room) { enterRoom(std::move(room)); }
+        void setRoomResolver(RoomResolver resolver) { resolver_ = std::move(resolver); }
         void setHealth(int health) { health_ = health; }
+        void setInventory(std::vector<ItemPtr> items);
         void modifyHealth(int amount);
         
         // Movement
@@ -48,9 +57,12 @@ namespace Zork {
         bool takeItem(ItemPtr item, std::string& message);
         bool dropItem(const std::string& itemName, std::string& message);
         bool hasItem(const std::string& itemName) const;
+        void addInventoryItem(ItemPtr item);
+        bool removeInventoryItem(const ItemPtr& item);
         ItemPtr getInventoryItem(const std::string& itemName);
         int getInventorySize() const { return inventory_.size(); }
         bool canCarry(int weight) const;
+        bool carriesLight(int minRadius) const;
         
         // Combat
         int attack();
@@ -0,0 +1,59 @@
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Zork {
+
+    // Token buckets by key (a session id, a client address). Each key may
+    // spend up to burst tokens at once and earns rate tokens a second back.
+    // Buckets are created on first use and sharded like RenderCache;
+    // prune() forgets the ones that have refilled, since a full bucket is
+    // the same as none. A rate of 0 lets everything through.
+    class RateLimiter {
+    private:
+        static const size_t SHARD_COUNT = 16;
+
+        struct Bucket {
+            double tokens;
+            std::chrono::steady_clock::time_point refilled;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, Bucket> buckets;
+        };
+
+        Shard shards_[SHARD_COUNT];
+        double rate_;
+        double burst_;
+        std::atomic<uint64_t> rejected_;
+
+        Shard& shardFor(const std::string& key);
+        void refill(Bucket& bucket, std::chrono::steady_clock::time_point now) const;
+
+    public:
+        RateLimiter(double rate, double burst);
+
+        // Before first use
+        void configure(double rate, double burst);
+
+        // Takes cost tokens from key's bucket if it has them. left is what
+        // the bucket holds afterwards, as a fraction of burst.
+        bool tryAcquire(const std::string& key, double cost, double& left);
+
+        // Drops full buckets; returns how many are left
+        size_t prune();
+
+        bool enabled() const { return rate_ > 0; }
+        double getBurst() const { return burst_; }
+        uint64_t getRejected() const { return rejected_.load(std::memory_order_relaxed); }
+    };
+}
+
+#endif // RATELIMITER_H
@@ -0,0 +1,56 @@
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Zork {
+
+    using RenderPtr = std::shared_ptr<const std::string>;
+
+    // Process-wide store of rendered room text, keyed by everything the text
+    // depends on. Sessions stamped from the same world render identical
+    // rooms, so they end up holding the same immutable string. Sharded to
+    // keep lock hold times short; a full shard is simply emptied, since
+    // rooms keep their own reference to whatever they last rendered.
+    class RenderCache {
+    private:
+        static const size_t SHARD_COUNT = 16;
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, RenderPtr> entries;
+        };
+
+        Shard shards_[SHARD_COUNT];
+        size_t maxEntriesPerShard_;
+        std::atomic<uint64_t> hits_;
+        std::atomic<uint64_t> misses_;
+
+        Shard& shardFor(const std::string& key);
+
+    public:
+        explicit RenderCache(size_t maxEntriesPerShard = 1024);
+
+        static RenderCache& instance();
+
+        RenderPtr find(const std::string& key);
+
+        // Returns the entry that ended up in the cache, which is an earlier
+        // identical render if another thread got there first. The entry is
+        // copied outside any session's memory account.
+        RenderPtr insert(const std::string& key, std::string_view text);
+
+        void clear();
+        size_t size();
+        uint64_t getHits() const { return hits_.load(std::memory_order_relaxed); }
+        uint64_t getMisses() const { return misses_.load(std::memory_order_relaxed); }
+    };
+}
+
+#endif // RENDERCACHE_H
@@ -0,0 +1,97 @@
+#ifndef RINGQUEUE_H
+#define RINGQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace Zork {
+
+    // Bounded lock-free multi-producer, single-consumer ring. Every cell
+    // carries a sequence number: producers claim a position with one CAS on
+    // the tail and publish by bumping the cell's sequence; the consumer
+    // reads the head without any atomic read-modify-write. A full ring
+    // refuses the push, so callers decide how to push back.
+    //
+    // Only one thread may pop at a time. Handing the consumer role between
+    // threads is fine as long as the handover itself synchronizes.
+    template <typename T>
+    class RingQueue {
+    private:
+        static const size_t CACHE_LINE = 64;
+
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_;
+        alignas(CACHE_LINE) std::atomic<size_t> tail_;   // Next position to claim
+        alignas(CACHE_LINE) size_t head_;                // Next position to read
+
+        static size_t roundUp(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            return size;
+        }
+
+    public:
+        // Capacity is rounded up to a power of two
+        explicit RingQueue(size_t capacity)
+            : cells_(new Cell[roundUp(capacity)]), mask_(roundUp(capacity) - 1), tail_(0), head_(0) {
+            for (size_t i = 0; i <= mask_; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        RingQueue(const RingQueue&) = delete;
+        RingQueue& operator=(const RingQueue&) = delete;
+
+        // False when the ring is full; value is left untouched then
+        bool tryPush(T&& value) {
+            size_t position = tail_.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &cells_[position & mask_];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (lag == 0) {
+                    if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (lag < 0) {
+                    return false;   // The consumer has not freed this cell yet
+                } else {
+                    position = tail_.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = std::move(value);
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // False when empty, or when the next cell is claimed but its
+        // producer has not finished writing it
+        bool tryPop(T& value) {
+            Cell& cell = cells_[head_ & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence != head_ + 1) {
+                return false;
+            }
+            value = std::move(cell.value);
+            cell.value = T();
+            cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+            ++head_;
+            return true;
+        }
+
+        size_t capacity() const { return mask_ + 1; }
+    };
+}
+
+#endif // RINGQUEUE_H
@@ -5,7 +5,10 @@
 #include <map>
 #include <vector>
 #include <memory>
+#include <memory_resource>
+#include <cstdint>
 #include "Item.h"
+#include "RenderCache.h"
 
 namespace Zork {
     
@@ -15,10 +18,23 @@ namespace Zork {
         std::string name_;
         std::string description_;
         std::map<std::string, std::shared_ptr<Room>> exits_;
+        std::map<std::string, std::string> remoteExits_; // Resolved by id on demand
         std::vector<ItemPtr> items_;
+        std::vector<std::string> occupants_;   // Players here, in shared mode
         bool visited_;
-        bool lit_;
+        bool lit_;              // Ambient light, regardless of what is in the room
         bool locked_;
+        uint32_t lightEpoch_;   // Lighting epoch litCache_ belongs to; 0 means stale
+        bool litCache_;
+        
+        // Bumped by anything that changes what render() would produce
+        uint64_t version_;
+        size_t textHash_;
+        mutable RenderPtr render_;
+        mutable uint64_t renderVersion_;
+        mutable bool renderLit_;
+        
+        std::string renderKey(bool lit) const;
         
     public:
         Room(const std::string& id,
@@ -26,16 +42,16 @@ namespace Zork {
              const std::string& description);
         
         // Getters
-        std::string getId() const { return id_; }
-        std::string getName() const { return name_; }
-        std::string getDescription() const { return description_; }
+        const std::string& getId() const { return id_; }
+        const std::string& getName() const { return name_; }
+        const std::string& getDescription() const { return description_; }
         bool isVisited() const { return visited_; }
         bool isLit() const { return lit_; }
         bool isLocked() const { return locked_; }
         
         // Setters
         void setVisited(bool visited) { visited_ = visited; }
-        void setLit(bool lit) { lit_ = lit; }
+        void setLit(bool lit) { lit_ = lit; ++version_; invalidateLight(false); }
         void setLocked(bool locked) { locked_ = locked; }
         
         // Exit management
@@ -43,17 +59,41 @@ namespace Zork {
         std::shared_ptr<Room> getExit(const std::string& direction);
         std::vector<std::string> getExits() const;
         bool hasExit(const std::string& direction) const;
+        void clearExits() { exits_.clear(); ++version_; }
+        void addRemoteExit(const std::string& direction, const std::string& roomId);
+        std::string getRemoteExit(const std::string& direction) const;
         
         // Item management
         void addItem(ItemPtr item);
         ItemPtr removeItem(const std::string& itemName);
+        bool removeItem(const ItemPtr& item);
         ItemPtr getItem(const std::string& itemName);
-        std::vector<ItemPtr> getItems() const { return items_; }
+        const std::vector<ItemPtr>& getItems() const { return items_; }
         bool hasItem(const std::string& itemName) const;
         
-        // Display
+        // Occupants, in order of arrival. Not part of render(), so people
+        // coming and going never invalidate the shared room text.
+        void addOccupant(const std::string& name) { occupants_.push_back(name); }
+        bool removeOccupant(const std::string& name);
+        const std::vector<std::string>& getOccupants() const { return occupants_; }
+        
+        // Lighting cache, maintained by Lighting. Light sources moving in or
+        // out mark the room (and, for radiant sources, its neighbours) stale.
+        void invalidateLight(bool neighbours);
+        bool getCachedLight(uint32_t epoch, bool& lit) const;
+        void cacheLight(uint32_t epoch, bool lit) { lightEpoch_ = epoch; litCache_ = lit; }
+        bool hasLightSource(int minRadius) const;
+        const std::map<std::string, std::shared_ptr<Room>>& getExitRooms() const { return exits_; }
+        
+        // Display. render() returns the full room text (header, description,
+        // items and exits) and reuses the previous text until the room
+        // changes; identical rooms in other sessions share the same string.
+        uint64_t getVersion() const { return version_; }
+        RenderPtr render(bool lit) const;
         std::string getFullDescription() const;
         std::string getItemsList() const;
+        void appendFullDescription(std::pmr::string& out, bool lit) const;
+        void appendItemsList(std::pmr::string& out) const;
     };
     
     using RoomPtr = std::shared_ptr<Room>;
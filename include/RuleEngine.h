@@ -0,0 +1,118 @@
+#ifndef RULEENGINE_H
+#define RULEENGINE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "Json.h"
+#include "Triggers.h"
+
+namespace Zork {
+
+    class Game; // Forward declaration
+
+    // One-accumulator bytecode: each condition overwrites acc, and the
+    // jump that follows it tests acc
+    enum class RuleOp : uint8_t {
+        HOLDING,      // acc = player carries items[arg]
+        HERE,         // acc = items[arg] lies in the current room
+        IN_ROOM,      // acc = current room is rooms[arg]
+        FLAG,         // acc = flags[arg]
+        BURNING,      // acc = items[arg], held or here, gives off light (imm 1: has fuel)
+        NOT,          // acc = !acc
+        JUMP_IF_ZERO, // if (!acc) pc = imm
+        FAIL,         // stop; the command fails with strings[arg]
+        SAY,          // append strings[arg] to the reply
+        SET_FLAG,     // flags[arg] = imm
+        SET_LIT,      // rooms[arg] (or the current room) lit = imm
+        SET_LOCKED,   // rooms[arg] (or the current room) locked = imm
+        ADD_SCORE,    // score += imm
+        CONSUME,      // remove items[arg] from the inventory
+        LIGHT,        // switch light source items[arg] (held or here) on = imm
+        NO_MATCH,     // no rule applied; caller falls back to default handling
+        HALT,         // stop; the command succeeds
+        COUNT
+    };
+
+    struct RuleInstruction {
+        RuleOp op;
+        uint16_t arg;
+        int32_t imm;
+    };
+
+    enum class RuleOutcome {
+        NO_RULE,
+        SUCCESS,
+        FAILURE
+    };
+
+    // Compiled, immutable set of interaction rules. One program is shared
+    // by every session playing the same world; per-session flag values are
+    // passed in by the caller.
+    class RuleProgram {
+    private:
+        std::vector<RuleInstruction> code_;
+        std::vector<const void*> threaded_;   // Handler address per instruction
+        std::vector<std::string> strings_;
+        std::vector<std::string> items_;      // Lower-cased names
+        std::vector<std::string> rooms_;
+        std::vector<std::string> flags_;
+        std::unordered_map<std::string, uint32_t> entries_;
+        TriggerRegistry triggers_;            // (room, event, item) -> entry pc
+
+        friend class RuleCompiler;
+
+        // With threadOut set, only translates code_ into handler addresses
+        static RuleOutcome interpret(const RuleProgram& program, uint32_t pc, Game* game,
+                                     std::vector<uint8_t>* flags, std::string* message,
+                                     std::vector<const void*>* threadOut);
+
+    public:
+        static const uint16_t CURRENT_ROOM = 0xFFFF;
+
+        static std::string entryKey(const std::string& verb, const std::string& item,
+                                    const std::string& with);
+
+        RuleOutcome execute(Game& game, std::vector<uint8_t>& flags,
+                            const std::string& verb, const std::string& item,
+                            const std::string& with, std::string& message) const;
+
+        // Runs every trigger on the most specific matching key; returns how
+        // many matched
+        size_t fireTriggers(Game& game, std::vector<uint8_t>& flags, const std::string& room,
+                            const std::string& event, const std::string& object,
+                            std::string& message) const;
+
+        size_t getFlagCount() const { return flags_.size(); }
+        const std::string& getFlagName(size_t index) const { return flags_[index]; }
+        int findFlag(const std::string& name) const;
+        size_t getCodeSize() const { return code_.size(); }
+        size_t getTriggerCount() const { return triggers_.size(); }
+    };
+
+    using RuleProgramPtr = std::shared_ptr<const RuleProgram>;
+
+    // Turns the "rules" array of rules.json into a RuleProgram. Rules that
+    // share a (verb, item, with) key are chained in file order; a rule whose
+    // room does not match falls through to the next one. Entries of the
+    // "triggers" array fire after take, drop, examine and enter succeed.
+    class RuleCompiler {
+    private:
+        std::string error_;
+
+        uint16_t intern(std::vector<std::string>& table, const std::string& value);
+        bool fail(const std::string& message);
+
+    public:
+        bool compile(const JsonValue& document, RuleProgram& program);
+        // name labels parse errors
+        RuleProgramPtr loadText(const std::string& text, const std::string& name);
+        RuleProgramPtr loadFile(const std::string& path);
+
+        const std::string& getError() const { return error_; }
+    };
+}
+
+#endif // RULEENGINE_H
@@ -4,8 +4,10 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <mutex>
 #include "Player.h"
 #include "Room.h"
+#include "SaveStore.h"
 
 namespace Zork {
     
@@ -15,6 +17,8 @@ namespace Zork {
         std::vector<std::string> inventory;
         std::map<std::string, bool> visitedRooms;
         std::map<std::string, std::vector<std::string>> roomItems;
+        std::vector<std::string> flags;
+        std::map<std::string, std::pair<bool, int>> lights; // Light source name -> (on, fuel)
         int score;
         int moves;
         int health;
@@ -22,12 +26,19 @@ namespace Zork {
         GameState() : score(0), moves(0), health(100) {}
     };
     
+    // Saves live as records in a SaveStore in the save directory rather
+    // than one file each; a "filename" is just the record's key. The store
+    // is opened on first use, so a SaveManager made only to ask for the
+    // directory never touches it.
     class SaveManager {
     private:
         std::string saveDirectory_;
+        std::unique_ptr<SaveStore> store_;
+        std::mutex storeMutex_;
         
         std::string serializeGameState(const GameState& state);
         GameState deserializeGameState(const std::string& data);
+        SaveStore& store();
         
     public:
         SaveManager();
@@ -36,9 +47,11 @@ namespace Zork {
         bool load(GameState& state, const std::string& filename);
         std::vector<std::string> listSaveFiles();
         bool deleteSave(const std::string& filename);
+        // Opens the store if need be; false with the reason if it cannot
+        bool isOpen(std::string& error);
         
-        std::string getSaveDirectory() const { return saveDirectory_; }
-        void setSaveDirectory(const std::string& dir) { saveDirectory_ = dir; }
+        const std::string& getSaveDirectory() const { return saveDirectory_; }
+        void setSaveDirectory(const std::string& dir);
     };
 }
 
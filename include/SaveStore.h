@@ -0,0 +1,101 @@
+#ifndef SAVESTORE_H
+#define SAVESTORE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+
+namespace Zork {
+
+    // Log-structured key/value store for saves. Every write appends a
+    // CRC-checked record to the active segment file; an in-memory hash index
+    // maps each key to its latest record, so reads are one pread and
+    // listing or deleting never scans the directory. Segments roll over at
+    // SEGMENT_BYTES. Once stale versions make up most of the sealed
+    // segments, a background thread copies their live records forward,
+    // syncs the copies and only then removes them.
+    //
+    // On open, segments are replayed in order; a torn record at the end of
+    // the newest one is cut off. Only one store may own a directory: the
+    // first takes an exclusive lock on it, and any other fails to open.
+    class SaveStore {
+    private:
+        struct Segment {
+            uint64_t id;
+            int fd;
+            uint64_t size;
+            uint64_t liveBytes;
+
+            Segment(uint64_t i, int f) : id(i), fd(f), size(0), liveBytes(0) {}
+            ~Segment();
+        };
+        using SegmentPtr = std::shared_ptr<Segment>;
+
+        struct Location {
+            SegmentPtr segment;
+            uint64_t offset;
+            uint32_t length;     // Whole record, header included
+        };
+
+        std::string directory_;
+        int lockFd_;                                 // Holds the directory lock
+        std::map<uint64_t, SegmentPtr> segments_;   // By id; the last one is active
+        std::unordered_map<std::string, Location> index_;
+        uint64_t sealedBytes_;
+        uint64_t sealedLive_;
+        std::string error_;
+        mutable std::mutex mutex_;
+
+        std::condition_variable wake_;
+        bool compactPending_;
+        bool stopping_;
+        std::thread compactor_;
+
+        std::string segmentPath(uint64_t id) const;
+        bool openSegment(uint64_t id, bool create);
+        // newest: the last segment on disk, whose torn tail may be cut off
+        void replay(Segment& segment, bool newest);
+
+        // Called with mutex_ held
+        bool append(const std::string& key, const std::string* value, Location& where);
+        void release(const Location& where);
+        bool wantsCompaction() const;
+
+        void compactorLoop();
+
+    public:
+        static constexpr uint64_t SEGMENT_BYTES = 8 * 1024 * 1024;
+        static constexpr uint64_t COMPACT_MIN_BYTES = 1024 * 1024;
+
+        explicit SaveStore(const std::string& directory);
+        ~SaveStore();
+
+        SaveStore(const SaveStore&) = delete;
+        SaveStore& operator=(const SaveStore&) = delete;
+
+        // False if the directory could not be opened or another store holds
+        // it; see getError(), which also reports corrupt data skipped on open
+        bool isOpen() const;
+        const std::string& getError() const { return error_; }
+
+        bool put(const std::string& key, const std::string& value);
+        bool get(const std::string& key, std::string& value) const;
+        bool erase(const std::string& key);
+        bool contains(const std::string& key) const;
+        std::vector<std::string> keys() const;
+
+        // Copies live records out of every sealed segment and deletes them;
+        // normally left to the background thread
+        void compact();
+
+        size_t segmentCount() const;
+    };
+}
+
+#endif // SAVESTORE_H
@@ -0,0 +1,158 @@
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <unordered_map>
+#include "Game.h"
+#include "SaveManager.h"
+#include "Snapshot.h"
+#include "WorldWatcher.h"
+#include "ThreadPool.h"
+#include "Leaderboard.h"
+#include "MemoryAccount.h"
+#include "SharedWorld.h"
+
+namespace Zork {
+
+    // What a client sees after each turn
+    struct TurnReply {
+        CommandResult result;
+        std::string output;     // Everything the game printed for this turn
+        std::string roomId;
+        std::string roomName;
+        int score;
+        size_t memory;          // Bytes the session holds after the turn
+
+        TurnReply() : score(0), memory(0) {}
+    };
+
+    enum class TurnStatus {
+        DONE,
+        NO_SESSION,
+        BUSY,           // The session's command queue is full
+        OVER_BUDGET     // The session outgrew its hard memory budget and was closed
+    };
+
+    using TurnCallback = std::function<void(TurnStatus status, TurnReply& reply)>;
+
+    // Owns the server's live games. New sessions are stamped from the
+    // current world template (from the watcher when there is one, so hot
+    // reloads reach new and existing sessions alike).
+    //
+    // Sessions left idle are hibernated: their state is written to the
+    // saves directory as a diff against the world template and the Game is
+    // freed. The next command wakes them transparently.
+    //
+    // With a ThreadPool, turns run on its workers: each session has a strand
+    // that keeps its commands in order, while different sessions run in
+    // parallel. No lock is shared between sessions for the length of a turn.
+    //
+    // Everything a session's game allocates is charged to its MemoryAccount.
+    // A session above the soft budget after a turn is hibernated at once; one
+    // above the hard budget is closed. While the total across all sessions is
+    // over budget, new sessions are refused and every session that is not
+    // mid-turn is hibernated at the next sweep. A budget of 0 is unlimited.
+    //
+    // With a SharedWorld, sessions are players in that one world instead of
+    // games of their own. Their turns run on the world's region actors
+    // rather than the session strands. They have nothing to hibernate and
+    // are not charged for memory; each sweep saves the world's item layout
+    // (restored when the world is attached) and rebalances its regions.
+    class SessionManager {
+    private:
+        struct Session {
+            std::mutex mutex;                 // Held for a turn, a hibernation or a wake
+            std::unique_ptr<Game> game;       // Null while hibernated, or in shared mode
+            SharedWorld::ResidentPtr resident;  // Shared mode only
+            SnapshotPtr world;                // Template the game was stamped from
+            std::chrono::steady_clock::time_point lastActive;
+            StrandPtr strand;                 // Null without a pool
+            MemoryAccountPtr account;
+            bool closed;
+
+            Session() : account(MemoryAccount::create()), closed(false) {}
+        };
+
+        SnapshotPtr fallback_;
+        const WorldWatcher* watcher_;
+        ThreadPool* pool_;
+        Leaderboard* leaderboard_;
+        SaveManager saves_;
+        std::mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
+        std::mt19937_64 seedSource_;          // Game RNG seeds only; ids are drawn from the kernel
+        std::atomic<size_t> resident_;
+        size_t softBudget_;
+        size_t hardBudget_;
+        size_t totalBudget_;
+        SharedWorld* shared_;
+        uint64_t sharedSaved_;                // World changes already on disk
+        std::mutex sharedSaveMutex_;
+
+        std::string newId();
+        SnapshotPtr currentWorld() const;
+        static void fillReply(Game& game, TurnReply& reply);
+        static void fillReply(const SharedWorld::Resident& resident, TurnReply& reply);
+        static std::string hibernationFile(const std::string& id);
+        void attach(Game& game);
+        void saveSharedWorld();
+        void submitShared(const std::string& id, std::vector<Command> commands, TurnCallback done);
+
+        // Both called with the session's mutex held
+        bool hibernate(const std::string& id, Session& session);
+        bool wake(const std::string& id, Session& session);
+
+    public:
+        SessionManager(SnapshotPtr fallback, const WorldWatcher* watcher, ThreadPool* pool = nullptr);
+
+        ~SessionManager();
+
+        // Switches to shared mode; call before the first session
+        void setSharedWorld(SharedWorld* world);
+
+        // Scores are reported to board at milestones and at game over
+        void setLeaderboard(Leaderboard* board) { leaderboard_ = board; }
+
+        // Per-session soft and hard limits and a limit on all sessions
+        // together, in bytes
+        void setMemoryBudget(size_t soft, size_t hard, size_t total);
+
+        // Starts a game and returns its id; the reply carries the welcome
+        // text and opening room. Without a name the player is named after
+        // the session. Returns "" when over the total memory budget (or,
+        // rarely, when the kernel cannot supply random bytes for the id).
+        // Ids are 128 random bits and are all a client needs to play.
+        std::string create(TurnReply& reply, const std::string& playerName = "");
+
+        // A session whose game ended (quit, death) is removed after answering.
+        // In shared mode this waits on the pool, so not from its workers.
+        TurnStatus execute(const std::string& id, const std::string& command, TurnReply& reply);
+        TurnStatus execute(const std::string& id, const std::vector<Command>& commands, TurnReply& reply);
+
+        // Parses the command on the calling thread, queues it on the
+        // session's strand and calls done from the worker that ran it
+        // (inline without a pool). A full queue is answered with BUSY
+        // right away.
+        void submit(const std::string& id, const std::string& command, TurnCallback done);
+        void submit(const std::string& id, std::vector<Command> commands, TurnCallback done);
+
+        bool remove(const std::string& id);
+
+        // Hibernates every resident session idle for at least maxIdle (or
+        // over its soft budget, or any while over the total budget) that is
+        // not mid-turn or in combat; returns how many were hibernated
+        size_t hibernateIdle(std::chrono::steady_clock::duration maxIdle);
+
+        size_t size();
+        size_t residentCount() const { return resident_.load(std::memory_order_relaxed); }
+        size_t memoryBytes() const { return MemoryAccount::totalBytes(); }
+        bool overMemoryBudget() const { return totalBudget_ > 0 && memoryBytes() > totalBudget_; }
+    };
+}
+
+#endif // SESSIONMANAGER_H
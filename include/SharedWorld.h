@@ -0,0 +1,221 @@
+#ifndef SHAREDWORLD_H
+#define SHAREDWORLD_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include "Command.h"
+#include "Player.h"
+#include "Room.h"
+#include "SaveManager.h"
+#include "Snapshot.h"
+#include "ThreadPool.h"
+
+namespace Zork {
+
+    // One world inhabited by many players at once, for the server's shared
+    // mode. Where every Game is a private copy of the world, here the
+    // rooms, the items lying in them and the people standing in them are
+    // the same for everyone.
+    //
+    // The room graph is cut into regions of neighbouring rooms, and each
+    // region is an actor: a strand on the ThreadPool that alone touches the
+    // rooms it owns. A player's commands go to the mailbox of the region
+    // they stand in and run there one after another, so players in
+    // different regions run in parallel without sharing a lock. A move into
+    // another region ends with a message handing the player (and the rest
+    // of their commands) to that region. Within a region, commands take
+    // effect in mailbox order: when two players grab the same item, the
+    // first one holds it and the other is told who beat them to it.
+    //
+    // Every room is also a channel. Takes, drops, arrivals and departures
+    // are formatted once into a shared, immutable event in the room's short
+    // history; each occupant keeps only a cursor into it and reads what is
+    // new at the start of their next turn. Publishing costs the same with
+    // five hundred people in the room as with one, and anyone who fell
+    // further behind than the history gets a single line for what they
+    // missed.
+    //
+    // rebalance() compares how busy the regions have been; a region well
+    // above the average hands some of its border rooms to quieter
+    // neighbours.
+    //
+    // The world outlives the players in it. A player who leaves drops what
+    // they carry where they stand, and exportState/importState carry where
+    // every item lies across a restart.
+    class SharedWorld {
+    private:
+        struct Batch;
+
+    public:
+        // A player's presence in the world. The player and room belong to
+        // the region actor running the player's commands.
+        struct Resident {
+            PlayerPtr player;
+            uint32_t room;
+            uint64_t id = 0;                            // Author tag on their own events
+            uint64_t seen = 0;                          // Events of room already read
+            bool gone = false;                          // Has left; later batches are refused
+
+            std::mutex mutex;                           // Guards pending only
+            std::deque<std::shared_ptr<Batch>> pending; // Front one is running
+        };
+        using ResidentPtr = std::shared_ptr<Resident>;
+
+        // Called once a batch has run, from the worker that finished it
+        using Done = std::function<void(CommandResult& result, std::string& output)>;
+
+    private:
+        static constexpr uint32_t NOWHERE = UINT32_MAX;
+        static constexpr int SHED_PASSES = 8;              // Border layers a region gives up at once
+        static constexpr int DISPATCH_RETRIES = 4;         // Yields on a full mailbox before running inline
+        static constexpr size_t EVENT_HISTORY = 32;        // Events a room remembers for its readers
+        static constexpr size_t SHOWN_EVENTS = 6;          // Lines of them a turn shows at most
+        static constexpr size_t LISTED_OCCUPANTS = 8;      // Names in a room description before "and N others"
+
+        struct Event {
+            uint64_t author;
+            std::shared_ptr<const std::string> text;    // One line, shared by every reader
+        };
+
+        struct RoomSlot {
+            RoomPtr room;
+            std::vector<Event> events;      // Ring of the newest EVENT_HISTORY
+            uint64_t published;             // Events ever published here
+            std::atomic<uint32_t> owner;    // Region; changed only by the owner
+            std::string lastTaken;          // Newest take here, to explain a lost race
+            std::string lastTaker;
+            uint32_t heat;                  // Messages in epoch
+            uint32_t lastHeat;              // Messages in the epoch before
+            uint32_t epoch;
+
+            explicit RoomSlot(RoomPtr r)
+                : room(std::move(r)), published(0), owner(0), heat(0), lastHeat(0), epoch(0) {}
+        };
+
+        struct Region {
+            // Held by the actor for each message, and by join and export
+            // from outside; messages never hold two
+            std::mutex mutex;
+            StrandPtr mailbox;
+            std::atomic<uint64_t> load;     // Messages since the last rebalance
+
+            Region() : load(0) {}
+        };
+
+        struct Batch {
+            ResidentPtr resident;
+            std::vector<Command> commands;
+            size_t next;
+            uint32_t arriving;              // Room the player is being handed to, or NOWHERE
+            bool leaving;
+            int retries;                    // Full mailboxes met since it last ran
+            CommandResult last;
+            std::string output;
+            Done done;
+
+            Batch() : next(0), arriving(NOWHERE), leaving(false), retries(0), last(true, "", true) {}
+        };
+
+        SnapshotPtr template_;
+        ThreadPool& pool_;
+        std::vector<std::unique_ptr<RoomSlot>> slots_;     // In template order, sorted by id
+        std::vector<std::unique_ptr<Region>> regions_;
+        std::vector<ItemPtr> itemList_;                    // In template order
+        std::unordered_map<std::string, ItemPtr> items_;   // Lowercase name -> item
+        uint32_t start_;
+        std::atomic<uint64_t> changes_;                    // Takes and drops so far
+        std::atomic<uint32_t> epoch_;                      // Rebalance windows so far
+        std::atomic<uint64_t> inlineBatches_;              // Run by their dispatcher past a full mailbox
+        std::atomic<uint64_t> deferredSheds_;              // Sheds put off to the next rebalance
+        std::atomic<uint64_t> nextResident_;
+        std::mutex rebalanceMutex_;
+
+        std::mutex namesMutex_;                            // Joining and leaving only
+        std::unordered_set<std::string> names_;
+
+        uint32_t indexOf(const std::string& roomId) const;
+        uint32_t ownerOf(uint32_t room) const { return slots_[room]->owner.load(std::memory_order_acquire); }
+        void partition(size_t regions);
+        void touch(RoomSlot& slot);
+        uint32_t heatIn(const RoomSlot& slot, uint32_t epoch) const;
+        bool isLit(const Room& room, const Player& player) const;
+        void describe(const RoomSlot& slot, const Player& player, std::string& output) const;
+        void publish(RoomSlot& slot, const Resident& author, std::string text);
+        void catchUp(Resident& resident, std::string& output);
+
+        // Posts a batch to the region owning the player's room. A full
+        // mailbox is retried a few times, then the caller steps in as the
+        // region's actor and runs the batch itself.
+        void dispatch(const std::shared_ptr<Batch>& batch);
+        void step(uint32_t region, const std::shared_ptr<Batch>& batch);
+        void finish(const std::shared_ptr<Batch>& batch);
+        // Actor side: step and shed run on the region's strand with its
+        // mutex held, and the commands below are called from step
+        void shed(uint32_t region, uint64_t budget, const std::vector<uint64_t>& loads, uint32_t epoch);
+
+        CommandResult apply(Resident& resident, const Command& command, std::string& output, uint32_t& handoff);
+        CommandResult move(Resident& resident, const std::string& direction, std::string& output, uint32_t& handoff);
+        void arrive(Resident& resident, uint32_t room, std::string& output, const char* how);
+        CommandResult take(Resident& resident, const std::string& itemName);
+        CommandResult drop(Resident& resident, const std::string& itemName);
+        CommandResult examine(Resident& resident, const std::string& itemName);
+        CommandResult look(Resident& resident, std::string& output);
+        CommandResult who(Resident& resident);
+        void depart(Resident& resident, const std::string& how);
+
+    public:
+        // Regions busier than this many times the average shed rooms
+        static constexpr uint64_t REBALANCE_FACTOR = 2;
+        // and only once they have handled this many messages since the last look
+        static constexpr uint64_t REBALANCE_MIN_LOAD = 256;
+
+        // With regions 0, there are Constants::REGIONS_PER_WORKER for each
+        // of the pool's workers (never more than there are rooms)
+        SharedWorld(SnapshotPtr world, ThreadPool& pool, size_t regions = 0);
+
+        SharedWorld(const SharedWorld&) = delete;
+        SharedWorld& operator=(const SharedWorld&) = delete;
+
+        // Places a new player in the start room and describes it. The name
+        // gets a numeric suffix if someone in the world already has it.
+        ResidentPtr join(const std::string& name, std::string& output);
+        // Queued behind the player's commands still waiting to run
+        void leave(const ResidentPtr& resident);
+
+        // Queues a batch of commands for one player; they run in order,
+        // stopping at the first that fails, like Game. False (and done is
+        // not called) when the player already has a full queue.
+        bool submit(const ResidentPtr& resident, std::vector<Command> commands, Done done);
+
+        // Hands rooms from regions well above the average load to quieter
+        // neighbours and starts a new measuring window; call periodically.
+        // A region whose mailbox is full keeps its load for the next call.
+        void rebalance();
+
+        // Rooms whose items differ from the template, by room id. Items
+        // being carried are not listed and go back to their template room
+        // on import.
+        void exportState(GameState& state) const;
+        // Only before anyone has joined
+        void importState(const GameState& state);
+
+        uint64_t getChanges() const { return changes_.load(std::memory_order_relaxed); }
+        uint64_t getInlineBatches() const { return inlineBatches_.load(std::memory_order_relaxed); }
+        uint64_t getDeferredSheds() const { return deferredSheds_.load(std::memory_order_relaxed); }
+        size_t playerCount();
+        size_t roomCount() const { return slots_.size(); }
+        size_t regionCount() const { return regions_.size(); }
+        // Rooms each region owns right now
+        std::vector<size_t> regionSizes() const;
+    };
+}
+
+#endif // SHAREDWORLD_H
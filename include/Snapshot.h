@@ -0,0 +1,82 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <cstdint>
+#include "Item.h"
+#include "RuleEngine.h"
+
+namespace Zork {
+
+    // Flat, index-linked image of a Game. Rooms and items refer to each
+    // other by position in the vectors below instead of by pointer, so an
+    // image can be shared read-only between any number of forks.
+    struct ItemImage {
+        std::string name;
+        std::string description;
+        int weight;
+        bool takeable;
+        ItemType type;
+        int value;
+        int damage;
+        int defense;
+        bool lightSource;
+        bool lightOn;
+        int fuel;
+        int lightRadius;
+    };
+
+    struct RoomImage {
+        std::string id;
+        std::string name;
+        std::string description;
+        bool visited;
+        bool lit;
+        bool locked;
+        std::vector<std::pair<std::string, uint32_t>> exits;
+        std::vector<uint32_t> items;
+    };
+
+    struct EnemyImage {
+        std::string name;
+        std::string description;
+        int health;
+        int maxHealth;
+        int attackPower;
+        int defense;
+        int experienceReward;
+        bool hostile;
+    };
+
+    struct WorldSnapshot {
+        std::vector<ItemImage> items;
+        std::vector<RoomImage> rooms;      // Sorted by room id
+
+        std::string playerName;
+        uint32_t playerRoom;
+        int playerHealth;
+        std::vector<uint32_t> inventory;
+
+        bool hasEnemy;
+        EnemyImage enemy;
+        bool inCombat;
+
+        int score;
+        int moves;
+        std::mt19937 rng;
+
+        RuleProgramPtr rules;
+        std::vector<std::string> flags;    // Names of rule flags that are set
+
+        WorldSnapshot()
+            : playerRoom(0), playerHealth(0), hasEnemy(false), enemy(),
+              inCombat(false), score(0), moves(0) {}
+    };
+
+    using SnapshotPtr = std::shared_ptr<const WorldSnapshot>;
+}
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,89 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "RingQueue.h"
+
+namespace Zork {
+
+    using Task = std::function<void()>;
+
+    // Work-stealing pool. Every worker owns a deque: it pushes and pops its
+    // own work at the back and, when that runs dry, steals from the front of
+    // the others. Tasks submitted from outside the pool are spread round
+    // robin, so one slow task only ever holds up its own worker.
+    class ThreadPool {
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+        std::atomic<size_t> queued_;
+        std::atomic<size_t> sleepers_;
+        std::atomic<size_t> nextWorker_;
+        std::atomic<bool> stopping_;
+        std::mutex sleepMutex_;
+        std::condition_variable wake_;
+
+        void push(Task task, bool back);
+        void workerLoop(size_t index);
+        bool popLocal(size_t index, Task& task);
+        bool steal(size_t thief, Task& task);
+
+    public:
+        // 0 threads means one per hardware thread
+        explicit ThreadPool(size_t threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(Task task);
+
+        // Like submit, but queued behind the calling worker's other work
+        // (where an idle worker is also first to steal it)
+        void yield(Task task);
+
+        // Runs everything already queued, then joins the workers. Further
+        // submissions are run inline by the caller.
+        void shutdown();
+
+        size_t size() const { return workers_.size(); }
+    };
+
+    // Runs posted tasks one at a time and in order on a ThreadPool, without
+    // tying them to a thread. Different strands run in parallel. Posting is
+    // lock-free: tasks go through a bounded ring, and whoever raises the
+    // count from zero schedules the drain.
+    class Strand : public std::enable_shared_from_this<Strand> {
+    private:
+        ThreadPool& pool_;
+        RingQueue<Task> queue_;
+        std::atomic<size_t> count_;   // Posted and not yet finished
+
+        void drain();
+
+    public:
+        // Tasks run back to back before the strand yields its worker
+        static const size_t BATCH_SIZE = 16;
+
+        Strand(ThreadPool& pool, size_t capacity) : pool_(pool), queue_(capacity), count_(0) {}
+
+        // False (and the task is dropped) when capacity tasks are queued
+        bool post(Task task);
+    };
+
+    using StrandPtr = std::shared_ptr<Strand>;
+}
+
+#endif // THREADPOOL_H
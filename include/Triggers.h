@@ -0,0 +1,63 @@
+#ifndef TRIGGERS_H
+#define TRIGGERS_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Zork {
+
+    // Maps (room, verb, object) to a chain of action ids in an open-addressed
+    // table. A lookup probes the exact key, then (room, verb, *), then
+    // (*, verb, object), then (*, verb, *), and fires the first key that has
+    // anything registered. Action ids are opaque; the owner decides what
+    // they mean (a bytecode entry point, a callback index, ...).
+    class TriggerRegistry {
+    private:
+        struct Slot {
+            uint32_t room;
+            uint32_t verb;
+            uint32_t object;
+            uint32_t first;   // Index into entries_, EMPTY if unused
+            uint32_t last;
+        };
+
+        struct Entry {
+            uint32_t action;
+            uint32_t next;
+        };
+
+        std::unordered_map<std::string, uint32_t> symbols_;
+        std::vector<Slot> slots_;
+        std::vector<Entry> entries_;
+        size_t used_;
+
+        static uint64_t hashKey(uint32_t room, uint32_t verb, uint32_t object);
+        const Slot* findSlot(uint32_t room, uint32_t verb, uint32_t object) const;
+        void rehash(size_t capacity);
+
+    public:
+        static const uint32_t WILDCARD = 0;
+        static const uint32_t UNKNOWN = UINT32_MAX;
+        static const uint32_t EMPTY = UINT32_MAX;
+
+        TriggerRegistry();
+
+        // "*" and "" are the wildcard; names are case-insensitive
+        uint32_t intern(const std::string& name);
+        uint32_t lookup(const std::string& name) const;
+
+        void add(const std::string& room, const std::string& verb,
+                 const std::string& object, uint32_t action);
+
+        // Appends the matched actions to `actions` and returns how many
+        size_t match(const std::string& room, const std::string& verb,
+                     const std::string& object, std::vector<uint32_t>& actions) const;
+
+        size_t size() const { return entries_.size(); }
+        bool empty() const { return entries_.empty(); }
+    };
+}
+
+#endif // TRIGGERS_H
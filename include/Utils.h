@@ -2,9 +2,11 @@
 #define UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <cctype>
+#include <random>
 
 namespace Zork {
     namespace Utils {
@@ -16,6 +18,20 @@ namespace Zork {
             return str;
         }
         
+        // Case-insensitive comparison without building lowered copies
+        inline bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (std::tolower(static_cast<unsigned char>(a[i])) !=
+                    std::tolower(static_cast<unsigned char>(b[i]))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        
         inline std::string trim(const std::string& str) {
             size_t first = str.find_first_not_of(' ');
             if (std::string::npos == first) {
@@ -60,9 +76,24 @@ namespace Zork {
         }
         
         // Random number generation
+        // Draws come from the engine bound to the calling thread, so each
+        // Game can own (and snapshot) its own random state.
+        std::mt19937& randomEngine();
         int randomInt(int min, int max);
         bool randomBool(double probability = 0.5);
         
+        class RandomScope {
+        private:
+            std::mt19937* previous_;
+            
+        public:
+            explicit RandomScope(std::mt19937& engine);
+            ~RandomScope();
+            
+            RandomScope(const RandomScope&) = delete;
+            RandomScope& operator=(const RandomScope&) = delete;
+        };
+        
         // File utilities
         bool fileExists(const std::string& filename);
         std::string readFile(const std::string& filename);
@@ -70,6 +101,8 @@ namespace Zork {
         
         // Console utilities
         void clearScreen();
+        std::string separator(char ch = '=', int length = 60);
+        std::string centered(const std::string& text, int width = 60);
         void printSeparator(char ch = '=', int length = 60);
         void printCentered(const std::string& text, int width = 60);
         std::string getInput(const std::string& prompt = "> ");
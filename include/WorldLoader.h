@@ -0,0 +1,30 @@
+#ifndef WORLDLOADER_H
+#define WORLDLOADER_H
+
+#include <string>
+#include "Json.h"
+#include "Snapshot.h"
+
+namespace Zork {
+
+    // Builds a world template from the JSON data files (rooms.json and
+    // items.json). Any dangling reference rejects the whole world, so a bad
+    // content push never replaces a good one.
+    class WorldLoader {
+    private:
+        std::string error_;
+
+        bool fail(const std::string& message);
+
+    public:
+        bool loadDirectory(const std::string& directory, WorldSnapshot& world);
+        bool loadJson(const JsonValue& rooms, const JsonValue& items, WorldSnapshot& world);
+
+        const std::string& getError() const { return error_; }
+
+        static ItemType parseItemType(const std::string& type);
+        static std::string itemTypeName(ItemType type);
+    };
+}
+
+#endif // WORLDLOADER_H
@@ -0,0 +1,123 @@
+#ifndef WORLDPAGER_H
+#define WORLDPAGER_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include "Room.h"
+
+namespace Zork {
+
+    // Supplies the rooms of one region at a time. Exits inside a region are
+    // ordinary Room::addExit links; exits that leave the region must be
+    // added with Room::addRemoteExit so regions stay independently loadable.
+    // loadRegion is called from the prefetch thread and must be thread-safe.
+    class RegionSource {
+    public:
+        virtual ~RegionSource() = default;
+
+        // Where a player coming from the rest of the world arrives
+        virtual std::string entryRoom() const = 0;
+        virtual std::string regionOf(const std::string& roomId) const = 0;
+        virtual std::vector<RoomPtr> loadRegion(const std::string& regionId) = 0;
+        virtual std::vector<std::string> neighborRegions(const std::string& regionId) const = 0;
+    };
+
+    // Procedural grid world: width x height rooms cut into square regions.
+    // Everything is derived from the seed, so any region can be rebuilt at
+    // any time without storing it. With exitRoom set, the corner room at
+    // (0, 0) leads up to that room of the rest of the world.
+    class GridRegionSource : public RegionSource {
+    private:
+        uint64_t seed_;
+        int width_;
+        int height_;
+        int regionSize_;
+        std::string exitRoom_;
+
+        bool parseRoomId(const std::string& roomId, int& x, int& y) const;
+
+    public:
+        GridRegionSource(uint64_t seed, int width, int height, int regionSize = 32,
+                         const std::string& exitRoom = "");
+
+        static std::string roomId(int x, int y);
+
+        std::string entryRoom() const override { return roomId(0, 0); }
+        std::string regionOf(const std::string& roomId) const override;
+        std::vector<RoomPtr> loadRegion(const std::string& regionId) override;
+        std::vector<std::string> neighborRegions(const std::string& regionId) const override;
+    };
+
+    // Keeps at most `capacity` regions resident. Regions are faulted in on
+    // first access, evicted least-recently-used first, and their neighbors
+    // are built ahead of time on a background thread. Player-visible state
+    // (visited flag, items) of evicted rooms survives in a small overlay.
+    class WorldPager {
+    private:
+        struct Region {
+            std::vector<RoomPtr> rooms;
+            std::list<std::string>::iterator lruPosition;
+        };
+
+        struct RoomState {
+            bool visited;
+            std::vector<ItemPtr> items;
+        };
+
+        std::unique_ptr<RegionSource> source_;
+        size_t capacity_;
+
+        // Owned by the game thread
+        std::unordered_map<std::string, Region> resident_;
+        std::unordered_map<std::string, RoomPtr> roomIndex_;
+        std::list<std::string> lru_;
+        std::unordered_map<std::string, RoomState> overlay_;
+
+        // Shared with the prefetch thread
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable loaded_;
+        std::deque<std::string> prefetchQueue_;
+        std::unordered_set<std::string> inFlight_;
+        std::unordered_map<std::string, std::vector<RoomPtr>> prefetched_;
+        bool stopping_;
+        std::thread worker_;
+
+        size_t faults_;
+        size_t prefetchHits_;
+        size_t evictions_;
+
+        void prefetchLoop();
+        void schedulePrefetch(const std::string& regionId);
+        std::vector<RoomPtr> acquireRegion(const std::string& regionId);
+        void makeResident(const std::string& regionId, std::vector<RoomPtr> rooms);
+        void evictOne();
+
+    public:
+        WorldPager(std::unique_ptr<RegionSource> source, size_t capacity);
+        ~WorldPager();
+
+        WorldPager(const WorldPager&) = delete;
+        WorldPager& operator=(const WorldPager&) = delete;
+
+        RoomPtr getRoom(const std::string& roomId);
+        std::string entryRoom() const { return source_->entryRoom(); }
+
+        size_t getResidentRegions() const { return resident_.size(); }
+        size_t getResidentRooms() const { return roomIndex_.size(); }
+        size_t getFaults() const { return faults_; }
+        size_t getPrefetchHits() const { return prefetchHits_; }
+        size_t getEvictions() const { return evictions_; }
+    };
+}
+
+#endif // WORLDPAGER_H
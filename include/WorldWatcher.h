@@ -0,0 +1,45 @@
+#ifndef WORLDWATCHER_H
+#define WORLDWATCHER_H
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include "Snapshot.h"
+
+namespace Zork {
+
+    // Watches a data directory and republishes the world template whenever
+    // its content changes. Publishing is an atomic pointer swap: readers
+    // either see the old template or the new one, and the old one lives on
+    // for as long as some session still holds it. Games poll getVersion()
+    // (a single atomic load) between commands and migrate when it moves.
+    class WorldWatcher {
+    private:
+        std::string directory_;
+        SnapshotPtr current_;             // Accessed with std::atomic_load/store
+        std::atomic<uint64_t> version_;
+        std::atomic<bool> stopping_;
+        std::thread thread_;
+        int wakeFd_[2];
+
+        void watchLoop();
+        void pollLoop();
+
+    public:
+        explicit WorldWatcher(const std::string& directory);
+        ~WorldWatcher();
+
+        WorldWatcher(const WorldWatcher&) = delete;
+        WorldWatcher& operator=(const WorldWatcher&) = delete;
+
+        // Rebuilds the template synchronously; keeps the old one on error
+        bool reload(std::string& error);
+
+        SnapshotPtr current() const { return std::atomic_load(&current_); }
+        uint64_t getVersion() const { return version_.load(std::memory_order_acquire); }
+        const std::string& getDirectory() const { return directory_; }
+    };
+}
+
+#endif // WORLDWATCHER_H
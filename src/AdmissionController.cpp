@@ -0,0 +1,108 @@
+#include "../include/AdmissionController.h"
+#include <algorithm>
+
+namespace Zork {
+
+    namespace {
+        // Four buckets per power of two: exact below 4us, within a quarter
+        // above
+        size_t bucketOf(uint64_t micros) {
+            if (micros < 4) {
+                return static_cast<size_t>(micros);
+            }
+            size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(micros));
+            return 4 * (exponent - 1) + static_cast<size_t>((micros >> (exponent - 2)) & 3);
+        }
+
+        uint64_t upperBoundOf(size_t bucket) {
+            if (bucket < 4) {
+                return bucket + 1;
+            }
+            size_t exponent = bucket / 4 + 1;
+            return static_cast<uint64_t>(5 + bucket % 4) << (exponent - 2);
+        }
+    }
+
+    AdmissionController::AdmissionController(size_t maxInFlight, int maxP99Ms)
+        : maxInFlight_(maxInFlight), maxP99_(std::chrono::milliseconds(maxP99Ms)), inFlight_(0),
+          slow_(false), p50_(0), p99_(0), completed_(0), shedSessions_(0), shedCommands_(0) {
+        for (auto& bucket : window_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void AdmissionController::configure(size_t maxInFlight, int maxP99Ms) {
+        maxInFlight_ = maxInFlight;
+        maxP99_ = std::chrono::milliseconds(maxP99Ms);
+    }
+
+    bool AdmissionController::overloaded() const {
+        return (maxInFlight_ > 0 && inFlight_.load(std::memory_order_relaxed) >= maxInFlight_) ||
+               slow_.load(std::memory_order_relaxed);
+    }
+
+    bool AdmissionController::admit(size_t limit, std::atomic<uint64_t>& shed) {
+        // Optimistic: a burst may overshoot the limit by a few requests,
+        // which is cheaper than a lock on every one
+        if (limit > 0 && inFlight_.load(std::memory_order_relaxed) >= limit) {
+            shed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        inFlight_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool AdmissionController::admitSession() {
+        if (slow_.load(std::memory_order_relaxed)) {
+            shedSessions_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return admit(maxInFlight_, shedSessions_);
+    }
+
+    bool AdmissionController::admitCommand(Priority priority) {
+        if (priority == Priority::LOW) {
+            if (slow_.load(std::memory_order_relaxed)) {
+                shedCommands_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            return admit(maxInFlight_, shedCommands_);
+        }
+        return admit(maxInFlight_ * 2, shedCommands_);
+    }
+
+    void AdmissionController::finished(std::chrono::steady_clock::duration latency) {
+        inFlight_.fetch_sub(1, std::memory_order_relaxed);
+        completed_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+        window_[std::min(bucketOf(micros), LATENCY_BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AdmissionController::tick() {
+        std::lock_guard<std::mutex> lock(tickMutex_);
+        uint64_t counts[LATENCY_BUCKETS];
+        uint64_t total = 0;
+        for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+            counts[i] = window_[i].exchange(0, std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        // Percentiles are bucket upper bounds
+        auto percentile = [&](uint64_t permille) {
+            uint64_t rank = (total * permille + 999) / 1000;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return upperBoundOf(i);
+                }
+            }
+            return upperBoundOf(LATENCY_BUCKETS - 1);
+        };
+        uint64_t p99 = total > 0 ? percentile(990) : 0;
+        p50_.store(total > 0 ? percentile(500) : 0, std::memory_order_relaxed);
+        p99_.store(p99, std::memory_order_relaxed);
+        slow_.store(maxP99_.count() > 0 && total >= MIN_SAMPLES &&
+                    p99 > static_cast<uint64_t>(maxP99_.count()), std::memory_order_relaxed);
+    }
+}
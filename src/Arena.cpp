@@ -0,0 +1,86 @@
+#include "../include/Arena.h"
+#include <cstdint>
+#include <new>
+
+namespace Zork {
+
+    namespace {
+        const size_t MAX_BLOCK_SIZE = 1 << 20;
+    }
+
+    Arena::Arena(size_t blockSize)
+        : head_(nullptr),
+          cursor_(nullptr),
+          end_(nullptr),
+          blockSize_(blockSize < 256 ? 256 : blockSize),
+          bytesUsed_(0),
+          bytesReserved_(0) {
+    }
+
+    Arena::~Arena() {
+        Block* block = head_;
+        while (block) {
+            Block* next = block->next;
+            ::operator delete(block);
+            block = next;
+        }
+    }
+
+    void Arena::grow(size_t minBytes) {
+        size_t size = blockSize_;
+        while (size < minBytes + sizeof(Block)) {
+            size *= 2;
+        }
+
+        // Through operator new so blocks count against the memory account
+        // of whoever grows the arena
+        void* memory = ::operator new(size);
+
+        Block* block = static_cast<Block*>(memory);
+        block->next = head_;
+        block->size = size;
+        head_ = block;
+        cursor_ = reinterpret_cast<char*>(block + 1);
+        end_ = static_cast<char*>(memory) + size;
+        bytesReserved_ += size;
+
+        // Geometric growth keeps the block count logarithmic in arena size
+        if (blockSize_ < MAX_BLOCK_SIZE) {
+            blockSize_ *= 2;
+        }
+    }
+
+    void* Arena::do_allocate(size_t bytes, size_t alignment) {
+        uintptr_t current = reinterpret_cast<uintptr_t>(cursor_);
+        uintptr_t aligned = (current + alignment - 1) & ~(uintptr_t(alignment) - 1);
+
+        if (!cursor_ || aligned + bytes > reinterpret_cast<uintptr_t>(end_)) {
+            grow(bytes + alignment);
+            current = reinterpret_cast<uintptr_t>(cursor_);
+            aligned = (current + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        }
+
+        cursor_ = reinterpret_cast<char*>(aligned + bytes);
+        bytesUsed_ += bytes;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void Arena::reset() {
+        if (!head_) {
+            return;
+        }
+
+        Block* block = head_->next;
+        while (block) {
+            Block* next = block->next;
+            bytesReserved_ -= block->size;
+            ::operator delete(block);
+            block = next;
+        }
+
+        head_->next = nullptr;
+        cursor_ = reinterpret_cast<char*>(head_ + 1);
+        end_ = reinterpret_cast<char*>(head_) + head_->size;
+        bytesUsed_ = 0;
+    }
+}
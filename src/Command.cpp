@@ -1,7 +1,9 @@
 #include "../include/Command.h"
 #include "../include/Game.h"
 #include "../include/Utils.h"
+#include "../include/MemoryAccount.h"
 #include <sstream>
+#include <cctype>
 
 namespace Zork {
     
@@ -43,16 +45,80 @@ namespace Zork {
         commandAliases_["fight"] = {"attack"};
     }
     
-    std::string CommandParser::normalizeVerb(const std::string& verb) {
-        if (commandAliases_.find(verb) != commandAliases_.end()) {
-            return commandAliases_[verb][0];
+    std::string CommandParser::normalizeVerb(const std::string& verb) const {
+        auto alias = commandAliases_.find(verb);
+        if (alias != commandAliases_.end()) {
+            return alias->second[0];
         }
         return verb;
     }
     
-    CommandResult CommandParser::parse(const std::string& input) {
-        Command cmd(input);
+    std::string CommandParser::canonicalVerb(const std::string& verb) {
+        // The alias table does not depend on the game. Built outside any
+        // session's memory account, since it lives as long as the process.
+        static const CommandParser* aliases = [] {
+            MemoryAccount::Scope shared(nullptr);
+            return new CommandParser(nullptr);
+        }();
+        return aliases->normalizeVerb(verb);
+    }
+    
+    std::vector<std::string> CommandParser::splitPipeline(const std::string& input) {
+        std::vector<std::string> commands;
+        std::string current;
+        
+        auto finish = [&]() {
+            std::string trimmed = Utils::trim(current);
+            if (!trimmed.empty()) {
+                commands.push_back(std::move(trimmed));
+            }
+            current.clear();
+        };
         
+        size_t i = 0;
+        while (i < input.size()) {
+            char ch = input[i];
+            if (ch == '.' || ch == ',') {
+                finish();
+                ++i;
+                continue;
+            }
+            if (std::isspace(static_cast<unsigned char>(ch))) {
+                current += ch;
+                ++i;
+                continue;
+            }
+            
+            size_t end = i;
+            while (end < input.size() && !std::isspace(static_cast<unsigned char>(input[end])) &&
+                   input[end] != '.' && input[end] != ',') {
+                ++end;
+            }
+            std::string word = input.substr(i, end - i);
+            if (Utils::toLower(word) == "then") {
+                finish();
+            } else {
+                current += word;
+            }
+            i = end;
+        }
+        finish();
+        return commands;
+    }
+    
+    std::vector<Command> CommandParser::parsePipeline(const std::string& input) {
+        std::vector<Command> commands;
+        for (const std::string& segment : splitPipeline(input)) {
+            commands.emplace_back(segment);
+        }
+        return commands;
+    }
+    
+    CommandResult CommandParser::parse(const std::string& input) {
+        return execute(Command(input));
+    }
+    
+    CommandResult CommandParser::execute(const Command& cmd) {
         if (cmd.getVerb().empty()) {
             return CommandResult(true, "", true);
         }
@@ -85,6 +151,12 @@ namespace Zork {
         else if (verb == "use") {
             return handleUse(cmd);
         }
+        else if (verb == "open") {
+            return handleOpen(cmd);
+        }
+        else if (verb == "combine") {
+            return handleCombine(cmd);
+        }
         else if (verb == "attack") {
             return handleAttack(cmd);
         }
@@ -103,17 +175,36 @@ namespace Zork {
         else if (verb == "quit") {
             return handleQuit(cmd);
         }
+        else if (verb == "undo") {
+            return handleUndo(cmd);
+        }
+        else if (verb == "redo") {
+            return handleRedo(cmd);
+        }
         
         return CommandResult(false, "I don't understand that command. Type 'help' for a list of commands.", true);
     }
     
     CommandResult CommandParser::handleMove(const Command& cmd) {
         std::string direction = normalizeVerb(cmd.getVerb());
+        PlayerPtr player = game_->getPlayer();
+        RoomPtr from = player->getCurrentRoom();
+        int scoreBefore = game_->getScore();
         
-        if (game_->getPlayer()->move(direction)) {
+        if (player->move(direction)) {
+            Delta delta(DeltaType::MOVE);
+            delta.fromRoom = from;
+            delta.toRoom = player->getCurrentRoom();
+            delta.firstVisit = !delta.toRoom->isVisited();
+            delta.movesDelta = 1;
+            
             game_->incrementMoves();
             game_->displayRoom();
-            return CommandResult(true, "", true);
+            std::string message;
+            game_->fireTriggers("enter", "", message);
+            delta.scoreDelta = game_->getScore() - scoreBefore;
+            game_->recordDelta(std::move(delta));
+            return CommandResult(true, message, true);
         }
         
         return CommandResult(false, "You can't go that way.", true);
@@ -135,16 +226,17 @@ namespace Zork {
         std::string target = cmd.getArgsAsString();
         PlayerPtr player = game_->getPlayer();
         
-        // Check inventory
+        // Check inventory, then the room
         ItemPtr item = player->getInventoryItem(target);
-        if (item) {
-            return CommandResult(true, item->getDescription(), true);
+        if (!item) {
+            item = player->getCurrentRoom()->getItem(target);
         }
-        
-        // Check room
-        item = player->getCurrentRoom()->getItem(target);
         if (item) {
-            return CommandResult(true, item->getDescription(), true);
+            std::string message = item->getDescription();
+            int scoreBefore = game_->getScore();
+            game_->fireTriggers("examine", item->getName(), message);
+            recordRuleDelta(scoreBefore);
+            return CommandResult(true, message, true);
         }
         
         return CommandResult(false, "You don't see that here.", true);
@@ -163,7 +255,14 @@ namespace Zork {
         std::string message;
         
         if (player->takeItem(item, message)) {
+            int scoreBefore = game_->getScore();
             game_->addScore(5);
+            game_->fireTriggers("take", item->getName(), message);
+            Delta delta(DeltaType::TAKE);
+            delta.toRoom = room;
+            delta.item = item;
+            delta.scoreDelta = game_->getScore() - scoreBefore;
+            game_->recordDelta(std::move(delta));
             return CommandResult(true, message, true);
         } else {
             if (item) {
@@ -180,8 +279,19 @@ namespace Zork {
         
         std::string itemName = cmd.getArgsAsString();
         std::string message;
+        PlayerPtr player = game_->getPlayer();
+        ItemPtr item = player->getInventoryItem(itemName);
         
-        bool success = game_->getPlayer()->dropItem(itemName, message);
+        bool success = player->dropItem(itemName, message);
+        if (success) {
+            int scoreBefore = game_->getScore();
+            game_->fireTriggers("drop", item->getName(), message);
+            Delta delta(DeltaType::DROP);
+            delta.toRoom = player->getCurrentRoom();
+            delta.item = item;
+            delta.scoreDelta = game_->getScore() - scoreBefore;
+            game_->recordDelta(std::move(delta));
+        }
         return CommandResult(success, message, true);
     }
     
@@ -190,16 +300,83 @@ namespace Zork {
         return CommandResult(true, inv, true);
     }
     
+    void CommandParser::splitObjects(const Command& cmd, std::string& item, std::string& with) const {
+        // "use rope on hook", "combine rope with hook", "combine rope and hook"
+        std::vector<std::string> first;
+        std::vector<std::string> second;
+        bool seenSeparator = false;
+        for (const std::string& word : cmd.getArgs()) {
+            std::string lower = Utils::toLower(word);
+            if (!seenSeparator && (lower == "on" || lower == "with" || lower == "and")) {
+                seenSeparator = true;
+                continue;
+            }
+            (seenSeparator ? second : first).push_back(word);
+        }
+        item = Utils::join(first, " ");
+        with = Utils::join(second, " ");
+    }
+    
+    void CommandParser::recordRuleDelta(int scoreBefore) {
+        int scoreDelta = game_->getScore() - scoreBefore;
+        if (game_->hasRuleEffects() || scoreDelta != 0) {
+            Delta delta(DeltaType::RULE);
+            delta.scoreDelta = scoreDelta;
+            game_->recordDelta(std::move(delta));
+        }
+    }
+    
     CommandResult CommandParser::handleUse(const Command& cmd) {
         if (!cmd.hasArgs()) {
             return CommandResult(false, "Use what?", true);
         }
         
-        // TODO: Implement item usage system with context awareness
-        // Items should interact with environment and other items
+        std::string item, with, message;
+        splitObjects(cmd, item, with);
+        int scoreBefore = game_->getScore();
+        RuleOutcome outcome = game_->runRule("use", item, with, message);
+        recordRuleDelta(scoreBefore);
+        if (outcome != RuleOutcome::NO_RULE) {
+            return CommandResult(outcome == RuleOutcome::SUCCESS, message, true);
+        }
         return CommandResult(false, "You're not sure how to use that right now.", true);
     }
     
+    CommandResult CommandParser::handleOpen(const Command& cmd) {
+        if (!cmd.hasArgs()) {
+            return CommandResult(false, "Open what?", true);
+        }
+        
+        std::string message;
+        int scoreBefore = game_->getScore();
+        RuleOutcome outcome = game_->runRule("open", cmd.getArgsAsString(), "", message);
+        recordRuleDelta(scoreBefore);
+        if (outcome != RuleOutcome::NO_RULE) {
+            return CommandResult(outcome == RuleOutcome::SUCCESS, message, true);
+        }
+        return CommandResult(false, "You can't open that.", true);
+    }
+    
+    CommandResult CommandParser::handleCombine(const Command& cmd) {
+        std::string item, with, message;
+        splitObjects(cmd, item, with);
+        if (item.empty() || with.empty()) {
+            return CommandResult(false, "Combine what with what?", true);
+        }
+        
+        // Combining is symmetric for content authors
+        int scoreBefore = game_->getScore();
+        RuleOutcome outcome = game_->runRule("combine", item, with, message);
+        if (outcome == RuleOutcome::NO_RULE) {
+            outcome = game_->runRule("combine", with, item, message);
+        }
+        recordRuleDelta(scoreBefore);
+        if (outcome != RuleOutcome::NO_RULE) {
+            return CommandResult(outcome == RuleOutcome::SUCCESS, message, true);
+        }
+        return CommandResult(false, "Those don't seem to go together.", true);
+    }
+    
     CommandResult CommandParser::handleAttack(const Command& cmd) {
         // TODO: Implement full combat system with enemy encounters
         // Need to check for enemies in current room
@@ -222,7 +399,7 @@ namespace Zork {
     }
     
     CommandResult CommandParser::handleHelp(const Command& cmd) {
-        std::cout << getHelpText();
+        game_->print(getHelpText());
         return CommandResult(true, "", true);
     }
     
@@ -230,14 +407,27 @@ namespace Zork {
         return CommandResult(true, "Thanks for playing!", false);
     }
     
+    CommandResult CommandParser::handleUndo(const Command& cmd) {
+        std::string message;
+        bool success = game_->undo(message);
+        return CommandResult(success, message, true);
+    }
+    
+    CommandResult CommandParser::handleRedo(const Command& cmd) {
+        std::string message;
+        bool success = game_->redo(message);
+        return CommandResult(success, message, true);
+    }
+    
     std::string CommandParser::getHelpText() const {
         std::stringstream ss;
         ss << "\n=== Available Commands ===\n";
         ss << "Movement: north, south, east, west, up, down (or n, s, e, w, u, d)\n";
         ss << "Actions: look, examine <item>, take <item>, drop <item>\n";
+        ss << "Items: use <item> [on <target>], open <item>, combine <item> with <item>\n";
         ss << "Inventory: inventory (or i, inv)\n";
         ss << "Combat: attack <enemy>, use <item>\n";
-        ss << "Game: score, save, load, help, quit\n";
+        ss << "Game: score, undo, redo, save, load, help, quit\n";
         ss << "========================\n";
         return ss.str();
     }
@@ -1,170 +1,568 @@
 #include "../include/Game.h"
 #include "../include/Constants.h"
 #include "../include/Utils.h"
+#include "../include/EmbeddedWorld.h"
+#include "../include/MemoryAccount.h"
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <unordered_map>
 
 namespace Zork {
     
+    namespace {
+        // The built-in world's rules, compiled on first use and shared by
+        // every game playing it
+        RuleProgramPtr embeddedRules() {
+            static const RuleProgramPtr rules = []() -> RuleProgramPtr {
+                if (!EMBEDDED_WORLD.rules) {
+                    return nullptr;
+                }
+                MemoryAccount::Scope shared(nullptr);
+                RuleCompiler compiler;
+                RuleProgramPtr program = compiler.loadText(EMBEDDED_WORLD.rules, "rules.json");
+                if (!program) {
+                    std::cerr << "Rules not loaded: " << compiler.getError() << std::endl;
+                }
+                return program;
+            }();
+            return rules;
+        }
+    }
+    
     Game::Game() 
-        : running_(false), 
+        : worldArena_(16 * 1024),
+          scratchArena_(4 * 1024),
+          running_(false), 
           score_(0), 
           moves_(0),
-          inCombat_(false) {
+          inCombat_(false),
+          rng_(std::random_device{}()),
+          history_(Constants::UNDO_HISTORY_SIZE),
+          darkTurns_(0),
+          reportedScore_(0),
+          out_(&std::cout),
+          worldSource_(nullptr),
+          worldVersion_(0) {
+        parser_ = std::make_unique<CommandParser>(this);
+    }
+    
+    Game::Game(const WorldSnapshot& snapshot)
+        : worldArena_(16 * 1024),
+          scratchArena_(4 * 1024),
+          running_(false),
+          score_(0),
+          moves_(0),
+          inCombat_(false),
+          history_(Constants::UNDO_HISTORY_SIZE),
+          darkTurns_(0),
+          reportedScore_(0),
+          out_(&std::cout),
+          worldSource_(nullptr),
+          worldVersion_(0) {
         parser_ = std::make_unique<CommandParser>(this);
+        restoreSnapshot(snapshot);
     }
     
     Game::~Game() {
-        // Cleanup handled by smart pointers
+        // Exits form shared_ptr cycles; break them so room destructors run
+        // before the world arena releases its blocks
+        for (auto& pair : rooms_) {
+            pair.second->clearExits();
+        }
+    }
+    
+    void Game::releaseWorld() {
+        for (auto& pair : rooms_) {
+            pair.second->clearExits();
+        }
+        rooms_.clear();
+        player_.reset();
+        currentEnemy_.reset();
+        inCombat_ = false;
+        history_.clear();
+        ruleEffects_.clear();
+        lighting_.clear();
+        darkTurns_ = 0;
+        
+        // Nothing references the old world any more
+        worldArena_.reset();
     }
     
     void Game::setupWorld() {
-        createRooms();
-        createItems();
-        connectRooms();
-        
-        // Create player
-        player_ = std::make_shared<Player>("Adventurer", rooms_["west_of_house"]);
-    }
-    
-    void Game::createRooms() {
-        rooms_["west_of_house"] = std::make_shared<Room>(
-            "west_of_house",
-            "West of House",
-            "You are standing in an open field west of a white house, "
-            "with a boarded front door. There is a small mailbox here."
-        );
-        
-        rooms_["forest"] = std::make_shared<Room>(
-            "forest",
-            "Forest",
-            "This is a forest, with trees in all directions. "
-            "To the east, there appears to be sunlight."
-        );
-        
-        rooms_["behind_house"] = std::make_shared<Room>(
-            "behind_house",
-            "Behind House",
-            "You are behind the white house. A path leads into the forest "
-            "to the east. In one corner of the house there is a small window "
-            "which is slightly ajar."
-        );
-        
-        rooms_["kitchen"] = std::make_shared<Room>(
-            "kitchen",
-            "Kitchen",
-            "You are in the kitchen of the white house. A table seems to "
-            "have been used recently for the preparation of food. A passage "
-            "leads to the west and a dark staircase can be seen leading upward."
-        );
-        
-        rooms_["living_room"] = std::make_shared<Room>(
-            "living_room",
-            "Living Room",
-            "You are in the living room. There is a doorway to the east, "
-            "a wooden door with strange gothic lettering to the west, which "
-            "appears to be nailed shut, and a large oriental rug in the center "
-            "of the room."
-        );
-        
-        rooms_["attic"] = std::make_shared<Room>(
-            "attic",
-            "Attic",
-            "This is the attic. The only exit is a stairway leading down. "
-            "A large coil of rope is lying in the corner."
-        );
-        
-        rooms_["cellar"] = std::make_shared<Room>(
-            "cellar",
-            "Cellar",
-            "You are in a dark and damp cellar with a narrow passageway "
-            "leading north, and a crawlway to the south. On the west is "
-            "the bottom of a steep metal ramp which is unclimbable."
-        );
-        
-        // Mark cellar as dark initially
-        rooms_["cellar"]->setLit(false);
-    }
-    
-    void Game::createItems() {
-        // West of house items
-        auto mailbox = std::make_shared<Item>("mailbox", 
-            "A small mailbox. It can be opened.", 50, false);
-        rooms_["west_of_house"]->addItem(mailbox);
-        
-        auto leaflet = std::make_shared<Item>("leaflet", 
-            "A small leaflet that reads: 'Welcome to Zork!'", 1);
-        rooms_["west_of_house"]->addItem(leaflet);
-        
-        // Kitchen items
-        auto lamp = std::make_shared<Item>("lamp", 
-            "A brass lantern that might provide light.", 3);
-        rooms_["kitchen"]->addItem(lamp);
-        
-        // Attic items
-        auto rope = std::make_shared<Item>("rope", 
-            "A sturdy coil of rope.", 5);
-        rooms_["attic"]->addItem(rope);
-        
-        // Living room items
-        auto sword = std::make_shared<Item>("sword", 
-            "An elvish sword of great antiquity.", 8, true, ItemType::WEAPON);
-        sword->setDamage(15);
-        sword->setValue(100);
-        rooms_["living_room"]->addItem(sword);
-        
-        // TODO: Add more complex items and puzzle objects
-        // Need keys, locked doors, combinable items, etc.
-    }
-    
-    void Game::connectRooms() {
-        // West of house connections
-        rooms_["west_of_house"]->addExit("north", rooms_["forest"]);
-        rooms_["west_of_house"]->addExit("south", rooms_["behind_house"]);
-        
-        // Forest connections (loops back to itself)
-        rooms_["forest"]->addExit("south", rooms_["west_of_house"]);
-        rooms_["forest"]->addExit("east", rooms_["west_of_house"]);
-        rooms_["forest"]->addExit("west", rooms_["forest"]);
-        rooms_["forest"]->addExit("north", rooms_["forest"]);
-        
-        // Behind house connections
-        rooms_["behind_house"]->addExit("north", rooms_["west_of_house"]);
-        rooms_["behind_house"]->addExit("east", rooms_["kitchen"]);
-        
-        // Kitchen connections
-        rooms_["kitchen"]->addExit("west", rooms_["behind_house"]);
-        rooms_["kitchen"]->addExit("east", rooms_["living_room"]);
-        rooms_["kitchen"]->addExit("up", rooms_["attic"]);
-        rooms_["kitchen"]->addExit("down", rooms_["cellar"]);
-        
-        // Living room connections
-        rooms_["living_room"]->addExit("west", rooms_["kitchen"]);
-        
-        // Attic connections
-        rooms_["attic"]->addExit("down", rooms_["kitchen"]);
-        
-        // Cellar connections
-        rooms_["cellar"]->addExit("up", rooms_["kitchen"]);
+        setRules(embeddedRules());
+        bindEmbeddedWorld(EMBEDDED_WORLD);
+        player_->setRoomResolver([this](const std::string& roomId) { return getRoom(roomId); });
+    }
+    
+    void Game::bindEmbeddedWorld(const EmbeddedWorld& world) {
+        std::vector<RoomPtr> rooms;
+        rooms.reserve(world.roomCount);
+        for (size_t i = 0; i < world.roomCount; ++i) {
+            const EmbeddedRoom& entry = world.rooms[i];
+            auto room = worldArena_.makeShared<Room>(entry.id, entry.name, entry.description);
+            room->setLit(entry.lit);
+            room->setLocked(entry.locked);
+            rooms_[entry.id] = room;
+            rooms.push_back(std::move(room));
+        }
+        
+        for (size_t i = 0; i < world.roomCount; ++i) {
+            const EmbeddedRoom& entry = world.rooms[i];
+            for (uint32_t e = entry.firstExit; e < entry.firstExit + entry.exitCount; ++e) {
+                rooms[i]->addExit(world.exits[e].direction, rooms[world.exits[e].room]);
+            }
+        }
+        
+        for (size_t i = 0; i < world.itemCount; ++i) {
+            const EmbeddedItem& entry = world.items[i];
+            if (entry.room == EmbeddedWorld::NO_ROOM) {
+                continue;
+            }
+            auto item = worldArena_.makeShared<Item>(entry.name, entry.description,
+                                                     entry.weight, entry.takeable, entry.type);
+            item->setValue(entry.value);
+            item->setDamage(entry.damage);
+            item->setDefense(entry.defense);
+            item->setLightSource(entry.lightSource);
+            item->setLightOn(entry.lightOn);
+            item->setFuel(entry.fuel);
+            item->setLightRadius(entry.lightRadius);
+            lighting_.track(item);
+            rooms[entry.room]->addItem(std::move(item));
+        }
+        
+        player_ = worldArena_.makeShared<Player>("Adventurer", rooms[world.startRoom]);
     }
     
     RoomPtr Game::getRoom(const std::string& roomId) {
         if (rooms_.find(roomId) != rooms_.end()) {
             return rooms_[roomId];
         }
+        if (pager_) {
+            return pager_->getRoom(roomId);
+        }
         return nullptr;
     }
     
+    void Game::enablePaging(std::unique_ptr<RegionSource> source, size_t maxResidentRegions,
+                            const std::string& entrance) {
+        pager_ = std::make_unique<WorldPager>(std::move(source), maxResidentRegions);
+        pagerEntrance_ = entrance;
+        connectPager();
+    }
+    
+    void Game::connectPager() {
+        // Also called once the world is (re)built; before that there is no
+        // entrance room to connect
+        auto room = rooms_.find(pagerEntrance_);
+        if (pager_ && room != rooms_.end()) {
+            room->second->addRemoteExit(Constants::DIR_DOWN, pager_->entryRoom());
+        }
+    }
+    
     void Game::addRoom(RoomPtr room) {
         rooms_[room->getId()] = room;
     }
     
+    SnapshotPtr Game::snapshot() const {
+        auto snap = std::make_shared<WorldSnapshot>();
+        std::unordered_map<const Room*, uint32_t> roomIndex;
+        std::unordered_map<const Item*, uint32_t> itemIndex;
+        
+        auto indexItem = [&](const ItemPtr& item) {
+            auto found = itemIndex.find(item.get());
+            if (found != itemIndex.end()) {
+                return found->second;
+            }
+            uint32_t index = static_cast<uint32_t>(snap->items.size());
+            itemIndex.emplace(item.get(), index);
+            snap->items.push_back({item->getName(), item->getDescription(),
+                                   item->getWeight(), item->isTakeable(),
+                                   item->getType(), item->getValue(),
+                                   item->getDamage(), item->getDefense(),
+                                   item->isLightSource(), item->isLightOn(),
+                                   item->getFuel(), item->getLightRadius()});
+            return index;
+        };
+        
+        snap->rooms.reserve(rooms_.size());
+        for (const auto& pair : rooms_) {
+            roomIndex.emplace(pair.second.get(), static_cast<uint32_t>(snap->rooms.size()));
+            const Room& room = *pair.second;
+            RoomImage image{room.getId(), room.getName(), room.getDescription(),
+                            room.isVisited(), room.isLit(), room.isLocked(), {}, {}};
+            for (const auto& item : room.getItems()) {
+                image.items.push_back(indexItem(item));
+            }
+            snap->rooms.push_back(std::move(image));
+        }
+        
+        // Second pass once every room has an index
+        for (const auto& pair : rooms_) {
+            RoomImage& image = snap->rooms[roomIndex[pair.second.get()]];
+            for (const std::string& direction : pair.second->getExits()) {
+                auto target = roomIndex.find(pair.second->getExit(direction).get());
+                if (target != roomIndex.end()) {
+                    image.exits.emplace_back(direction, target->second);
+                }
+            }
+        }
+        
+        if (player_) {
+            snap->playerName = player_->getName();
+            // Paged rooms are not in the snapshot. A player down there comes
+            // back up the way in, or failing that to the start of the world.
+            auto here = roomIndex.find(player_->getCurrentRoom().get());
+            if (here == roomIndex.end()) {
+                auto entrance = rooms_.find(pagerEntrance_);
+                if (entrance == rooms_.end()) {
+                    entrance = rooms_.find(EMBEDDED_WORLD.rooms[EMBEDDED_WORLD.startRoom].id);
+                }
+                here = entrance != rooms_.end() ? roomIndex.find(entrance->second.get()) : roomIndex.end();
+            }
+            snap->playerRoom = here != roomIndex.end() ? here->second : 0;
+            snap->playerHealth = player_->getHealth();
+            for (const auto& item : player_->getInventory()) {
+                snap->inventory.push_back(indexItem(item));
+            }
+        }
+        
+        if (currentEnemy_) {
+            snap->hasEnemy = true;
+            snap->enemy = {currentEnemy_->getName(), currentEnemy_->getDescription(),
+                           currentEnemy_->getHealth(), currentEnemy_->getMaxHealth(),
+                           currentEnemy_->getAttackPower(), currentEnemy_->getDefense(),
+                           currentEnemy_->getExperienceReward(), currentEnemy_->getIsHostile()};
+        }
+        
+        snap->inCombat = inCombat_;
+        snap->score = score_;
+        snap->moves = moves_;
+        snap->rng = rng_;
+        snap->rules = rules_;
+        if (rules_) {
+            for (size_t i = 0; i < ruleFlags_.size(); ++i) {
+                if (ruleFlags_[i]) {
+                    snap->flags.push_back(rules_->getFlagName(i));
+                }
+            }
+        }
+        return snap;
+    }
+    
+    void Game::restoreSnapshot(const WorldSnapshot& snapshot) {
+        std::vector<ItemPtr> items;
+        items.reserve(snapshot.items.size());
+        for (const ItemImage& image : snapshot.items) {
+            auto item = worldArena_.makeShared<Item>(image.name, image.description,
+                                                     image.weight, image.takeable, image.type);
+            item->setValue(image.value);
+            item->setDamage(image.damage);
+            item->setDefense(image.defense);
+            item->setLightSource(image.lightSource);
+            item->setLightOn(image.lightOn);
+            item->setFuel(image.fuel);
+            item->setLightRadius(image.lightRadius);
+            lighting_.track(item);
+            items.push_back(std::move(item));
+        }
+        
+        std::vector<RoomPtr> rooms;
+        rooms.reserve(snapshot.rooms.size());
+        for (const RoomImage& image : snapshot.rooms) {
+            auto room = worldArena_.makeShared<Room>(image.id, image.name, image.description);
+            room->setVisited(image.visited);
+            room->setLit(image.lit);
+            room->setLocked(image.locked);
+            for (uint32_t index : image.items) {
+                room->addItem(items[index]);
+            }
+            // Images are sorted by id, so every insert lands at the end
+            rooms_.emplace_hint(rooms_.end(), image.id, room);
+            rooms.push_back(std::move(room));
+        }
+        
+        for (size_t i = 0; i < snapshot.rooms.size(); ++i) {
+            for (const auto& exit : snapshot.rooms[i].exits) {
+                rooms[i]->addExit(exit.first, rooms[exit.second]);
+            }
+        }
+        
+        if (!rooms.empty()) {
+            player_ = worldArena_.makeShared<Player>(snapshot.playerName, rooms[snapshot.playerRoom]);
+            player_->setHealth(snapshot.playerHealth);
+            std::vector<ItemPtr> inventory;
+            inventory.reserve(snapshot.inventory.size());
+            for (uint32_t index : snapshot.inventory) {
+                inventory.push_back(items[index]);
+            }
+            player_->setInventory(std::move(inventory));
+            player_->setRoomResolver([this](const std::string& roomId) { return getRoom(roomId); });
+        }
+        
+        if (snapshot.hasEnemy) {
+            const EnemyImage& image = snapshot.enemy;
+            currentEnemy_ = worldArena_.makeShared<Enemy>(image.name, image.description,
+                                                          image.maxHealth, image.attackPower,
+                                                          image.defense);
+            currentEnemy_->setHealth(image.health);
+            currentEnemy_->setExperienceReward(image.experienceReward);
+            currentEnemy_->setIsHostile(image.hostile);
+        }
+        
+        inCombat_ = snapshot.inCombat;
+        score_ = snapshot.score;
+        moves_ = snapshot.moves;
+        rng_ = snapshot.rng;
+        
+        setRules(snapshot.rules);
+        for (const std::string& flag : snapshot.flags) {
+            int index = rules_ ? rules_->findFlag(flag) : -1;
+            if (index >= 0) {
+                ruleFlags_[index] = 1;
+            }
+        }
+    }
+    
+    void Game::setRules(RuleProgramPtr rules) {
+        rules_ = std::move(rules);
+        ruleFlags_.assign(rules_ ? rules_->getFlagCount() : 0, 0);
+    }
+    
+    RuleOutcome Game::runRule(const std::string& verb, const std::string& item,
+                              const std::string& with, std::string& message) {
+        if (!rules_) {
+            return RuleOutcome::NO_RULE;
+        }
+        return rules_->execute(*this, ruleFlags_, verb, item, with, message);
+    }
+    
+    void Game::addTrigger(const std::string& room, const std::string& event,
+                          const std::string& object, TriggerCallback callback) {
+        triggerHooks_.add(room, event, object, static_cast<uint32_t>(triggerCallbacks_.size()));
+        triggerCallbacks_.push_back(std::move(callback));
+    }
+    
+    size_t Game::fireTriggers(const std::string& event, const std::string& object, std::string& message) {
+        const std::string& room = player_->getCurrentRoom()->getId();
+        size_t fired = rules_ ? rules_->fireTriggers(*this, ruleFlags_, room, event, object, message) : 0;
+        
+        if (!triggerHooks_.empty()) {
+            std::vector<uint32_t> matched;
+            triggerHooks_.match(room, event, object, matched);
+            for (uint32_t index : matched) {
+                triggerCallbacks_[index](*this, message);
+            }
+            fired += matched.size();
+        }
+        return fired;
+    }
+    
+    void Game::setWorldSource(const WorldWatcher* source) {
+        worldSource_ = source;
+        worldVersion_ = source ? source->getVersion() : 0;
+    }
+    
+    void Game::migrateWorld() {
+        // Read the version first: a racing publish just means one more migration
+        worldVersion_ = worldSource_->getVersion();
+        SnapshotPtr next = worldSource_->current();
+        if (!next) {
+            return;
+        }
+        
+        GameState state;
+        exportState(state);
+        std::mt19937 rng = rng_;
+        
+        releaseWorld();
+        restoreSnapshot(*next);
+        connectPager();
+        importState(state);
+        rng_ = rng;
+        
+        print("\n[The world shimmers for a moment and settles into a new shape.]\n");
+    }
+    
+    void Game::exportState(GameState& state) const {
+        state.playerName = player_->getName();
+        state.currentRoomId = player_->getCurrentRoom()->getId();
+        state.health = player_->getHealth();
+        state.score = score_;
+        state.moves = moves_;
+        
+        state.inventory.clear();
+        state.lights.clear();
+        for (const auto& item : player_->getInventory()) {
+            state.inventory.push_back(item->getName());
+            if (item->isLightSource()) {
+                state.lights[item->getName()] = {item->isLightOn(), item->getFuel()};
+            }
+        }
+        
+        state.flags.clear();
+        if (rules_) {
+            for (size_t i = 0; i < ruleFlags_.size(); ++i) {
+                if (ruleFlags_[i]) {
+                    state.flags.push_back(rules_->getFlagName(i));
+                }
+            }
+        }
+        
+        // Only visited rooms can have been changed by the player
+        state.visitedRooms.clear();
+        state.roomItems.clear();
+        for (const auto& pair : rooms_) {
+            if (!pair.second->isVisited()) {
+                continue;
+            }
+            state.visitedRooms[pair.first] = true;
+            std::vector<std::string>& names = state.roomItems[pair.first];
+            for (const auto& item : pair.second->getItems()) {
+                names.push_back(item->getName());
+                if (item->isLightSource()) {
+                    state.lights[item->getName()] = {item->isLightOn(), item->getFuel()};
+                }
+            }
+        }
+    }
+    
+    void Game::importState(const GameState& state) {
+        using Claim = std::pair<ItemPtr, RoomPtr>;
+        std::unordered_map<std::string, std::vector<Claim>> pool;
+        std::unordered_map<std::string, size_t> needed;
+        
+        for (const auto& name : state.inventory) {
+            needed[name]++;
+        }
+        for (const auto& entry : state.roomItems) {
+            for (const auto& name : entry.second) {
+                needed[name]++;
+            }
+        }
+        
+        // Rooms described by the state are rebuilt from scratch...
+        for (const auto& entry : state.roomItems) {
+            RoomPtr room = getRoom(entry.first);
+            if (!room) {
+                continue;
+            }
+            // removeItem edits the list getItems() refers to; walk a copy
+            std::vector<ItemPtr> items = room->getItems();
+            for (const auto& item : items) {
+                room->removeItem(item);
+                pool[item->getName()].emplace_back(item, room);
+            }
+        }
+        
+        // ...and anything else they claim is pulled from wherever it now lives
+        for (const auto& pair : rooms_) {
+            if (state.roomItems.count(pair.first)) {
+                continue;
+            }
+            std::vector<ItemPtr> items = pair.second->getItems();
+            for (const auto& item : items) {
+                auto want = needed.find(item->getName());
+                if (want != needed.end() && pool[item->getName()].size() < want->second) {
+                    pair.second->removeItem(item);
+                    pool[item->getName()].emplace_back(item, pair.second);
+                }
+            }
+        }
+        
+        auto claim = [&](const std::string& name) -> ItemPtr {
+            auto found = pool.find(name);
+            if (found == pool.end() || found->second.empty()) {
+                return nullptr;
+            }
+            ItemPtr item = found->second.front().first;
+            found->second.erase(found->second.begin());
+            return item;
+        };
+        
+        // Claimed light sources keep burning where they left off
+        auto relight = [&](const ItemPtr& item) {
+            auto light = state.lights.find(item->getName());
+            if (light != state.lights.end() && item->isLightSource()) {
+                item->setLightOn(light->second.first);
+                item->setFuel(light->second.second);
+                lighting_.track(item);
+            }
+        };
+        
+        std::vector<ItemPtr> inventory;
+        for (const auto& name : state.inventory) {
+            if (ItemPtr item = claim(name)) {
+                relight(item);
+                inventory.push_back(item);
+            }
+        }
+        player_->setInventory(std::move(inventory));
+        
+        for (const auto& entry : state.roomItems) {
+            RoomPtr room = getRoom(entry.first);
+            if (!room) {
+                continue;
+            }
+            for (const auto& name : entry.second) {
+                if (ItemPtr item = claim(name)) {
+                    relight(item);
+                    room->addItem(item);
+                }
+            }
+        }
+        
+        // New content nobody claimed goes back where the template put it
+        for (auto& entry : pool) {
+            for (auto& leftover : entry.second) {
+                leftover.second->addItem(leftover.first);
+            }
+        }
+        
+        for (const auto& entry : state.visitedRooms) {
+            if (RoomPtr room = getRoom(entry.first)) {
+                room->setVisited(entry.second);
+            }
+        }
+        
+        if (RoomPtr room = getRoom(state.currentRoomId)) {
+            player_->setCurrentRoom(room);
+        }
+        player_->setHealth(state.health);
+        if (!state.playerName.empty()) {
+            player_->setName(state.playerName);
+        }
+        score_ = state.score;
+        moves_ = state.moves;
+        reportedScore_ = score_;
+        lighting_.invalidateAll();
+        
+        // Flag indices can change between rule sets; match by name
+        std::fill(ruleFlags_.begin(), ruleFlags_.end(), 0);
+        for (const std::string& flag : state.flags) {
+            int index = rules_ ? rules_->findFlag(flag) : -1;
+            if (index >= 0) {
+                ruleFlags_[index] = 1;
+            }
+        }
+    }
+    
+    std::unique_ptr<Game> Game::clone() const {
+        return std::make_unique<Game>(*snapshot());
+    }
+    
     void Game::start() {
-        setupWorld();
+        // Forked games arrive with their world already built
+        if (rooms_.empty()) {
+            setupWorld();
+            connectPager();
+        }
         running_ = true;
         
         displayWelcome();
         displayRoom();
+        flushOutput();
     }
     
     void Game::run() {
@@ -180,48 +578,118 @@ namespace Zork {
         }
     }
     
+    bool Game::isRoomLit(const RoomPtr& room) {
+        return lighting_.isLit(*room, player_.get());
+    }
+    
+    bool Game::setLightOn(const ItemPtr& item, bool on) {
+        // Rules only reach items the player holds or can see
+        RoomPtr here = player_->getCurrentRoom();
+        return lighting_.setLightOn(item, on, here.get());
+    }
+    
+    void Game::checkGrue() {
+        if (!running_ || inCombat_ || isRoomLit(player_->getCurrentRoom())) {
+            darkTurns_ = 0;
+            return;
+        }
+        if (++darkTurns_ > Constants::GRUE_GRACE_TURNS &&
+            Utils::randomInt(1, 100) <= Constants::GRUE_CHANCE) {
+            print("\nOh, no! You have walked into the slavering fangs of a lurking grue!\n");
+            gameOver(false);
+        }
+    }
+    
     void Game::displayRoom() {
         RoomPtr room = player_->getCurrentRoom();
-        
-        std::cout << room->getFullDescription();
-        
-        if (room->isLit()) {
-            std::cout << room->getItemsList();
-            
-            std::vector<std::string> exits = room->getExits();
-            if (!exits.empty()) {
-                std::cout << "Exits: " << Utils::join(exits, ", ") << std::endl;
-            }
-        }
+        RenderPtr text = room->render(isRoomLit(room));
+        print(*text);
         
         // Award points for discovering new rooms
         if (!room->isVisited()) {
             addScore(Constants::SCORE_ROOM_DISCOVERED);
+            room->setVisited(true);
         }
     }
     
-    void Game::processCommand(const std::string& input) {
-        CommandResult result = parser_->parse(input);
+    CommandResult Game::processCommand(const std::string& input) {
+        return processCommands(CommandParser::parsePipeline(input));
+    }
+    
+    CommandResult Game::processCommands(const std::vector<Command>& commands) {
+        if (worldSource_ && worldSource_->getVersion() != worldVersion_) {
+            migrateWorld();
+        }
         
-        if (!result.message.empty()) {
-            std::cout << result.message << std::endl;
+        Utils::RandomScope randomScope(rng_);
+        CommandResult last(true, "", running_);
+        bool wasRunning = running_;
+        
+        // "n. e, take lamp then u" runs as four turns with one flush; the
+        // batch stops at the first command that fails or starts a fight
+        for (const Command& command : commands) {
+            bool wasInCombat = inCombat_;
+            ruleEffects_.clear();
+            CommandResult result = parser_->execute(command);
+            
+            if (!result.message.empty()) {
+                print(result.message);
+                print("\n");
+            }
+            
+            if (!result.continueGame) {
+                running_ = false;
+            }
+            
+            std::string notices;
+            lighting_.tick(*player_, notices);
+            if (!notices.empty()) {
+                print(notices);
+                print("\n");
+            }
+            checkGrue();
+            
+            last = std::move(result);
+            last.continueGame = running_;
+            if (!last.success || !running_ || (inCombat_ && !wasInCombat)) {
+                break;
+            }
         }
         
-        if (!result.continueGame) {
-            running_ = false;
+        // Reported at the end of the turn, once score and moves are final;
+        // quitting counts as finishing
+        if (scoreObserver_ && wasRunning && !running_) {
+            scoreObserver_(*this, true);
+        } else if (scoreObserver_ && running_ && score_ >= reportedScore_ + Constants::SCORE_MILESTONE) {
+            reportedScore_ = score_;
+            scoreObserver_(*this, false);
         }
+        
+        flushOutput();
+        scratchArena_.reset();
+        return last;
+    }
+    
+    void Game::flushOutput() {
+        if (out_ && !output_.empty()) {
+            out_->write(output_.data(), static_cast<std::streamsize>(output_.size()));
+            out_->flush();
+            output_.clear();
+        }
+    }
+    
+    std::string Game::takeOutput() {
+        std::string text;
+        text.swap(output_);
+        return text;
     }
     
     void Game::gameOver(bool victory) {
-        Utils::printSeparator('=');
-        if (victory) {
-            std::cout << "Congratulations! You have won the game!\n";
-        } else {
-            std::cout << "GAME OVER\n";
-        }
-        std::cout << "Your final score: " << score_ << " points in " 
-                  << moves_ << " moves.\n";
-        Utils::printSeparator('=');
+        print(Utils::separator('='));
+        print(victory ? "Congratulations! You have won the game!\n" : "GAME OVER\n");
+        print("Your final score: " + std::to_string(score_) + " points in " +
+              std::to_string(moves_) + " moves.\n");
+        print(Utils::separator('='));
         running_ = false;
     }
     
@@ -229,7 +697,7 @@ namespace Zork {
         // TODO: Implement full combat system with turn-based mechanics
         currentEnemy_ = enemy;
         inCombat_ = true;
-        std::cout << "Combat with " << enemy->getName() << " begins!\n";
+        print("Combat with " + enemy->getName() + " begins!\n");
     }
     
     void Game::processCombatTurn(const std::string& action) {
@@ -237,11 +705,170 @@ namespace Zork {
     }
     
     void Game::endCombat(bool playerVictory) {
+        Delta delta(DeltaType::COMBAT);
+        delta.enemy = currentEnemy_;
+        delta.wasInCombat = inCombat_;
+        
         inCombat_ = false;
         if (playerVictory) {
             addScore(Constants::SCORE_ENEMY_DEFEATED);
+            delta.scoreDelta = Constants::SCORE_ENEMY_DEFEATED;
         }
         currentEnemy_ = nullptr;
+        recordDelta(std::move(delta));
+    }
+    
+    void Game::recordDelta(Delta delta) {
+        delta.effects = std::move(ruleEffects_);
+        ruleEffects_.clear();
+        history_.record(std::move(delta));
+    }
+    
+    void Game::applyEffect(const RuleEffect& effect, bool forward) {
+        bool value = forward ? effect.after : effect.before;
+        switch (effect.kind) {
+            case RuleEffect::Kind::FLAG:
+                if (effect.flag < ruleFlags_.size()) {
+                    ruleFlags_[effect.flag] = value;
+                }
+                break;
+            case RuleEffect::Kind::LIT:
+            case RuleEffect::Kind::LOCKED: {
+                RoomPtr room = getRoom(effect.room->getId());
+                if (!room) {
+                    room = effect.room;
+                }
+                if (effect.kind == RuleEffect::Kind::LIT) {
+                    room->setLit(value);
+                } else {
+                    room->setLocked(value);
+                }
+                break;
+            }
+            case RuleEffect::Kind::CONSUMED:
+                if (value) {
+                    player_->removeInventoryItem(effect.item);
+                } else {
+                    player_->addInventoryItem(effect.item);
+                }
+                break;
+            case RuleEffect::Kind::LIGHT:
+                lighting_.setLightOn(effect.item, value, nullptr);
+                break;
+        }
+    }
+    
+    void Game::applyDelta(const Delta& delta, bool forward) {
+        int sign = forward ? 1 : -1;
+        score_ += sign * delta.scoreDelta;
+        moves_ += sign * delta.movesDelta;
+        
+        // Rule effects followed the command itself; undo them first
+        if (!forward) {
+            for (auto effect = delta.effects.rbegin(); effect != delta.effects.rend(); ++effect) {
+                applyEffect(*effect, false);
+            }
+        }
+        
+        switch (delta.type) {
+            case DeltaType::MOVE: {
+                // Paged rooms may have been evicted and rebuilt since
+                const RoomPtr& recorded = forward ? delta.toRoom : delta.fromRoom;
+                RoomPtr target = getRoom(recorded->getId());
+                player_->setCurrentRoom(target ? target : recorded);
+                if (delta.firstVisit) {
+                    RoomPtr visited = getRoom(delta.toRoom->getId());
+                    (visited ? visited : delta.toRoom)->setVisited(forward);
+                }
+                break;
+            }
+            case DeltaType::TAKE:
+            case DeltaType::DROP: {
+                // As for MOVE, the recorded room may have been paged out
+                RoomPtr room = getRoom(delta.toRoom->getId());
+                if (!room) {
+                    room = delta.toRoom;
+                }
+                if (forward == (delta.type == DeltaType::TAKE)) {
+                    room->removeItem(delta.item);
+                    player_->addInventoryItem(delta.item);
+                } else {
+                    player_->removeInventoryItem(delta.item);
+                    room->addItem(delta.item);
+                }
+                break;
+            }
+            case DeltaType::COMBAT:
+                inCombat_ = forward ? false : delta.wasInCombat;
+                currentEnemy_ = forward ? nullptr : delta.enemy;
+                break;
+            case DeltaType::RULE:
+                break;
+        }
+        
+        if (forward) {
+            for (const RuleEffect& effect : delta.effects) {
+                applyEffect(effect, true);
+            }
+        }
+    }
+    
+    bool Game::undo(std::string& message) {
+        const Delta* delta = history_.undo();
+        if (!delta) {
+            message = "There is nothing to undo.";
+            return false;
+        }
+        
+        applyDelta(*delta, false);
+        switch (delta->type) {
+            case DeltaType::MOVE:
+                message = "You retrace your steps.";
+                displayRoom();
+                break;
+            case DeltaType::TAKE:
+                message = "You put the " + delta->item->getName() + " back.";
+                break;
+            case DeltaType::DROP:
+                message = "You pick the " + delta->item->getName() + " back up.";
+                break;
+            case DeltaType::COMBAT:
+                message = "The fight is not over after all.";
+                break;
+            case DeltaType::RULE:
+                message = "What you did comes undone.";
+                break;
+        }
+        return true;
+    }
+    
+    bool Game::redo(std::string& message) {
+        const Delta* delta = history_.redo();
+        if (!delta) {
+            message = "There is nothing to redo.";
+            return false;
+        }
+        
+        applyDelta(*delta, true);
+        switch (delta->type) {
+            case DeltaType::MOVE:
+                message = "You head back the way you came.";
+                displayRoom();
+                break;
+            case DeltaType::TAKE:
+                message = "You take the " + delta->item->getName() + " again.";
+                break;
+            case DeltaType::DROP:
+                message = "You drop the " + delta->item->getName() + " again.";
+                break;
+            case DeltaType::COMBAT:
+                message = "The fight ends as it did before.";
+                break;
+            case DeltaType::RULE:
+                message = "You do it again.";
+                break;
+        }
+        return true;
     }
     
     bool Game::saveGame(const std::string& filename) {
@@ -255,21 +882,21 @@ namespace Zork {
     }
     
     void Game::displayWelcome() {
-        Utils::printSeparator('=');
-        Utils::printCentered("ZORK - A Text Adventure Game");
-        Utils::printSeparator('=');
-        std::cout << "\nWelcome to Zork! You are about to embark on a great adventure.\n";
-        std::cout << "Type 'help' for a list of commands.\n";
+        print(Utils::separator('='));
+        print(Utils::centered("ZORK - A Text Adventure Game"));
+        print(Utils::separator('='));
+        print("\nWelcome to Zork! You are about to embark on a great adventure.\n");
+        print("Type 'help' for a list of commands.\n");
     }
     
     void Game::displayHelp() {
-        std::cout << parser_->getHelpText();
+        print(parser_->getHelpText());
     }
     
     void Game::displayScore() {
-        std::cout << "\n=== Score ===\n";
-        std::cout << "Current score: " << score_ << " points\n";
-        std::cout << "Moves taken: " << moves_ << "\n";
-        std::cout << "=============\n";
+        print("\n=== Score ===\n");
+        print("Current score: " + std::to_string(score_) + " points\n");
+        print("Moves taken: " + std::to_string(moves_) + "\n");
+        print("=============\n");
     }
 }
@@ -0,0 +1,365 @@
+#include "../include/GameServer.h"
+#include "../include/Json.h"
+#include "../include/Constants.h"
+#include "../include/Utils.h"
+#include <algorithm>
+
+namespace Zork {
+
+    namespace {
+        const std::string SESSION_PREFIX = "/session";
+        const std::string COMMAND_SUFFIX = "/command";
+        const std::string LEADERBOARD_PREFIX = "/leaderboard";
+        const size_t DEFAULT_LEADERBOARD_LIMIT = 10;
+        const size_t MAX_LEADERBOARD_LIMIT = 100;
+        const size_t MAX_NAME_LENGTH = 32;
+
+        // Value of key in an undecoded query string, or "" if absent
+        std::string queryValue(const std::string& query, const std::string& key) {
+            for (const std::string& pair : Utils::split(query, '&')) {
+                if (pair.size() > key.size() && pair.compare(0, key.size(), key) == 0 && pair[key.size()] == '=') {
+                    return pair.substr(key.size() + 1);
+                }
+            }
+            return "";
+        }
+
+        void appendEntry(std::string& json, size_t rank, const LeaderboardEntry& entry) {
+            json += "{\"rank\":";
+            json += std::to_string(rank);
+            json += ",\"player\":\"";
+            json += JsonValue::escape(entry.player);
+            json += "\",\"score\":";
+            json += std::to_string(entry.score);
+            json += ",\"moves\":";
+            json += std::to_string(entry.moves);
+            json += "}";
+        }
+    }
+
+    GameServer::GameServer(SessionManager& sessions, ThreadPool* pool, Leaderboard* leaderboard)
+        : sessions_(sessions), pool_(pool), leaderboard_(leaderboard),
+          http_([this](const HttpRequest& request, HttpReply reply) { handle(request, reply); }),
+          sweeping_(false), hibernateAfter_(0),
+          sessionLimiter_(Constants::SESSION_COMMAND_RATE, Constants::SESSION_COMMAND_BURST),
+          addressLimiter_(Constants::ADDRESS_REQUEST_RATE, Constants::ADDRESS_REQUEST_BURST),
+          admission_(Constants::MAX_IN_FLIGHT, Constants::MAX_P99_MS) {
+        http_.setIdleCallback([this]() { housekeeping(); }, Constants::IDLE_CHECK_INTERVAL_MS);
+    }
+
+    void GameServer::setHibernateAfter(int seconds) {
+        hibernateAfter_ = std::chrono::seconds(std::max(seconds, 0));
+        int interval = Constants::IDLE_CHECK_INTERVAL_MS;
+        if (seconds > 0) {
+            interval = std::min(interval, seconds * 1000);
+        }
+        http_.setIdleCallback([this]() { housekeeping(); }, interval);
+    }
+
+    void GameServer::setRateLimits(double sessionRate, double sessionBurst, double addressRate, double addressBurst) {
+        sessionLimiter_.configure(sessionRate, sessionBurst);
+        addressLimiter_.configure(addressRate, addressBurst);
+    }
+
+    void GameServer::setAdmissionLimits(size_t maxInFlight, int maxP99Ms) {
+        admission_.configure(maxInFlight, maxP99Ms);
+    }
+
+    void GameServer::housekeeping() {
+        admission_.tick();
+        sessionLimiter_.prune();
+        addressLimiter_.prune();
+
+        if (hibernateAfter_.count() == 0) {
+            return;
+        }
+        // One sweep at a time; a slow disk must not pile them up
+        if (sweeping_.exchange(true)) {
+            return;
+        }
+        auto sweep = [this, maxIdle = hibernateAfter_]() {
+            sessions_.hibernateIdle(maxIdle);
+            sweeping_ = false;
+        };
+        if (pool_) {
+            pool_->submit(sweep);
+        } else {
+            sweep();
+        }
+    }
+
+    void GameServer::error(HttpResponse& response, int status, const std::string& message) {
+        response.status = status;
+        response.body = "{\"error\":\"" + JsonValue::escape(message) + "\"}";
+    }
+
+    std::string GameServer::replyJson(const TurnReply& reply, const std::string& sessionId) {
+        std::string json;
+        json.reserve(128 + reply.output.size() + reply.roomName.size());
+        json += "{";
+        if (!sessionId.empty()) {
+            json += "\"session\":\"";
+            json += sessionId;
+            json += "\",";
+        }
+        json += "\"success\":";
+        json += reply.result.success ? "true" : "false";
+        json += ",\"message\":\"";
+        json += JsonValue::escape(reply.output);
+        json += "\",\"continueGame\":";
+        json += reply.result.continueGame ? "true" : "false";
+        json += ",\"room\":\"";
+        json += JsonValue::escape(reply.roomName);
+        json += "\",\"roomId\":\"";
+        json += JsonValue::escape(reply.roomId);
+        json += "\",\"score\":";
+        json += std::to_string(reply.score);
+        json += ",\"memory\":";
+        json += std::to_string(reply.memory);
+        json += "}";
+        return json;
+    }
+
+    void GameServer::handleLeaderboard(const HttpRequest& request, HttpResponse& response) {
+        if (request.method != "GET") {
+            error(response, 405, "use GET to read the leaderboard");
+            return;
+        }
+        if (!leaderboard_) {
+            error(response, 404, "no leaderboard");
+            return;
+        }
+
+        const std::string& path = request.path;
+        if (path.size() > LEADERBOARD_PREFIX.size() + 1) {
+            std::string player = path.substr(LEADERBOARD_PREFIX.size() + 1);
+            size_t rank = 0;
+            LeaderboardEntry entry;
+            if (path[LEADERBOARD_PREFIX.size()] != '/' || !leaderboard_->rank(player, rank, entry)) {
+                error(response, 404, "no such player");
+                return;
+            }
+            appendEntry(response.body, rank, entry);
+            return;
+        }
+
+        size_t limit = DEFAULT_LEADERBOARD_LIMIT;
+        std::string requested = queryValue(request.query, "limit");
+        if (!requested.empty()) {
+            limit = std::min(static_cast<size_t>(std::strtoul(requested.c_str(), nullptr, 10)), MAX_LEADERBOARD_LIMIT);
+        }
+
+        std::vector<LeaderboardEntry> entries = leaderboard_->top(limit);
+        std::string& json = response.body;
+        json = "{\"players\":" + std::to_string(leaderboard_->size()) + ",\"top\":[";
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (i > 0) {
+                json += ",";
+            }
+            appendEntry(json, i + 1, entries[i]);
+        }
+        json += "]}";
+    }
+
+    std::string GameServer::metricsJson() {
+        std::string json = "{\"sessions\":" + std::to_string(sessions_.size());
+        json += ",\"resident\":" + std::to_string(sessions_.residentCount());
+        json += ",\"memory\":" + std::to_string(sessions_.memoryBytes());
+        json += ",\"requests\":" + std::to_string(http_.getRequestCount());
+        json += ",\"inFlight\":" + std::to_string(admission_.inFlight());
+        json += ",\"completed\":" + std::to_string(admission_.getCompleted());
+        json += ",\"p50Micros\":" + std::to_string(admission_.p50Micros());
+        json += ",\"p99Micros\":" + std::to_string(admission_.p99Micros());
+        json += ",\"overloaded\":";
+        json += admission_.overloaded() ? "true" : "false";
+        json += ",\"shedSessions\":" + std::to_string(admission_.getShedSessions());
+        json += ",\"shedCommands\":" + std::to_string(admission_.getShedCommands());
+        json += ",\"rateLimitedSessions\":" + std::to_string(sessionLimiter_.getRejected());
+        json += ",\"rateLimitedAddresses\":" + std::to_string(addressLimiter_.getRejected());
+        json += "}";
+        return json;
+    }
+
+    void GameServer::handle(const HttpRequest& request, const HttpReply& reply) {
+        const std::string& path = request.path;
+
+        // Everything but game work is answered right here on the loop
+        HttpResponse response;
+        if (path == "/health") {
+            response.body = "{\"status\":\"ok\",\"sessions\":" + std::to_string(sessions_.size()) +
+                            ",\"resident\":" + std::to_string(sessions_.residentCount()) +
+                            ",\"memory\":" + std::to_string(sessions_.memoryBytes()) + "}";
+            reply.send(std::move(response));
+            return;
+        }
+        if (path == "/metrics") {
+            response.body = metricsJson();
+            reply.send(std::move(response));
+            return;
+        }
+
+        // Every request costs one, whatever its path; handleCommand charges
+        // a pipeline for its other commands once it has been routed there
+        double left = 0;
+        if (!addressLimiter_.tryAcquire(request.peer, 1, left)) {
+            error(response, 429, "too many requests from this address");
+            reply.send(std::move(response));
+            return;
+        }
+
+        if (path.compare(0, LEADERBOARD_PREFIX.size(), LEADERBOARD_PREFIX) == 0) {
+            handleLeaderboard(request, response);
+            reply.send(std::move(response));
+            return;
+        }
+
+        if (path.compare(0, SESSION_PREFIX.size(), SESSION_PREFIX) != 0) {
+            error(response, 404, "not found");
+            reply.send(std::move(response));
+            return;
+        }
+
+        if (path == SESSION_PREFIX) {
+            if (request.method != "POST") {
+                error(response, 405, "use POST to start a session");
+                reply.send(std::move(response));
+                return;
+            }
+            // {"name": "..."} picks the leaderboard name
+            std::string name;
+            JsonValue body;
+            std::string parseError;
+            if (JsonValue::parse(request.body, body, parseError) && body["name"].isString()) {
+                name = Utils::trim(body["name"].asString()).substr(0, MAX_NAME_LENGTH);
+            }
+            if (!admission_.admitSession()) {
+                error(response, 503, "server is overloaded; try again shortly");
+                reply.send(std::move(response));
+                return;
+            }
+            auto create = [this, reply, name, started = std::chrono::steady_clock::now()]() {
+                TurnReply turn;
+                std::string id = sessions_.create(turn, name);
+                HttpResponse created;
+                if (id.empty()) {
+                    error(created, 503, "server is at its memory budget");
+                } else {
+                    created.status = 201;
+                    created.body = replyJson(turn, id);
+                }
+                reply.send(std::move(created));
+                admission_.finished(std::chrono::steady_clock::now() - started);
+            };
+            if (pool_) {
+                pool_->submit(create);
+            } else {
+                create();
+            }
+            return;
+        }
+
+        if (path[SESSION_PREFIX.size()] != '/') {
+            error(response, 404, "not found");
+            reply.send(std::move(response));
+            return;
+        }
+
+        // /session/{id} or /session/{id}/command
+        std::string rest = path.substr(SESSION_PREFIX.size() + 1);
+        bool command = rest.size() > COMMAND_SUFFIX.size() &&
+                       rest.compare(rest.size() - COMMAND_SUFFIX.size(), COMMAND_SUFFIX.size(), COMMAND_SUFFIX) == 0;
+        std::string id = command ? rest.substr(0, rest.size() - COMMAND_SUFFIX.size()) : rest;
+        if (id.empty() || id.find('/') != std::string::npos) {
+            error(response, 404, "not found");
+            reply.send(std::move(response));
+            return;
+        }
+
+        if (!command) {
+            if (request.method != "DELETE") {
+                error(response, 405, "use DELETE to end a session");
+                reply.send(std::move(response));
+                return;
+            }
+            if (!sessions_.remove(id)) {
+                error(response, 404, "no such session");
+            } else {
+                response.status = 204;
+            }
+            reply.send(std::move(response));
+            return;
+        }
+
+        if (request.method != "POST") {
+            error(response, 405, "use POST to send a command");
+            reply.send(std::move(response));
+            return;
+        }
+        handleCommand(request, reply, id, left);
+    }
+
+    void GameServer::handleCommand(const HttpRequest& request, const HttpReply& reply, const std::string& id,
+                                   double addressLeft) {
+        // {"command": "..."}; anything that is not a JSON object is taken
+        // as the command text itself
+        HttpResponse response;
+        std::string text = request.body;
+        JsonValue body;
+        std::string parseError;
+        if (JsonValue::parse(request.body, body, parseError) && body.isObject()) {
+            if (!body["command"].isString()) {
+                error(response, 400, "missing \"command\"");
+                reply.send(std::move(response));
+                return;
+            }
+            text = body["command"].asString();
+        }
+
+        std::vector<Command> commands = CommandParser::parsePipeline(text);
+        double cost = 0;
+        for (const Command& command : commands) {
+            cost += command.getVerb().empty() ? 0 : 1;
+        }
+        cost = std::max(cost, 1.0);
+        if (sessionLimiter_.enabled() && cost > sessionLimiter_.getBurst()) {
+            error(response, 400, "at most " + std::to_string(static_cast<int>(sessionLimiter_.getBurst())) +
+                                 " commands in one request");
+            reply.send(std::move(response));
+            return;
+        }
+
+        double sessionLeft = 0;
+        if (cost > 1 && !addressLimiter_.tryAcquire(request.peer, cost - 1, addressLeft)) {
+            error(response, 429, "too many requests from this address");
+            reply.send(std::move(response));
+            return;
+        }
+        if (!sessionLimiter_.tryAcquire(id, cost, sessionLeft)) {
+            error(response, 429, "too many commands for this session; slow down");
+            reply.send(std::move(response));
+            return;
+        }
+        Priority priority = std::min(addressLeft, sessionLeft) < 0.5 ? Priority::LOW : Priority::NORMAL;
+        if (!admission_.admitCommand(priority)) {
+            error(response, 503, "server is overloaded; try again shortly");
+            reply.send(std::move(response));
+            return;
+        }
+
+        auto started = std::chrono::steady_clock::now();
+        sessions_.submit(id, std::move(commands), [this, reply, started](TurnStatus status, TurnReply& turn) {
+            HttpResponse answer;
+            if (status == TurnStatus::DONE) {
+                answer.body = replyJson(turn, "");
+            } else if (status == TurnStatus::BUSY) {
+                error(answer, 429, "too many commands queued for this session");
+            } else if (status == TurnStatus::OVER_BUDGET) {
+                error(answer, 507, "session exceeded its memory budget and was closed");
+            } else {
+                error(answer, 404, "no such session");
+            }
+            reply.send(std::move(answer));
+            admission_.finished(std::chrono::steady_clock::now() - started);
+        });
+    }
+}
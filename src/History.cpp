@@ -0,0 +1,55 @@
+#include "../include/History.h"
+
+namespace Zork {
+
+    UndoHistory::UndoHistory(size_t capacity)
+        : ring_(capacity == 0 ? 1 : capacity),
+          head_(0),
+          size_(0),
+          cursor_(0) {
+    }
+
+    void UndoHistory::record(Delta delta) {
+        // A new action forks the timeline; the redo tail is gone
+        for (size_t i = cursor_; i < size_; ++i) {
+            ring_[slot(i)] = Delta();
+        }
+        size_ = cursor_;
+
+        if (size_ == ring_.size()) {
+            head_ = slot(1);
+            --size_;
+            --cursor_;
+        }
+
+        ring_[slot(size_)] = std::move(delta);
+        ++size_;
+        ++cursor_;
+    }
+
+    const Delta* UndoHistory::undo() {
+        if (cursor_ == 0) {
+            return nullptr;
+        }
+        --cursor_;
+        return &ring_[slot(cursor_)];
+    }
+
+    const Delta* UndoHistory::redo() {
+        if (cursor_ == size_) {
+            return nullptr;
+        }
+        const Delta* delta = &ring_[slot(cursor_)];
+        ++cursor_;
+        return delta;
+    }
+
+    void UndoHistory::clear() {
+        for (auto& delta : ring_) {
+            delta = Delta();
+        }
+        head_ = 0;
+        size_ = 0;
+        cursor_ = 0;
+    }
+}
@@ -0,0 +1,511 @@
+#include "../include/HttpServer.h"
+#include "../include/Utils.h"
+#include "../include/Constants.h"
+#include <cstring>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+namespace Zork {
+
+    namespace {
+        const int MAX_EVENTS = 256;
+        const size_t READ_CHUNK = 16 * 1024;
+
+        void appendResponse(std::string& out, const HttpResponse& response, bool keepAlive) {
+            out += "HTTP/1.1 ";
+            out += std::to_string(response.status);
+            out += ' ';
+            out += HttpServer::statusText(response.status);
+            out += "\r\nContent-Type: ";
+            out += response.contentType;
+            out += "\r\nContent-Length: ";
+            out += std::to_string(response.body.size());
+            out += keepAlive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+            out += response.body;
+        }
+
+        void appendError(std::string& out, int status, const std::string& message) {
+            HttpResponse response;
+            response.status = status;
+            response.body = "{\"error\":\"" + message + "\"}";
+            appendResponse(out, response, false);
+        }
+    }
+
+    HttpServer::HttpServer(HttpHandler handler)
+        : handler_(std::move(handler)), idleInterval_(0), listenFd_(-1), epollFd_(-1), wakeFd_(-1),
+          port_(0), stopping_(false), nextConnectionId_(0),
+          completions_(Constants::COMPLETION_QUEUE_DEPTH), wakePending_(false), requests_(0) {
+    }
+
+    void HttpReply::send(HttpResponse response) const {
+        server_->requests_.fetch_add(1, std::memory_order_relaxed);
+        if (std::this_thread::get_id() == server_->loopThread_) {
+            server_->complete(fd_, connection_, sequence_, response);
+            return;
+        }
+
+        HttpServer::Completion completion;
+        completion.fd = fd_;
+        completion.connection = connection_;
+        completion.sequence = sequence_;
+        completion.response = std::move(response);
+        // A full ring means the loop is behind; the worker waits rather
+        // than taking on more work
+        while (!server_->completions_.tryPush(std::move(completion))) {
+            std::this_thread::yield();
+        }
+
+#ifdef __linux__
+        // One wakeup per batch: the loop drains everything queued by then
+        if (!server_->wakePending_.exchange(true)) {
+            uint64_t one = 1;
+            ssize_t ignored = write(server_->wakeFd_, &one, sizeof(one));
+            (void)ignored;
+        }
+#endif
+    }
+
+    HttpServer::~HttpServer() {
+#ifdef __linux__
+        for (auto& pair : connections_) {
+            close(pair.first);
+        }
+        if (listenFd_ >= 0) close(listenFd_);
+        if (epollFd_ >= 0) close(epollFd_);
+        if (wakeFd_ >= 0) close(wakeFd_);
+#endif
+    }
+
+    void HttpServer::setIdleCallback(std::function<void()> callback, int intervalMs) {
+        idleCallback_ = std::move(callback);
+        idleInterval_ = std::chrono::milliseconds(intervalMs);
+    }
+
+    bool HttpServer::fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+
+    const char* HttpServer::statusText(int status) {
+        switch (status) {
+            case 200: return "OK";
+            case 201: return "Created";
+            case 204: return "No Content";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 410: return "Gone";
+            case 413: return "Payload Too Large";
+            case 429: return "Too Many Requests";
+            case 501: return "Not Implemented";
+            case 503: return "Service Unavailable";
+            case 507: return "Insufficient Storage";
+            default: return "Internal Server Error";
+        }
+    }
+
+#ifdef __linux__
+
+    bool HttpServer::listen(const std::string& address, uint16_t port) {
+        listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0) {
+            return fail(std::string("socket: ") + std::strerror(errno));
+        }
+        int one = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+            return fail("invalid listen address '" + address + "'");
+        }
+        if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            return fail("bind " + address + ":" + std::to_string(port) + ": " + std::strerror(errno));
+        }
+        if (::listen(listenFd_, SOMAXCONN) != 0) {
+            return fail(std::string("listen: ") + std::strerror(errno));
+        }
+
+        socklen_t length = sizeof(addr);
+        getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &length);
+        port_ = ntohs(addr.sin_port);
+
+        epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd_ < 0 || wakeFd_ < 0) {
+            return fail(std::string("epoll: ") + std::strerror(errno));
+        }
+
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = listenFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+        event.data.fd = wakeFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+        return true;
+    }
+
+    void HttpServer::run() {
+        loopThread_ = std::this_thread::get_id();
+        epoll_event events[MAX_EVENTS];
+        auto nextIdle = std::chrono::steady_clock::now() + idleInterval_;
+        while (!stopping_) {
+            int timeout = -1;
+            if (idleCallback_) {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= nextIdle) {
+                    idleCallback_();
+                    nextIdle = now + idleInterval_;
+                }
+                timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    nextIdle - std::chrono::steady_clock::now()).count()) + 1;
+            }
+            int ready = epoll_wait(epollFd_, events, MAX_EVENTS, timeout);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error_ = std::string("epoll_wait: ") + std::strerror(errno);
+                break;
+            }
+
+            for (int i = 0; i < ready; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wakeFd_) {
+                    uint64_t count;
+                    ssize_t ignored = read(wakeFd_, &count, sizeof(count));
+                    (void)ignored;
+                    drainCompletions();
+                    continue;
+                }
+                if (fd == listenFd_) {
+                    acceptConnections();
+                    continue;
+                }
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(fd);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    readConnection(fd);
+                }
+                if ((events[i].events & EPOLLOUT) && connections_.count(fd)) {
+                    writeConnection(fd);
+                }
+            }
+        }
+    }
+
+    void HttpServer::stop() {
+        stopping_ = true;
+        if (wakeFd_ >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = write(wakeFd_, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    void HttpServer::acceptConnections() {
+        while (true) {
+            sockaddr_in peer;
+            socklen_t peerLength = sizeof(peer);
+            int fd = accept4(listenFd_, reinterpret_cast<sockaddr*>(&peer), &peerLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                // EAGAIN once the backlog is drained; anything else (EMFILE,
+                // ECONNABORTED) is retried on the next readiness event
+                return;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            epoll_event event;
+            std::memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+                close(fd);
+                continue;
+            }
+            Connection& connection = connections_[fd];
+            connection.id = ++nextConnectionId_;
+            char address[INET_ADDRSTRLEN];
+            if (inet_ntop(AF_INET, &peer.sin_addr, address, sizeof(address))) {
+                connection.peer = address;
+            }
+        }
+    }
+
+    void HttpServer::closeConnection(int fd) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections_.erase(fd);
+    }
+
+    void HttpServer::updateInterest(int fd, Connection& connection) {
+        // Reading stops while too many requests are in flight (TCP then
+        // pushes back on the client) and once the connection is closing
+        bool wantRead = !connection.closeAfterWrite && connection.pending.size() < MAX_IN_FLIGHT;
+        bool wantWrite = connection.written < connection.out.size();
+        if (wantRead == connection.watchingRead && wantWrite == connection.watchingWrite) {
+            return;
+        }
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = (wantRead ? EPOLLIN : 0u) | (wantWrite ? EPOLLOUT : 0u);
+        event.data.fd = fd;
+        epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event);
+        connection.watchingRead = wantRead;
+        connection.watchingWrite = wantWrite;
+    }
+
+    void HttpServer::drainCompletions() {
+        // Cleared first: a worker that pushes after this point sends a
+        // fresh wakeup for anything this pass misses
+        wakePending_.exchange(false);
+
+        std::vector<int> touched;
+        Completion completion;
+        while (completions_.tryPop(completion)) {
+            complete(completion.fd, completion.connection, completion.sequence, completion.response);
+            touched.push_back(completion.fd);
+        }
+        for (int fd : touched) {
+            auto found = connections_.find(fd);
+            if (found == connections_.end()) {
+                continue;
+            }
+            // Slots freed up: pick up requests that were waiting for room
+            Connection& connection = found->second;
+            if (!connection.closeAfterWrite && !connection.in.empty() && !processInput(fd, connection)) {
+                connection.closeAfterWrite = true;
+            }
+            writeConnection(fd);
+        }
+    }
+
+    void HttpServer::readConnection(int fd) {
+        auto found = connections_.find(fd);
+        if (found == connections_.end()) {
+            return;
+        }
+        Connection& connection = found->second;
+
+        char buffer[READ_CHUNK];
+        bool peerClosed = false;
+        while (true) {
+            ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+            if (count > 0) {
+                connection.in.append(buffer, static_cast<size_t>(count));
+                continue;
+            }
+            if (count == 0) {
+                peerClosed = true;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                peerClosed = true;
+            }
+            break;
+        }
+
+        if (!connection.closeAfterWrite && !processInput(fd, connection)) {
+            connection.closeAfterWrite = true;
+        }
+        if (peerClosed) {
+            connection.closeAfterWrite = true;
+        }
+        writeConnection(fd);
+    }
+
+    void HttpServer::writeConnection(int fd) {
+        auto found = connections_.find(fd);
+        if (found == connections_.end()) {
+            return;
+        }
+        Connection& connection = found->second;
+
+        while (connection.written < connection.out.size()) {
+            ssize_t count = send(fd, connection.out.data() + connection.written,
+                                 connection.out.size() - connection.written, MSG_NOSIGNAL);
+            if (count > 0) {
+                connection.written += static_cast<size_t>(count);
+                continue;
+            }
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                updateInterest(fd, connection);
+                return;
+            }
+            closeConnection(fd);
+            return;
+        }
+
+        connection.out.clear();
+        connection.written = 0;
+        if (connection.closeAfterWrite && connection.pending.empty()) {
+            closeConnection(fd);
+            return;
+        }
+        updateInterest(fd, connection);
+    }
+
+#else
+
+    bool HttpServer::listen(const std::string& address, uint16_t port) {
+        return fail("the HTTP server needs epoll and is only available on Linux");
+    }
+
+    void HttpServer::run() {
+    }
+
+    void HttpServer::stop() {
+        stopping_ = true;
+    }
+
+#endif
+
+    void HttpServer::complete(int fd, uint64_t connectionId, uint64_t sequence, const HttpResponse& response) {
+        auto found = connections_.find(fd);
+        if (found == connections_.end() || found->second.id != connectionId) {
+            return;  // The client went away while the request ran
+        }
+        Connection& connection = found->second;
+        Pending& slot = connection.pending[sequence - connection.firstSequence];
+        appendResponse(slot.bytes, response, !slot.close);
+        slot.done = true;
+        flushReady(connection);
+    }
+
+    void HttpServer::flushReady(Connection& connection) {
+        while (!connection.pending.empty() && connection.pending.front().done) {
+            Pending& slot = connection.pending.front();
+            connection.out += slot.bytes;
+            if (slot.close) {
+                connection.closeAfterWrite = true;
+            }
+            connection.pending.pop_front();
+            ++connection.firstSequence;
+        }
+    }
+
+    bool HttpServer::processInput(int fd, Connection& connection) {
+        std::string& in = connection.in;
+        size_t offset = 0;
+        bool keepGoing = true;
+
+        // Errors take a slot too, so they go out after earlier responses
+        auto reject = [&](int status, const std::string& message) {
+            Pending slot;
+            appendError(slot.bytes, status, message);
+            slot.done = true;
+            slot.close = true;
+            connection.pending.push_back(std::move(slot));
+            keepGoing = false;
+        };
+
+        while (keepGoing && connection.pending.size() < MAX_IN_FLIGHT) {
+            size_t headerEnd = in.find("\r\n\r\n", offset);
+            if (headerEnd == std::string::npos) {
+                if (in.size() - offset > MAX_REQUEST_SIZE) {
+                    reject(413, "request too large");
+                }
+                break;
+            }
+
+            HttpRequest request;
+            request.peer = connection.peer;
+            size_t lineEnd = in.find("\r\n", offset);
+            std::string line = in.substr(offset, lineEnd - offset);
+            size_t firstSpace = line.find(' ');
+            size_t secondSpace = line.find(' ', firstSpace + 1);
+            if (firstSpace == std::string::npos || secondSpace == std::string::npos) {
+                reject(400, "malformed request line");
+                break;
+            }
+            request.method = line.substr(0, firstSpace);
+            request.path = line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+            size_t query = request.path.find('?');
+            if (query != std::string::npos) {
+                request.query = request.path.substr(query + 1);
+                request.path.resize(query);
+            }
+            request.keepAlive = line.compare(secondSpace + 1, std::string::npos, "HTTP/1.0") != 0;
+
+            size_t contentLength = 0;
+            bool chunked = false;
+            size_t cursor = lineEnd + 2;
+            while (cursor < headerEnd) {
+                size_t end = in.find("\r\n", cursor);
+                size_t colon = in.find(':', cursor);
+                if (colon != std::string::npos && colon < end) {
+                    std::string name = Utils::toLower(in.substr(cursor, colon - cursor));
+                    std::string value = Utils::trim(in.substr(colon + 1, end - colon - 1));
+                    if (name == "content-length") {
+                        contentLength = std::strtoul(value.c_str(), nullptr, 10);
+                    } else if (name == "connection") {
+                        std::string lower = Utils::toLower(value);
+                        if (lower == "close") {
+                            request.keepAlive = false;
+                        } else if (lower == "keep-alive") {
+                            request.keepAlive = true;
+                        }
+                    } else if (name == "transfer-encoding") {
+                        chunked = Utils::toLower(value) != "identity";
+                    }
+                }
+                cursor = end + 2;
+            }
+
+            if (chunked) {
+                reject(501, "chunked request bodies are not supported");
+                break;
+            }
+            if (contentLength > MAX_REQUEST_SIZE) {
+                reject(413, "request too large");
+                break;
+            }
+
+            size_t bodyStart = headerEnd + 4;
+            if (in.size() - bodyStart < contentLength) {
+                break;  // Wait for the rest of the body
+            }
+            request.body = in.substr(bodyStart, contentLength);
+            offset = bodyStart + contentLength;
+
+            Pending slot;
+            slot.close = !request.keepAlive;
+            connection.pending.push_back(std::move(slot));
+            if (!request.keepAlive) {
+                keepGoing = false;
+            }
+            // May answer right away (filling the slot) or later from a worker
+            handler_(request, HttpReply(this, fd, connection.id,
+                                        connection.firstSequence + connection.pending.size() - 1));
+        }
+
+        flushReady(connection);
+        if (!keepGoing) {
+            in.clear();
+            return false;
+        }
+        in.erase(0, offset);
+        return true;
+    }
+}
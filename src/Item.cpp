@@ -15,7 +15,11 @@ namespace Zork {
           type_(type),
           value_(0),
           damage_(0),
-          defense_(0) {
+          defense_(0),
+          lightSource_(false),
+          lightOn_(false),
+          fuel_(-1),
+          lightRadius_(0) {
     }
     
     std::string Item::getTypeString() const {
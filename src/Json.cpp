@@ -0,0 +1,427 @@
+#include "../include/Json.h"
+#include <cstdlib>
+#include <cstdio>
+
+namespace Zork {
+
+    class JsonParser {
+    private:
+        const std::string& text_;
+        size_t pos_;
+        std::string error_;
+
+        void skipWhitespace() {
+            while (pos_ < text_.size()) {
+                char ch = text_[pos_];
+                if (ch != ' ' && ch != '\n' && ch != '\r' && ch != '\t') {
+                    break;
+                }
+                ++pos_;
+            }
+        }
+
+        bool fail(const std::string& message) {
+            if (error_.empty()) {
+                size_t line = 1;
+                for (size_t i = 0; i < pos_ && i < text_.size(); ++i) {
+                    if (text_[i] == '\n') {
+                        ++line;
+                    }
+                }
+                error_ = message + " at line " + std::to_string(line);
+            }
+            return false;
+        }
+
+        bool literal(const char* word, size_t length) {
+            if (text_.compare(pos_, length, word) != 0) {
+                return fail("Invalid literal");
+            }
+            pos_ += length;
+            return true;
+        }
+
+        static void appendUtf8(std::string& out, unsigned long code) {
+            if (code < 0x80) {
+                out += static_cast<char>(code);
+            } else if (code < 0x800) {
+                out += static_cast<char>(0xC0 | (code >> 6));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                out += static_cast<char>(0xE0 | (code >> 12));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (code >> 18));
+                out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        bool parseHex4(unsigned long& code) {
+            if (pos_ + 4 > text_.size()) {
+                return fail("Truncated unicode escape");
+            }
+            char digits[5] = {text_[pos_], text_[pos_ + 1], text_[pos_ + 2], text_[pos_ + 3], 0};
+            char* end = nullptr;
+            code = std::strtoul(digits, &end, 16);
+            if (end != digits + 4) {
+                return fail("Invalid unicode escape");
+            }
+            pos_ += 4;
+            return true;
+        }
+
+        bool parseString(std::string& out) {
+            ++pos_; // Opening quote
+            while (pos_ < text_.size()) {
+                char ch = text_[pos_++];
+                if (ch == '"') {
+                    return true;
+                }
+                if (ch != '\\') {
+                    out += ch;
+                    continue;
+                }
+                if (pos_ >= text_.size()) {
+                    break;
+                }
+                char escaped = text_[pos_++];
+                switch (escaped) {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        unsigned long code = 0;
+                        if (!parseHex4(code)) {
+                            return false;
+                        }
+                        // Surrogate pair
+                        if (code >= 0xD800 && code < 0xDC00 &&
+                            text_.compare(pos_, 2, "\\u") == 0) {
+                            pos_ += 2;
+                            unsigned long low = 0;
+                            if (!parseHex4(low)) {
+                                return false;
+                            }
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(out, code);
+                        break;
+                    }
+                    default:
+                        return fail("Invalid escape sequence");
+                }
+            }
+            return fail("Unterminated string");
+        }
+
+        bool parseNumber(JsonValue& out) {
+            const char* start = text_.c_str() + pos_;
+            char* end = nullptr;
+            double value = std::strtod(start, &end);
+            if (end == start) {
+                return fail("Invalid number");
+            }
+            pos_ += end - start;
+            out.type_ = JsonValue::Type::NUMBER;
+            out.number_ = value;
+            return true;
+        }
+
+        bool parseValue(JsonValue& out, int depth) {
+            if (depth > 64) {
+                return fail("Nesting too deep");
+            }
+            skipWhitespace();
+            if (pos_ >= text_.size()) {
+                return fail("Unexpected end of input");
+            }
+
+            char ch = text_[pos_];
+            if (ch == '{') {
+                ++pos_;
+                out.type_ = JsonValue::Type::OBJECT;
+                skipWhitespace();
+                if (pos_ < text_.size() && text_[pos_] == '}') {
+                    ++pos_;
+                    return true;
+                }
+                while (true) {
+                    skipWhitespace();
+                    if (pos_ >= text_.size() || text_[pos_] != '"') {
+                        return fail("Expected object key");
+                    }
+                    std::string key;
+                    if (!parseString(key)) {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (pos_ >= text_.size() || text_[pos_] != ':') {
+                        return fail("Expected ':'");
+                    }
+                    ++pos_;
+                    out.object_.emplace_back(std::move(key), JsonValue());
+                    if (!parseValue(out.object_.back().second, depth + 1)) {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (pos_ < text_.size() && text_[pos_] == ',') {
+                        ++pos_;
+                        continue;
+                    }
+                    if (pos_ < text_.size() && text_[pos_] == '}') {
+                        ++pos_;
+                        return true;
+                    }
+                    return fail("Expected ',' or '}'");
+                }
+            }
+            if (ch == '[') {
+                ++pos_;
+                out.type_ = JsonValue::Type::ARRAY;
+                skipWhitespace();
+                if (pos_ < text_.size() && text_[pos_] == ']') {
+                    ++pos_;
+                    return true;
+                }
+                while (true) {
+                    out.array_.emplace_back();
+                    if (!parseValue(out.array_.back(), depth + 1)) {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (pos_ < text_.size() && text_[pos_] == ',') {
+                        ++pos_;
+                        continue;
+                    }
+                    if (pos_ < text_.size() && text_[pos_] == ']') {
+                        ++pos_;
+                        return true;
+                    }
+                    return fail("Expected ',' or ']'");
+                }
+            }
+            if (ch == '"') {
+                out.type_ = JsonValue::Type::STRING;
+                return parseString(out.string_);
+            }
+            if (ch == 't') {
+                out.type_ = JsonValue::Type::BOOL;
+                out.bool_ = true;
+                return literal("true", 4);
+            }
+            if (ch == 'f') {
+                out.type_ = JsonValue::Type::BOOL;
+                out.bool_ = false;
+                return literal("false", 5);
+            }
+            if (ch == 'n') {
+                out.type_ = JsonValue::Type::NUL;
+                return literal("null", 4);
+            }
+            return parseNumber(out);
+        }
+
+    public:
+        explicit JsonParser(const std::string& text) : text_(text), pos_(0) {}
+
+        bool parse(JsonValue& out) {
+            if (!parseValue(out, 0)) {
+                return false;
+            }
+            skipWhitespace();
+            if (pos_ != text_.size()) {
+                return fail("Trailing characters");
+            }
+            return true;
+        }
+
+        bool parseStreaming(JsonValue& out, const JsonElementCallback& onElement) {
+            skipWhitespace();
+            if (pos_ >= text_.size() || text_[pos_] != '{') {
+                return fail("Expected an object");
+            }
+            ++pos_;
+            out.type_ = JsonValue::Type::OBJECT;
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == '}') {
+                ++pos_;
+                skipWhitespace();
+                return pos_ == text_.size() || fail("Trailing characters");
+            }
+
+            while (true) {
+                skipWhitespace();
+                if (pos_ >= text_.size() || text_[pos_] != '"') {
+                    return fail("Expected object key");
+                }
+                std::string key;
+                if (!parseString(key)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (pos_ >= text_.size() || text_[pos_] != ':') {
+                    return fail("Expected ':'");
+                }
+                ++pos_;
+                out.object_.emplace_back(key, JsonValue());
+                JsonValue& member = out.object_.back().second;
+                skipWhitespace();
+
+                if (pos_ < text_.size() && text_[pos_] == '[') {
+                    ++pos_;
+                    member.type_ = JsonValue::Type::ARRAY;
+                    skipWhitespace();
+                    if (pos_ < text_.size() && text_[pos_] == ']') {
+                        ++pos_;
+                    } else {
+                        JsonValue element;
+                        for (size_t index = 0;; ++index) {
+                            element = JsonValue();
+                            if (!parseValue(element, 1)) {
+                                return false;
+                            }
+                            if (!onElement(key, index, element)) {
+                                return fail("Stopped");
+                            }
+                            skipWhitespace();
+                            if (pos_ < text_.size() && text_[pos_] == ',') {
+                                ++pos_;
+                                continue;
+                            }
+                            if (pos_ < text_.size() && text_[pos_] == ']') {
+                                ++pos_;
+                                break;
+                            }
+                            return fail("Expected ',' or ']'");
+                        }
+                    }
+                } else if (!parseValue(member, 1)) {
+                    return false;
+                }
+
+                skipWhitespace();
+                if (pos_ < text_.size() && text_[pos_] == ',') {
+                    ++pos_;
+                    continue;
+                }
+                if (pos_ < text_.size() && text_[pos_] == '}') {
+                    ++pos_;
+                    skipWhitespace();
+                    return pos_ == text_.size() || fail("Trailing characters");
+                }
+                return fail("Expected ',' or '}'");
+            }
+        }
+
+        const std::string& getError() const { return error_; }
+    };
+
+    namespace {
+        const JsonValue NULL_VALUE;
+    }
+
+    bool JsonValue::parse(const std::string& text, JsonValue& out, std::string& error) {
+        out = JsonValue();
+        JsonParser parser(text);
+        if (!parser.parse(out)) {
+            error = parser.getError();
+            out = JsonValue();
+            return false;
+        }
+        return true;
+    }
+
+    bool JsonValue::parseStreaming(const std::string& text, JsonValue& out,
+                                   const JsonElementCallback& onElement, std::string& error) {
+        out = JsonValue();
+        JsonParser parser(text);
+        if (!parser.parseStreaming(out, onElement)) {
+            error = parser.getError();
+            out = JsonValue();
+            return false;
+        }
+        return true;
+    }
+
+    size_t JsonValue::size() const {
+        if (type_ == Type::ARRAY) {
+            return array_.size();
+        }
+        if (type_ == Type::OBJECT) {
+            return object_.size();
+        }
+        return 0;
+    }
+
+    bool JsonValue::has(const std::string& key) const {
+        for (const auto& member : object_) {
+            if (member.first == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const JsonValue& JsonValue::operator[](const std::string& key) const {
+        for (const auto& member : object_) {
+            if (member.first == key) {
+                return member.second;
+            }
+        }
+        return NULL_VALUE;
+    }
+
+    const JsonValue& JsonValue::operator[](size_t index) const {
+        if (index < array_.size()) {
+            return array_[index];
+        }
+        return NULL_VALUE;
+    }
+
+    std::string JsonValue::asString(const std::string& fallback) const {
+        return type_ == Type::STRING ? string_ : fallback;
+    }
+
+    int JsonValue::asInt(int fallback) const {
+        return type_ == Type::NUMBER ? static_cast<int>(number_) : fallback;
+    }
+
+    double JsonValue::asNumber(double fallback) const {
+        return type_ == Type::NUMBER ? number_ : fallback;
+    }
+
+    bool JsonValue::asBool(bool fallback) const {
+        return type_ == Type::BOOL ? bool_ : fallback;
+    }
+
+    std::string JsonValue::escape(const std::string& text) {
+        std::string out;
+        out.reserve(text.size() + 2);
+        for (unsigned char ch : text) {
+            switch (ch) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (ch < 0x20) {
+                        char buffer[8];
+                        std::snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+                        out += buffer;
+                    } else {
+                        out += static_cast<char>(ch);
+                    }
+            }
+        }
+        return out;
+    }
+}
@@ -0,0 +1,440 @@
+#include "../include/Leaderboard.h"
+#include "../include/MemoryAccount.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Zork {
+
+    namespace {
+        const char* const LOG_FILE = "leaderboard.wal";
+
+        bool sameEntry(const LeaderboardEntry& a, const LeaderboardEntry& b) {
+            return a.player == b.player && a.score == b.score && a.moves == b.moves;
+        }
+
+        // Names end a log line, so they must not contain line or field breaks
+        std::string cleanName(const std::string& name) {
+            std::string clean = name;
+            std::replace(clean.begin(), clean.end(), '\n', ' ');
+            std::replace(clean.begin(), clean.end(), '\r', ' ');
+            std::replace(clean.begin(), clean.end(), '\t', ' ');
+            return clean;
+        }
+
+        // FNV-1a; enough to tell a half-written line from a whole one
+        uint32_t checksum(const char* data, size_t length) {
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i < length; ++i) {
+                hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+            }
+            return hash;
+        }
+
+        // score, moves, name and the checksum of those three, tab separated
+        void appendRecord(std::string& out, const LeaderboardEntry& entry) {
+            size_t start = out.size();
+            out += std::to_string(entry.score) + '\t' + std::to_string(entry.moves) + '\t' + entry.player;
+            char sum[16];
+            std::snprintf(sum, sizeof(sum), "\t%08x\n", checksum(out.data() + start, out.size() - start));
+            out += sum;
+        }
+
+        bool writeAll(int fd, const std::string& data) {
+            size_t done = 0;
+            while (done < data.size()) {
+                ssize_t put = ::write(fd, data.data() + done, data.size() - done);
+                if (put < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (put <= 0) {
+                    return false;
+                }
+                done += static_cast<size_t>(put);
+            }
+            return true;
+        }
+
+        int openLog(const std::string& path, int flags) {
+            return ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | flags, 0644);
+        }
+    }
+
+    RankedSkipList::RankedSkipList() : level_(1), size_(0), rng_(0x5eed) {
+        head_.links.assign(MAX_LEVEL, Link{nullptr, 0});
+    }
+
+    RankedSkipList::~RankedSkipList() {
+        Node* node = head_.links[0].next;
+        while (node) {
+            Node* next = node->links[0].next;
+            delete node;
+            node = next;
+        }
+    }
+
+    bool RankedSkipList::before(const LeaderboardEntry& a, const LeaderboardEntry& b) {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        if (a.moves != b.moves) {
+            return a.moves < b.moves;
+        }
+        return a.player < b.player;
+    }
+
+    int RankedSkipList::randomLevel() {
+        // p = 1/4: two random bits per level
+        int level = 1;
+        uint32_t bits = rng_();
+        while (level < MAX_LEVEL && (bits & 3) == 0) {
+            ++level;
+            bits >>= 2;
+            if (bits == 0) {
+                bits = rng_();
+            }
+        }
+        return level;
+    }
+
+    // Widths are only meaningful on links that point somewhere; a link to
+    // the end of the list is never followed, so its width is ignored.
+
+    void RankedSkipList::insert(const LeaderboardEntry& entry) {
+        Node* update[MAX_LEVEL];
+        size_t position[MAX_LEVEL];
+
+        Node* node = &head_;
+        size_t here = 0;
+        for (int i = level_ - 1; i >= 0; --i) {
+            while (node->links[i].next && before(node->links[i].next->entry, entry)) {
+                here += node->links[i].width;
+                node = node->links[i].next;
+            }
+            update[i] = node;
+            position[i] = here;
+        }
+
+        int level = randomLevel();
+        for (int i = level_; i < level; ++i) {
+            update[i] = &head_;
+            position[i] = 0;
+        }
+        level_ = std::max(level_, level);
+
+        Node* created = new Node;
+        created->entry = entry;
+        created->links.resize(level);
+        size_t at = position[0] + 1;
+        for (int i = 0; i < level; ++i) {
+            Link& link = update[i]->links[i];
+            created->links[i].next = link.next;
+            created->links[i].width = position[i] + link.width + 1 - at;
+            link.next = created;
+            link.width = at - position[i];
+        }
+        for (int i = level; i < level_; ++i) {
+            if (update[i]->links[i].next) {
+                ++update[i]->links[i].width;
+            }
+        }
+        ++size_;
+    }
+
+    bool RankedSkipList::erase(const LeaderboardEntry& entry) {
+        Node* update[MAX_LEVEL];
+        Node* node = &head_;
+        for (int i = level_ - 1; i >= 0; --i) {
+            while (node->links[i].next && before(node->links[i].next->entry, entry)) {
+                node = node->links[i].next;
+            }
+            update[i] = node;
+        }
+
+        Node* target = node->links[0].next;
+        if (!target || !sameEntry(target->entry, entry)) {
+            return false;
+        }
+
+        for (int i = 0; i < level_; ++i) {
+            Link& link = update[i]->links[i];
+            if (link.next == target) {
+                link.width += target->links[i].width - 1;
+                link.next = target->links[i].next;
+            } else if (link.next) {
+                --link.width;
+            }
+        }
+        while (level_ > 1 && !head_.links[level_ - 1].next) {
+            --level_;
+        }
+        delete target;
+        --size_;
+        return true;
+    }
+
+    size_t RankedSkipList::rankOf(const LeaderboardEntry& entry) const {
+        const Node* node = &head_;
+        size_t here = 0;
+        for (int i = level_ - 1; i >= 0; --i) {
+            while (node->links[i].next && before(node->links[i].next->entry, entry)) {
+                here += node->links[i].width;
+                node = node->links[i].next;
+            }
+        }
+        const Node* found = node->links[0].next;
+        return found && sameEntry(found->entry, entry) ? here + 1 : 0;
+    }
+
+    void RankedSkipList::range(size_t first, size_t count, std::vector<LeaderboardEntry>& out) const {
+        if (first >= size_ || count == 0) {
+            return;
+        }
+
+        // Walk down to the node just before position first + 1
+        const Node* node = &head_;
+        size_t here = 0;
+        for (int i = level_ - 1; i >= 0; --i) {
+            while (node->links[i].next && here + node->links[i].width <= first) {
+                here += node->links[i].width;
+                node = node->links[i].next;
+            }
+        }
+
+        for (node = node->links[0].next; node && count > 0; node = node->links[0].next, --count) {
+            out.push_back(node->entry);
+        }
+    }
+
+    Leaderboard::Leaderboard(const std::string& directory)
+        : updates_(UPDATE_QUEUE_DEPTH), wakePending_(false), queued_(0), applied_(0),
+          stopping_(false), logFd_(-1), logRecords_(0) {
+        if (!directory.empty()) {
+            std::error_code ignored;
+            std::filesystem::create_directories(directory, ignored);
+            logPath_ = directory;
+            if (logPath_.back() != '/') {
+                logPath_ += '/';
+            }
+            logPath_ += LOG_FILE;
+            replay();
+            logFd_ = openLog(logPath_, O_APPEND);
+        }
+        writer_ = std::thread([this]() { writerLoop(); });
+    }
+
+    Leaderboard::~Leaderboard() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+        if (logFd_ >= 0) {
+            ::close(logFd_);
+        }
+    }
+
+    void Leaderboard::record(const std::string& player, int score, int moves) {
+        // The entry's name ends up in the board, not in the calling session
+        MemoryAccount::Scope shared(nullptr);
+        LeaderboardEntry entry(cleanName(player), score, moves);
+        // Only a writer that has fallen a whole ring behind makes us wait
+        while (!updates_.tryPush(std::move(entry))) {
+            std::this_thread::yield();
+        }
+        queued_.fetch_add(1);
+
+        if (!wakePending_.exchange(true)) {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wake_.notify_one();
+        }
+    }
+
+    void Leaderboard::sync() {
+        uint64_t target = queued_.load();
+        wakePending_ = true;
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wake_.notify_one();
+        appliedSignal_.wait(lock, [this, target]() { return applied_ >= target || stopping_; });
+    }
+
+    bool Leaderboard::apply(const LeaderboardEntry& entry) {
+        auto found = best_.find(entry.player);
+        if (found != best_.end()) {
+            if (!RankedSkipList::before(entry, found->second)) {
+                return false;
+            }
+            list_.erase(found->second);
+            found->second = entry;
+        } else {
+            best_.emplace(entry.player, entry);
+        }
+        list_.insert(entry);
+        return true;
+    }
+
+    void Leaderboard::replay() {
+        std::string contents;
+        {
+            int fd = ::open(logPath_.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            char chunk[65536];
+            ssize_t got;
+            while ((got = ::read(fd, chunk, sizeof(chunk))) > 0 || (got < 0 && errno == EINTR)) {
+                if (got > 0) {
+                    contents.append(chunk, static_cast<size_t>(got));
+                }
+            }
+            ::close(fd);
+        }
+
+        // Only whole lines count; a write torn off mid-line has no newline
+        size_t start = 0;
+        for (size_t end; (end = contents.find('\n', start)) != std::string::npos; start = end + 1) {
+            std::string line = contents.substr(start, end - start);
+            size_t first = line.find('\t');
+            size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+            if (second == std::string::npos) {
+                continue;
+            }
+            // Logs from before checksums have three fields
+            size_t third = line.find('\t', second + 1);
+            if (third != std::string::npos) {
+                uint32_t expected = static_cast<uint32_t>(std::strtoul(line.c_str() + third + 1, nullptr, 16));
+                if (line.size() - third - 1 != 8 || checksum(line.data(), third) != expected) {
+                    continue;
+                }
+                line.resize(third);
+            }
+            LeaderboardEntry entry(line.substr(second + 1),
+                                   std::atoi(line.substr(0, first).c_str()),
+                                   std::atoi(line.substr(first + 1, second - first - 1).c_str()));
+            apply(entry);
+            ++logRecords_;
+        }
+        // Cut the torn tail off, or the next record would be glued onto it
+        if (start < contents.size()) {
+            std::error_code ignored;
+            std::filesystem::resize_file(logPath_, start, ignored);
+        }
+    }
+
+    void Leaderboard::compact() {
+        // Only the writer thread mutates best_, so it can read it unlocked
+        std::string temporary = logPath_ + ".tmp";
+        std::string records;
+        for (const auto& pair : best_) {
+            appendRecord(records, pair.second);
+        }
+        // The new log must be on disk before it replaces the old one
+        int fd = openLog(temporary, O_TRUNC);
+        if (fd < 0) {
+            return;
+        }
+        bool written = writeAll(fd, records) && ::fdatasync(fd) == 0;
+        ::close(fd);
+        if (!written || std::rename(temporary.c_str(), logPath_.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            return;
+        }
+        std::string directory = std::filesystem::path(logPath_).parent_path().string();
+        int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (directoryFd >= 0) {
+            ::fsync(directoryFd);
+            ::close(directoryFd);
+        }
+        ::close(logFd_);
+        logFd_ = openLog(logPath_, O_APPEND);
+        logRecords_ = best_.size();
+    }
+
+    void Leaderboard::writerLoop() {
+        std::vector<LeaderboardEntry> batch;
+        batch.reserve(BATCH_SIZE);
+        std::string records;
+
+        while (true) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wake_.wait_for(lock, std::chrono::milliseconds(100),
+                               [this]() { return wakePending_.load() || stopping_; });
+                stopping = stopping_;
+            }
+            wakePending_.exchange(false);
+
+            // Drain in batches so queries get the lock between them
+            while (true) {
+                batch.clear();
+                LeaderboardEntry entry;
+                while (batch.size() < BATCH_SIZE && updates_.tryPop(entry)) {
+                    batch.push_back(std::move(entry));
+                }
+                if (batch.empty()) {
+                    break;
+                }
+
+                records.clear();
+                {
+                    std::unique_lock<std::shared_mutex> lock(mutex_);
+                    for (const auto& update : batch) {
+                        if (apply(update) && logFd_ >= 0) {
+                            appendRecord(records, update);
+                            ++logRecords_;
+                        }
+                    }
+                }
+                // Synced before sync() callers are told the batch is in
+                if (!records.empty() && writeAll(logFd_, records)) {
+                    ::fdatasync(logFd_);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex_);
+                    applied_ += batch.size();
+                }
+                appliedSignal_.notify_all();
+            }
+
+            if (logFd_ >= 0 && logRecords_ > std::max(COMPACT_MIN_RECORDS, 4 * best_.size())) {
+                compact();
+            }
+            if (stopping) {
+                break;
+            }
+        }
+        appliedSignal_.notify_all();
+    }
+
+    std::vector<LeaderboardEntry> Leaderboard::top(size_t count) const {
+        std::vector<LeaderboardEntry> entries;
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        entries.reserve(std::min(count, list_.size()));
+        list_.range(0, count, entries);
+        return entries;
+    }
+
+    bool Leaderboard::rank(const std::string& player, size_t& position, LeaderboardEntry& entry) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto found = best_.find(cleanName(player));
+        if (found == best_.end()) {
+            return false;
+        }
+        entry = found->second;
+        position = list_.rankOf(entry);
+        return position > 0;
+    }
+
+    size_t Leaderboard::size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return list_.size();
+    }
+}
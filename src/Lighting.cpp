@@ -0,0 +1,131 @@
+#include "../include/Lighting.h"
+#include "../include/Constants.h"
+#include <algorithm>
+
+namespace Zork {
+
+    Lighting::Lighting() : epoch_(1), recomputes_(0) {
+    }
+
+    bool Lighting::compute(const Room& room, const Player* player) const {
+        if (room.isLit() || room.hasLightSource(0)) {
+            return true;
+        }
+        if (player && player->getCurrentRoom().get() == &room && player->carriesLight(0)) {
+            return true;
+        }
+
+        // Radiant sources spill through open passages. Passages are two-way
+        // in practice, so invalidating a source's own exits covers this.
+        for (const auto& pair : room.getExitRooms()) {
+            const Room& next = *pair.second;
+            if (next.hasLightSource(1)) {
+                return true;
+            }
+            if (player && player->getCurrentRoom().get() == &next && player->carriesLight(1)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Lighting::isLit(Room& room, const Player* player) {
+        bool lit;
+        if (room.getCachedLight(epoch_, lit)) {
+            return lit;
+        }
+        lit = compute(room, player);
+        room.cacheLight(epoch_, lit);
+        ++recomputes_;
+        return lit;
+    }
+
+    void Lighting::invalidateAll() {
+        if (++epoch_ == 0) {
+            epoch_ = 1;
+        }
+    }
+
+    void Lighting::untrack(const ItemPtr& item) {
+        burning_.erase(std::remove(burning_.begin(), burning_.end(), item), burning_.end());
+    }
+
+    void Lighting::track(const ItemPtr& item) {
+        if (item->isEmittingLight() && item->getFuel() > 0 &&
+            std::find(burning_.begin(), burning_.end(), item) == burning_.end()) {
+            burning_.push_back(item);
+        }
+    }
+
+    void Lighting::clear() {
+        burning_.clear();
+        invalidateAll();
+    }
+
+    bool Lighting::setLightOn(const ItemPtr& item, bool on, Room* where) {
+        if (!item->isLightSource() || (on && item->getFuel() == 0)) {
+            return false;
+        }
+        if (item->isLightOn() == on) {
+            return true;
+        }
+
+        item->setLightOn(on);
+        if (on) {
+            track(item);
+        } else {
+            untrack(item);
+        }
+
+        if (where) {
+            where->invalidateLight(item->getLightRadius() > 0);
+        } else {
+            invalidateAll();
+        }
+        return true;
+    }
+
+    void Lighting::tick(const Player& player, std::string& message) {
+        if (burning_.empty()) {
+            return;
+        }
+
+        RoomPtr here = player.getCurrentRoom();
+        const std::vector<ItemPtr>& carried = player.getInventory();
+        for (size_t i = 0; i < burning_.size();) {
+            ItemPtr item = burning_[i];
+            if (!item->isEmittingLight()) {
+                burning_.erase(burning_.begin() + i);
+                continue;
+            }
+            bool nearby = here && (here->getItem(item->getName()) == item ||
+                                   std::find(carried.begin(), carried.end(), item) != carried.end());
+            int fuel = item->getFuel() - 1;
+            item->setFuel(fuel);
+
+            if (fuel == Constants::LOW_FUEL_WARNING && nearby) {
+                if (!message.empty()) {
+                    message += "\n";
+                }
+                message += "The " + item->getName() + " is growing dim.";
+            }
+
+            if (fuel > 0) {
+                ++i;
+                continue;
+            }
+
+            item->setLightOn(false);
+            burning_.erase(burning_.begin() + i);
+            if (nearby) {
+                here->invalidateLight(item->getLightRadius() > 0);
+                if (!message.empty()) {
+                    message += "\n";
+                }
+                message += "The " + item->getName() + " flickers and goes out.";
+            } else {
+                invalidateAll();
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include "../include/MemoryAccount.h"
+#include <cstdlib>
+#include <new>
+
+namespace Zork {
+
+    namespace {
+        thread_local MemoryAccount* currentAccount = nullptr;
+        std::atomic<size_t> chargedBytes(0);
+
+        // Prefixed to every block from operator new; keeps the payload at
+        // the default new alignment
+        struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) BlockHeader {
+            MemoryAccount* account;
+            size_t size;
+        };
+    }
+
+    void MemoryAccountRelease::operator()(MemoryAccount* account) const {
+        account->release();
+    }
+
+    MemoryAccountPtr MemoryAccount::create() {
+        // Straight from malloc, so the account is not charged to itself
+        void* memory = std::malloc(sizeof(MemoryAccount));
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        return MemoryAccountPtr(new (memory) MemoryAccount());
+    }
+
+    void MemoryAccount::charge(size_t bytes) {
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        references_.fetch_add(1, std::memory_order_relaxed);
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        chargedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void MemoryAccount::credit(size_t bytes) {
+        bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        chargedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        release();
+    }
+
+    void MemoryAccount::release() {
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            this->~MemoryAccount();
+            std::free(this);
+        }
+    }
+
+    size_t MemoryAccount::totalBytes() {
+        return chargedBytes.load(std::memory_order_relaxed);
+    }
+
+    MemoryAccount::Scope::Scope(MemoryAccount* account) : previous_(currentAccount) {
+        currentAccount = account;
+    }
+
+    MemoryAccount::Scope::~Scope() {
+        currentAccount = previous_;
+    }
+}
+
+// Replaceable global allocation functions. The array, nothrow and sized
+// forms from the standard library all forward to these two; over-aligned
+// allocations take their own path and are not tracked.
+
+void* operator new(std::size_t size) {
+    using Zork::BlockHeader;
+    void* memory = std::malloc(sizeof(BlockHeader) + size);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    BlockHeader* header = static_cast<BlockHeader*>(memory);
+    header->account = Zork::currentAccount;
+    header->size = size;
+    if (header->account) {
+        header->account->charge(sizeof(BlockHeader) + size);
+    }
+    return header + 1;
+}
+
+void operator delete(void* pointer) noexcept {
+    using Zork::BlockHeader;
+    if (!pointer) {
+        return;
+    }
+    BlockHeader* header = static_cast<BlockHeader*>(pointer) - 1;
+    if (header->account) {
+        header->account->credit(sizeof(BlockHeader) + header->size);
+    }
+    std::free(header);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
@@ -28,16 +28,43 @@ namespace Zork {
         }
     }
     
+    void Player::setInventory(std::vector<ItemPtr> items) {
+        inventory_ = std::move(items);
+        currentWeight_ = 0;
+        for (const auto& item : inventory_) {
+            currentWeight_ += item->getWeight();
+        }
+        if (currentRoom_) {
+            currentRoom_->invalidateLight(true);
+        }
+    }
+    
+    void Player::enterRoom(RoomPtr room) {
+        // Carried light leaves one room and arrives in the other
+        if (currentRoom_ && room != currentRoom_ && carriesLight(0)) {
+            bool radiant = carriesLight(1);
+            currentRoom_->invalidateLight(radiant);
+            if (room) {
+                room->invalidateLight(radiant);
+            }
+        }
+        currentRoom_ = std::move(room);
+    }
+    
     bool Player::move(const std::string& direction) {
         RoomPtr nextRoom = currentRoom_->getExit(direction);
+        if (!nextRoom && resolver_) {
+            std::string roomId = currentRoom_->getRemoteExit(direction);
+            if (!roomId.empty()) {
+                nextRoom = resolver_(roomId);
+            }
+        }
         if (nextRoom) {
             if (nextRoom->isLocked()) {
                 return false;
             }
-            currentRoom_ = nextRoom;
-            if (!currentRoom_->isVisited()) {
-                currentRoom_->setVisited(true);
-            }
+            // Discovery (and its score) is handled when the room is displayed
+            enterRoom(nextRoom);
             return true;
         }
         return false;
@@ -73,9 +100,8 @@ namespace Zork {
     }
     
     bool Player::dropItem(const std::string& itemName, std::string& message) {
-        std::string lowerName = Utils::toLower(itemName);
         for (auto it = inventory_.begin(); it != inventory_.end(); ++it) {
-            if (Utils::toLower((*it)->getName()) == lowerName) {
+            if (Utils::equalsIgnoreCase((*it)->getName(), itemName)) {
                 ItemPtr item = *it;
                 inventory_.erase(it);
                 currentWeight_ -= item->getWeight();
@@ -89,19 +115,38 @@ namespace Zork {
     }
     
     bool Player::hasItem(const std::string& itemName) const {
-        std::string lowerName = Utils::toLower(itemName);
         for (const auto& item : inventory_) {
-            if (Utils::toLower(item->getName()) == lowerName) {
+            if (Utils::equalsIgnoreCase(item->getName(), itemName)) {
                 return true;
             }
         }
         return false;
     }
     
+    void Player::addInventoryItem(ItemPtr item) {
+        if (item->isEmittingLight() && currentRoom_) {
+            currentRoom_->invalidateLight(item->getLightRadius() > 0);
+        }
+        currentWeight_ += item->getWeight();
+        inventory_.push_back(std::move(item));
+    }
+    
+    bool Player::removeInventoryItem(const ItemPtr& item) {
+        auto it = std::find(inventory_.begin(), inventory_.end(), item);
+        if (it == inventory_.end()) {
+            return false;
+        }
+        currentWeight_ -= item->getWeight();
+        inventory_.erase(it);
+        if (item->isEmittingLight() && currentRoom_) {
+            currentRoom_->invalidateLight(item->getLightRadius() > 0);
+        }
+        return true;
+    }
+    
     ItemPtr Player::getInventoryItem(const std::string& itemName) {
-        std::string lowerName = Utils::toLower(itemName);
         for (auto& item : inventory_) {
-            if (Utils::toLower(item->getName()) == lowerName) {
+            if (Utils::equalsIgnoreCase(item->getName(), itemName)) {
                 return item;
             }
         }
@@ -112,6 +157,15 @@ namespace Zork {
         return (currentWeight_ + weight) <= maxCarryWeight_;
     }
     
+    bool Player::carriesLight(int minRadius) const {
+        for (const auto& item : inventory_) {
+            if (item->isEmittingLight() && item->getLightRadius() >= minRadius) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
     int Player::attack() {
         int damage = attackPower_;
         
@@ -141,15 +195,22 @@ namespace Zork {
             return "\nYou are empty-handed.\n";
         }
         
-        std::stringstream ss;
-        ss << "\nYou are carrying:\n";
+        std::string list;
+        list.reserve(64 + inventory_.size() * 32);
+        list += "\nYou are carrying:\n";
         for (const auto& item : inventory_) {
-            ss << "  - " << item->getName() 
-               << " (" << item->getWeight() << " lbs)\n";
+            list += "  - ";
+            list += item->getName();
+            list += " (";
+            list += std::to_string(item->getWeight());
+            list += " lbs)\n";
         }
-        ss << "Total weight: " << currentWeight_ 
-           << "/" << maxCarryWeight_ << " lbs\n";
-        return ss.str();
+        list += "Total weight: ";
+        list += std::to_string(currentWeight_);
+        list += "/";
+        list += std::to_string(maxCarryWeight_);
+        list += " lbs\n";
+        return list;
     }
     
     std::string Player::getStatus() const {
@@ -0,0 +1,62 @@
+#include "../include/RateLimiter.h"
+#include <algorithm>
+#include <functional>
+
+namespace Zork {
+
+    RateLimiter::RateLimiter(double rate, double burst) : rate_(rate), burst_(burst), rejected_(0) {
+    }
+
+    void RateLimiter::configure(double rate, double burst) {
+        rate_ = rate;
+        burst_ = burst;
+    }
+
+    RateLimiter::Shard& RateLimiter::shardFor(const std::string& key) {
+        return shards_[std::hash<std::string>{}(key) % SHARD_COUNT];
+    }
+
+    void RateLimiter::refill(Bucket& bucket, std::chrono::steady_clock::time_point now) const {
+        double elapsed = std::chrono::duration<double>(now - bucket.refilled).count();
+        bucket.tokens = std::min(burst_, bucket.tokens + elapsed * rate_);
+        bucket.refilled = now;
+    }
+
+    bool RateLimiter::tryAcquire(const std::string& key, double cost, double& left) {
+        if (!enabled()) {
+            left = 1.0;
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto inserted = shard.buckets.emplace(key, Bucket{burst_, now});
+        Bucket& bucket = inserted.first->second;
+        if (!inserted.second) {
+            refill(bucket, now);
+        }
+
+        bool granted = bucket.tokens >= cost;
+        if (granted) {
+            bucket.tokens -= cost;
+        } else {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+        }
+        left = burst_ > 0 ? bucket.tokens / burst_ : 0.0;
+        return granted;
+    }
+
+    size_t RateLimiter::prune() {
+        auto now = std::chrono::steady_clock::now();
+        size_t remaining = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto it = shard.buckets.begin(); it != shard.buckets.end();) {
+                refill(it->second, now);
+                it = it->second.tokens >= burst_ ? shard.buckets.erase(it) : std::next(it);
+            }
+            remaining += shard.buckets.size();
+        }
+        return remaining;
+    }
+}
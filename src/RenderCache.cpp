@@ -0,0 +1,59 @@
+#include "../include/RenderCache.h"
+#include "../include/MemoryAccount.h"
+#include <functional>
+
+namespace Zork {
+
+    RenderCache::RenderCache(size_t maxEntriesPerShard)
+        : maxEntriesPerShard_(maxEntriesPerShard), hits_(0), misses_(0) {
+    }
+
+    RenderCache& RenderCache::instance() {
+        static RenderCache cache;
+        return cache;
+    }
+
+    RenderCache::Shard& RenderCache::shardFor(const std::string& key) {
+        return shards_[std::hash<std::string>{}(key) % SHARD_COUNT];
+    }
+
+    RenderPtr RenderCache::find(const std::string& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.entries.find(key);
+        if (found == shard.entries.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return found->second;
+    }
+
+    RenderPtr RenderCache::insert(const std::string& key, std::string_view text) {
+        // Every session shares the entry; none of them should pay for it
+        MemoryAccount::Scope shared(nullptr);
+        auto render = std::make_shared<const std::string>(text);
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.entries.size() >= maxEntriesPerShard_) {
+            shard.entries.clear();
+        }
+        return shard.entries.emplace(key, std::move(render)).first->second;
+    }
+
+    void RenderCache::clear() {
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.entries.clear();
+        }
+    }
+
+    size_t RenderCache::size() {
+        size_t total = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.entries.size();
+        }
+        return total;
+    }
+}
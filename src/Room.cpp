@@ -1,7 +1,6 @@
 #include "../include/Room.h"
 #include "../include/Utils.h"
 #include <algorithm>
-#include <sstream>
 
 namespace Zork {
     
@@ -13,19 +12,37 @@ namespace Zork {
           description_(description),
           visited_(false),
           lit_(true),
-          locked_(false) {
+          locked_(false),
+          lightEpoch_(0),
+          litCache_(true),
+          version_(1),
+          textHash_(std::hash<std::string>{}(name + '\x1f' + description)),
+          renderVersion_(0),
+          renderLit_(false) {
     }
     
     void Room::addExit(const std::string& direction, std::shared_ptr<Room> room) {
         exits_[Utils::toLower(direction)] = room;
+        ++version_;
     }
     
     std::shared_ptr<Room> Room::getExit(const std::string& direction) {
-        std::string dir = Utils::toLower(direction);
-        if (exits_.find(dir) != exits_.end()) {
-            return exits_[dir];
+        // find, not operator[]: shared-world players follow exits concurrently
+        auto exit = exits_.find(Utils::toLower(direction));
+        return exit != exits_.end() ? exit->second : nullptr;
+    }
+    
+    void Room::addRemoteExit(const std::string& direction, const std::string& roomId) {
+        remoteExits_[Utils::toLower(direction)] = roomId;
+        ++version_;
+    }
+    
+    std::string Room::getRemoteExit(const std::string& direction) const {
+        auto it = remoteExits_.find(Utils::toLower(direction));
+        if (it != remoteExits_.end()) {
+            return it->second;
         }
-        return nullptr;
+        return "";
     }
     
     std::vector<std::string> Room::getExits() const {
@@ -33,33 +50,97 @@ namespace Zork {
         for (const auto& pair : exits_) {
             exitList.push_back(pair.first);
         }
+        for (const auto& pair : remoteExits_) {
+            if (exits_.find(pair.first) == exits_.end()) {
+                exitList.push_back(pair.first);
+            }
+        }
+        if (!remoteExits_.empty()) {
+            std::sort(exitList.begin(), exitList.end());
+        }
         return exitList;
     }
     
     bool Room::hasExit(const std::string& direction) const {
-        return exits_.find(Utils::toLower(direction)) != exits_.end();
+        std::string dir = Utils::toLower(direction);
+        return exits_.find(dir) != exits_.end() ||
+               remoteExits_.find(dir) != remoteExits_.end();
     }
     
     void Room::addItem(ItemPtr item) {
-        items_.push_back(item);
+        if (item->isEmittingLight()) {
+            invalidateLight(item->getLightRadius() > 0);
+        }
+        items_.push_back(std::move(item));
+        ++version_;
     }
     
     ItemPtr Room::removeItem(const std::string& itemName) {
-        std::string lowerName = Utils::toLower(itemName);
         for (auto it = items_.begin(); it != items_.end(); ++it) {
-            if (Utils::toLower((*it)->getName()) == lowerName) {
+            if (Utils::equalsIgnoreCase((*it)->getName(), itemName)) {
                 ItemPtr item = *it;
                 items_.erase(it);
+                ++version_;
+                if (item->isEmittingLight()) {
+                    invalidateLight(item->getLightRadius() > 0);
+                }
                 return item;
             }
         }
         return nullptr;
     }
     
+    bool Room::removeItem(const ItemPtr& item) {
+        auto it = std::find(items_.begin(), items_.end(), item);
+        if (it == items_.end()) {
+            return false;
+        }
+        items_.erase(it);
+        ++version_;
+        if (item->isEmittingLight()) {
+            invalidateLight(item->getLightRadius() > 0);
+        }
+        return true;
+    }
+    
+    bool Room::removeOccupant(const std::string& name) {
+        auto it = std::find(occupants_.begin(), occupants_.end(), name);
+        if (it == occupants_.end()) {
+            return false;
+        }
+        occupants_.erase(it);
+        return true;
+    }
+    
+    void Room::invalidateLight(bool neighbours) {
+        lightEpoch_ = 0;
+        if (neighbours) {
+            for (const auto& pair : exits_) {
+                pair.second->lightEpoch_ = 0;
+            }
+        }
+    }
+    
+    bool Room::getCachedLight(uint32_t epoch, bool& lit) const {
+        if (lightEpoch_ != epoch) {
+            return false;
+        }
+        lit = litCache_;
+        return true;
+    }
+    
+    bool Room::hasLightSource(int minRadius) const {
+        for (const auto& item : items_) {
+            if (item->isEmittingLight() && item->getLightRadius() >= minRadius) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
     ItemPtr Room::getItem(const std::string& itemName) {
-        std::string lowerName = Utils::toLower(itemName);
         for (auto& item : items_) {
-            if (Utils::toLower(item->getName()) == lowerName) {
+            if (Utils::equalsIgnoreCase(item->getName(), itemName)) {
                 return item;
             }
         }
@@ -67,42 +148,108 @@ namespace Zork {
     }
     
     bool Room::hasItem(const std::string& itemName) const {
-        std::string lowerName = Utils::toLower(itemName);
         for (const auto& item : items_) {
-            if (Utils::toLower(item->getName()) == lowerName) {
+            if (Utils::equalsIgnoreCase(item->getName(), itemName)) {
                 return true;
             }
         }
         return false;
     }
     
-    std::string Room::getFullDescription() const {
-        std::stringstream ss;
-        ss << "\n" << name_ << "\n";
+    std::string Room::renderKey(bool lit) const {
+        // The dark render is just the header; nothing else shows
+        std::string key;
+        key.reserve(64 + items_.size() * 16);
+        key += id_;
+        key += '\x1f';
+        key += std::to_string(textHash_);
+        key += lit ? "\x1f" "1" : "\x1f" "0";
+        if (!lit) {
+            return key;
+        }
+        for (const auto& item : items_) {
+            key += '\x1f';
+            key += item->getName();
+        }
+        key += '\x1e';
+        for (const auto& pair : exits_) {
+            key += pair.first;
+            key += ',';
+        }
+        for (const auto& pair : remoteExits_) {
+            key += pair.first;
+            key += ',';
+        }
+        return key;
+    }
+    
+    RenderPtr Room::render(bool lit) const {
+        if (render_ && renderVersion_ == version_ && renderLit_ == lit) {
+            return render_;
+        }
         
-        if (!lit_) {
-            ss << "It is pitch black. You are likely to be eaten by a grue.\n";
-            return ss.str();
+        std::string key = renderKey(lit);
+        RenderPtr text = RenderCache::instance().find(key);
+        if (!text) {
+            std::pmr::string out;
+            out.reserve(512);
+            appendFullDescription(out, lit);
+            if (lit) {
+                appendItemsList(out);
+                std::vector<std::string> exits = getExits();
+                if (!exits.empty()) {
+                    out += "Exits: ";
+                    out += Utils::join(exits, ", ");
+                    out += "\n";
+                }
+            }
+            text = RenderCache::instance().insert(key, std::string_view(out.data(), out.size()));
         }
         
-        ss << description_ << "\n";
-        return ss.str();
+        render_ = text;
+        renderVersion_ = version_;
+        renderLit_ = lit;
+        return text;
+    }
+    
+    std::string Room::getFullDescription() const {
+        std::pmr::string out;
+        appendFullDescription(out, lit_);
+        return std::string(out);
     }
     
     std::string Room::getItemsList() const {
+        std::pmr::string out;
+        appendItemsList(out);
+        return std::string(out);
+    }
+    
+    void Room::appendFullDescription(std::pmr::string& out, bool lit) const {
+        out += "\n";
+        out += name_;
+        out += "\n";
+        
+        if (!lit) {
+            out += "It is pitch black. You are likely to be eaten by a grue.\n";
+            return;
+        }
+        
+        out += description_;
+        out += "\n";
+    }
+    
+    void Room::appendItemsList(std::pmr::string& out) const {
         if (items_.empty()) {
-            return "";
+            return;
         }
         
-        std::stringstream ss;
-        ss << "\nYou see: ";
+        out += "\nYou see: ";
         for (size_t i = 0; i < items_.size(); ++i) {
-            ss << items_[i]->getName();
+            out += items_[i]->getName();
             if (i < items_.size() - 1) {
-                ss << ", ";
+                out += ", ";
             }
         }
-        ss << "\n";
-        return ss.str();
+        out += "\n";
     }
 }
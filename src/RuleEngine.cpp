@@ -0,0 +1,434 @@
+#include "../include/RuleEngine.h"
+#include "../include/Game.h"
+#include "../include/Utils.h"
+
+// Direct-threaded dispatch needs GNU labels-as-values; other compilers
+// get an ordinary switch loop over the same handlers
+#if defined(__GNUC__)
+#define ZORK_RULES_THREADED 1
+#endif
+
+namespace Zork {
+
+    namespace {
+        void appendLine(std::string& message, const std::string& line) {
+            if (line.empty()) {
+                return;
+            }
+            if (!message.empty()) {
+                message += "\n";
+            }
+            message += line;
+        }
+
+        ItemPtr reachableItem(Player& player, Room& here, const std::string& name) {
+            ItemPtr item = player.getInventoryItem(name);
+            return item ? item : here.getItem(name);
+        }
+    }
+
+    std::string RuleProgram::entryKey(const std::string& verb, const std::string& item,
+                                      const std::string& with) {
+        return Utils::toLower(verb) + '\x1f' + Utils::toLower(item) + '\x1f' + Utils::toLower(with);
+    }
+
+    int RuleProgram::findFlag(const std::string& name) const {
+        for (size_t i = 0; i < flags_.size(); ++i) {
+            if (flags_[i] == name) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    RuleOutcome RuleProgram::execute(Game& game, std::vector<uint8_t>& flags,
+                                     const std::string& verb, const std::string& item,
+                                     const std::string& with, std::string& message) const {
+        auto entry = entries_.find(entryKey(verb, item, with));
+        if (entry == entries_.end()) {
+            return RuleOutcome::NO_RULE;
+        }
+        if (flags.size() < flags_.size()) {
+            flags.resize(flags_.size(), 0);
+        }
+        return interpret(*this, entry->second, &game, &flags, &message, nullptr);
+    }
+
+    size_t RuleProgram::fireTriggers(Game& game, std::vector<uint8_t>& flags, const std::string& room,
+                                     const std::string& event, const std::string& object,
+                                     std::string& message) const {
+        std::vector<uint32_t> matched;
+        if (triggers_.match(room, event, object, matched) == 0) {
+            return 0;
+        }
+        if (flags.size() < flags_.size()) {
+            flags.resize(flags_.size(), 0);
+        }
+        for (uint32_t pc : matched) {
+            // A trigger whose conditions fail stops the rest of the chain
+            if (interpret(*this, pc, &game, &flags, &message, nullptr) == RuleOutcome::FAILURE) {
+                break;
+            }
+        }
+        return matched.size();
+    }
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+    RuleOutcome RuleProgram::interpret(const RuleProgram& program, uint32_t pc, Game* game,
+                                       std::vector<uint8_t>* flags, std::string* message,
+                                       std::vector<const void*>* threadOut) {
+#ifdef ZORK_RULES_THREADED
+        static const void* const handlers[] = {
+            &&L_HOLDING, &&L_HERE, &&L_IN_ROOM, &&L_FLAG, &&L_BURNING, &&L_NOT,
+            &&L_JUMP_IF_ZERO, &&L_FAIL, &&L_SAY, &&L_SET_FLAG, &&L_SET_LIT,
+            &&L_SET_LOCKED, &&L_ADD_SCORE, &&L_CONSUME, &&L_LIGHT, &&L_NO_MATCH, &&L_HALT
+        };
+        static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<size_t>(RuleOp::COUNT),
+                      "one handler per opcode");
+
+        if (threadOut) {
+            threadOut->clear();
+            for (const RuleInstruction& instruction : program.code_) {
+                threadOut->push_back(handlers[static_cast<size_t>(instruction.op)]);
+            }
+            return RuleOutcome::NO_RULE;
+        }
+#else
+        if (threadOut) {
+            return RuleOutcome::NO_RULE;
+        }
+#endif
+
+        const RuleInstruction* code = program.code_.data();
+        PlayerPtr player = game->getPlayer();
+        RoomPtr here = player->getCurrentRoom();
+        int acc = 0;
+
+#ifdef ZORK_RULES_THREADED
+        const void* const* threaded = program.threaded_.data();
+#define HANDLER(name) L_##name:
+#define NEXT() do { ++pc; goto *threaded[pc]; } while (0)
+#define JUMP(target) do { pc = (target); goto *threaded[pc]; } while (0)
+        goto *threaded[pc];
+#else
+#define HANDLER(name) case RuleOp::name:
+#define NEXT() do { ++pc; goto dispatch; } while (0)
+#define JUMP(target) do { pc = (target); goto dispatch; } while (0)
+    dispatch:
+        switch (code[pc].op) {
+#endif
+
+        HANDLER(HOLDING)
+            acc = player->hasItem(program.items_[code[pc].arg]);
+            NEXT();
+
+        HANDLER(HERE)
+            acc = here->hasItem(program.items_[code[pc].arg]);
+            NEXT();
+
+        HANDLER(IN_ROOM)
+            acc = here->getId() == program.rooms_[code[pc].arg];
+            NEXT();
+
+        HANDLER(FLAG)
+            acc = (*flags)[code[pc].arg];
+            NEXT();
+
+        HANDLER(BURNING) {
+            ItemPtr item = reachableItem(*player, *here, program.items_[code[pc].arg]);
+            // imm 1 asks only whether it has fuel left to burn
+            acc = item && (code[pc].imm ? item->isLightSource() && item->getFuel() != 0
+                                        : item->isEmittingLight());
+            NEXT();
+        }
+
+        HANDLER(NOT)
+            acc = !acc;
+            NEXT();
+
+        HANDLER(JUMP_IF_ZERO)
+            if (!acc) {
+                JUMP(static_cast<uint32_t>(code[pc].imm));
+            }
+            NEXT();
+
+        HANDLER(FAIL)
+            appendLine(*message, program.strings_[code[pc].arg]);
+            return RuleOutcome::FAILURE;
+
+        HANDLER(SAY)
+            appendLine(*message, program.strings_[code[pc].arg]);
+            NEXT();
+
+        HANDLER(SET_FLAG) {
+            bool on = code[pc].imm != 0;
+            if ((*flags)[code[pc].arg] != on) {
+                game->noteRuleEffect({RuleEffect::Kind::FLAG, code[pc].arg, nullptr, nullptr, !on, on});
+                (*flags)[code[pc].arg] = on;
+            }
+            NEXT();
+        }
+
+        HANDLER(SET_LIT) {
+            RoomPtr room = code[pc].arg == CURRENT_ROOM ? here : game->getRoom(program.rooms_[code[pc].arg]);
+            bool lit = code[pc].imm != 0;
+            if (room && room->isLit() != lit) {
+                game->noteRuleEffect({RuleEffect::Kind::LIT, 0, room, nullptr, !lit, lit});
+                room->setLit(lit);
+            }
+            NEXT();
+        }
+
+        HANDLER(SET_LOCKED) {
+            RoomPtr room = code[pc].arg == CURRENT_ROOM ? here : game->getRoom(program.rooms_[code[pc].arg]);
+            bool locked = code[pc].imm != 0;
+            if (room && room->isLocked() != locked) {
+                game->noteRuleEffect({RuleEffect::Kind::LOCKED, 0, room, nullptr, !locked, locked});
+                room->setLocked(locked);
+            }
+            NEXT();
+        }
+
+        HANDLER(ADD_SCORE)
+            game->addScore(code[pc].imm);
+            NEXT();
+
+        HANDLER(CONSUME) {
+            ItemPtr item = player->getInventoryItem(program.items_[code[pc].arg]);
+            if (item) {
+                game->noteRuleEffect({RuleEffect::Kind::CONSUMED, 0, nullptr, item, false, true});
+                player->removeInventoryItem(item);
+            }
+            NEXT();
+        }
+
+        HANDLER(LIGHT) {
+            ItemPtr item = reachableItem(*player, *here, program.items_[code[pc].arg]);
+            bool on = code[pc].imm != 0;
+            if (item && item->isLightOn() != on && game->setLightOn(item, on)) {
+                game->noteRuleEffect({RuleEffect::Kind::LIGHT, 0, nullptr, item, !on, on});
+            }
+            NEXT();
+        }
+
+        HANDLER(NO_MATCH)
+            return RuleOutcome::NO_RULE;
+
+        HANDLER(HALT)
+            return RuleOutcome::SUCCESS;
+
+#ifndef ZORK_RULES_THREADED
+            default:
+                return RuleOutcome::NO_RULE;
+        }
+#endif
+
+#undef HANDLER
+#undef NEXT
+#undef JUMP
+    }
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+    bool RuleCompiler::fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+
+    uint16_t RuleCompiler::intern(std::vector<std::string>& table, const std::string& value) {
+        for (size_t i = 0; i < table.size(); ++i) {
+            if (table[i] == value) {
+                return static_cast<uint16_t>(i);
+            }
+        }
+        table.push_back(value);
+        return static_cast<uint16_t>(table.size() - 1);
+    }
+
+    bool RuleCompiler::compile(const JsonValue& document, RuleProgram& program) {
+        error_.clear();
+        program = RuleProgram();
+
+        const JsonValue& rules = document["rules"];
+        if (!rules.isNull() && !rules.isArray()) {
+            return fail("rules.json: 'rules' must be an array");
+        }
+
+        // Group rules by key, keeping first-seen order
+        std::vector<std::string> keys;
+        std::unordered_map<std::string, std::vector<const JsonValue*>> groups;
+        for (size_t i = 0; i < rules.size(); ++i) {
+            const JsonValue& rule = rules[i];
+            std::string verb = rule["verb"].asString();
+            if (verb.empty()) {
+                return fail("rules.json: rule " + std::to_string(i) + " has no verb");
+            }
+            std::string key = RuleProgram::entryKey(verb, rule["item"].asString(), rule["with"].asString());
+            auto& group = groups[key];
+            if (group.empty()) {
+                keys.push_back(key);
+            }
+            group.push_back(&rule);
+        }
+
+        auto emit = [&](RuleOp op, uint16_t arg = 0, int32_t imm = 0) {
+            program.code_.push_back({op, arg, imm});
+            return program.code_.size() - 1;
+        };
+        auto roomArg = [&](const std::string& room) {
+            return room == "here" ? RuleProgram::CURRENT_ROOM : intern(program.rooms_, room);
+        };
+
+        // Conditions, then actions, then HALT; each failed condition jumps
+        // to a FAIL carrying its "else" text
+        auto compileBody = [&](const JsonValue& rule, const std::string& label,
+                               const std::string& defaultElse) {
+            std::vector<std::pair<size_t, uint16_t>> failures;
+            const JsonValue& require = rule["require"];
+            for (size_t c = 0; c < require.size(); ++c) {
+                const JsonValue& condition = require[c];
+                bool expect = true;
+                if (condition.has("holding")) {
+                    emit(RuleOp::HOLDING, intern(program.items_, Utils::toLower(condition["holding"].asString())));
+                } else if (condition.has("here")) {
+                    emit(RuleOp::HERE, intern(program.items_, Utils::toLower(condition["here"].asString())));
+                } else if (condition.has("in")) {
+                    emit(RuleOp::IN_ROOM, intern(program.rooms_, condition["in"].asString()));
+                } else if (condition.has("flag")) {
+                    emit(RuleOp::FLAG, intern(program.flags_, condition["flag"].asString()));
+                    expect = condition["is"].asBool(true);
+                } else if (condition.has("burning")) {
+                    emit(RuleOp::BURNING, intern(program.items_, Utils::toLower(condition["burning"].asString())));
+                    expect = condition["is"].asBool(true);
+                } else if (condition.has("fueled")) {
+                    emit(RuleOp::BURNING, intern(program.items_, Utils::toLower(condition["fueled"].asString())), 1);
+                } else {
+                    return fail("rules.json: unknown condition in " + label);
+                }
+                if (condition["not"].asBool(false)) {
+                    expect = !expect;
+                }
+                if (!expect) {
+                    emit(RuleOp::NOT);
+                }
+                size_t jump = emit(RuleOp::JUMP_IF_ZERO);
+                failures.emplace_back(jump, intern(program.strings_, condition["else"].asString(defaultElse)));
+            }
+
+            const JsonValue& actions = rule["do"];
+            for (size_t a = 0; a < actions.size(); ++a) {
+                const JsonValue& action = actions[a];
+                if (action.has("say")) {
+                    emit(RuleOp::SAY, intern(program.strings_, action["say"].asString()));
+                } else if (action.has("set_flag")) {
+                    emit(RuleOp::SET_FLAG, intern(program.flags_, action["set_flag"].asString()), 1);
+                } else if (action.has("clear_flag")) {
+                    emit(RuleOp::SET_FLAG, intern(program.flags_, action["clear_flag"].asString()), 0);
+                } else if (action.has("set_lit")) {
+                    emit(RuleOp::SET_LIT, roomArg(action["set_lit"].asString()), action["value"].asBool(true));
+                } else if (action.has("lock")) {
+                    emit(RuleOp::SET_LOCKED, roomArg(action["lock"].asString()), 1);
+                } else if (action.has("unlock")) {
+                    emit(RuleOp::SET_LOCKED, roomArg(action["unlock"].asString()), 0);
+                } else if (action.has("score")) {
+                    emit(RuleOp::ADD_SCORE, 0, action["score"].asInt());
+                } else if (action.has("consume")) {
+                    emit(RuleOp::CONSUME, intern(program.items_, Utils::toLower(action["consume"].asString())));
+                } else if (action.has("light")) {
+                    emit(RuleOp::LIGHT, intern(program.items_, Utils::toLower(action["light"].asString())), 1);
+                } else if (action.has("extinguish")) {
+                    emit(RuleOp::LIGHT, intern(program.items_, Utils::toLower(action["extinguish"].asString())), 0);
+                } else {
+                    return fail("rules.json: unknown action in " + label);
+                }
+            }
+            emit(RuleOp::HALT);
+
+            for (const auto& failure : failures) {
+                program.code_[failure.first].imm = static_cast<int32_t>(program.code_.size());
+                emit(RuleOp::FAIL, failure.second);
+            }
+            return true;
+        };
+
+        for (const std::string& key : keys) {
+            program.entries_[key] = static_cast<uint32_t>(program.code_.size());
+
+            for (const JsonValue* rule : groups[key]) {
+                // A room-bound rule that does not apply tries the next one
+                size_t roomCheck = SIZE_MAX;
+                std::string room = (*rule)["room"].asString();
+                if (!room.empty()) {
+                    emit(RuleOp::IN_ROOM, intern(program.rooms_, room));
+                    roomCheck = emit(RuleOp::JUMP_IF_ZERO);
+                }
+
+                if (!compileBody(*rule, "rule for '" + (*rule)["verb"].asString() + "'", "Nothing happens.")) {
+                    return false;
+                }
+                if (roomCheck != SIZE_MAX) {
+                    program.code_[roomCheck].imm = static_cast<int32_t>(program.code_.size());
+                }
+            }
+            emit(RuleOp::NO_MATCH);
+        }
+
+        // Triggers are keyed by room in the registry, so their bodies carry
+        // no room check of their own and fail silently unless given "else"
+        const JsonValue& triggers = document["triggers"];
+        if (!triggers.isNull() && !triggers.isArray()) {
+            return fail("rules.json: 'triggers' must be an array");
+        }
+        for (size_t i = 0; i < triggers.size(); ++i) {
+            const JsonValue& trigger = triggers[i];
+            std::string event = trigger["on"].asString();
+            if (event.empty()) {
+                return fail("rules.json: trigger " + std::to_string(i) + " has no 'on' event");
+            }
+            uint32_t pc = static_cast<uint32_t>(program.code_.size());
+            if (!compileBody(trigger, "trigger " + std::to_string(i), "")) {
+                return false;
+            }
+            program.triggers_.add(trigger["room"].asString(), event, trigger["item"].asString(), pc);
+        }
+
+        if (program.rooms_.size() >= RuleProgram::CURRENT_ROOM ||
+            program.strings_.size() > UINT16_MAX || program.items_.size() > UINT16_MAX ||
+            program.flags_.size() > UINT16_MAX) {
+            return fail("rules.json: too many distinct rooms, items, flags or strings");
+        }
+
+        RuleProgram::interpret(program, 0, nullptr, nullptr, nullptr, &program.threaded_);
+        return true;
+    }
+
+    RuleProgramPtr RuleCompiler::loadFile(const std::string& path) {
+        error_.clear();
+        if (!Utils::fileExists(path)) {
+            return nullptr;
+        }
+        return loadText(Utils::readFile(path), path);
+    }
+
+    RuleProgramPtr RuleCompiler::loadText(const std::string& text, const std::string& name) {
+        error_.clear();
+        JsonValue document;
+        std::string parseError;
+        if (!JsonValue::parse(text, document, parseError)) {
+            fail(name + ": " + parseError);
+            return nullptr;
+        }
+
+        auto program = std::make_shared<RuleProgram>();
+        if (!compile(document, *program)) {
+            return nullptr;
+        }
+        return program;
+    }
+}
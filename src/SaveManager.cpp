@@ -1,39 +1,76 @@
 #include "../include/SaveManager.h"
 #include "../include/Utils.h"
-#include <fstream>
 #include <sstream>
+#include <filesystem>
+#include <cstdlib>
 
 namespace Zork {
     
+    namespace {
+        std::string joinList(const std::vector<std::string>& values) {
+            return Utils::join(values, ",");
+        }
+    }
+    
     SaveManager::SaveManager() : saveDirectory_("./saves/") {
-        // TODO: Create save directory if it doesn't exist
+        const char* configured = std::getenv("ZORK_SAVE_DIR");
+        if (configured && *configured) {
+            saveDirectory_ = configured;
+            if (saveDirectory_.back() != '/') {
+                saveDirectory_ += '/';
+            }
+        }
+        std::error_code ignored;
+        std::filesystem::create_directories(saveDirectory_, ignored);
+    }
+    
+    SaveStore& SaveManager::store() {
+        std::lock_guard<std::mutex> lock(storeMutex_);
+        if (!store_) {
+            store_ = std::make_unique<SaveStore>(saveDirectory_);
+        }
+        return *store_;
+    }
+    
+    void SaveManager::setSaveDirectory(const std::string& dir) {
+        std::lock_guard<std::mutex> lock(storeMutex_);
+        saveDirectory_ = dir;
+        store_.reset();
     }
     
     std::string SaveManager::serializeGameState(const GameState& state) {
-        // TODO: Implement proper JSON or binary serialization
-        // This is a placeholder implementation
-        std::stringstream ss;
-        ss << "ZORK_SAVE_V1\n";
-        ss << "player_name=" << state.playerName << "\n";
-        ss << "current_room=" << state.currentRoomId << "\n";
-        ss << "score=" << state.score << "\n";
-        ss << "moves=" << state.moves << "\n";
-        ss << "health=" << state.health << "\n";
+        // Line-based and only as large as what the player changed: visited
+        // rooms, the item lists of rooms that differ, flags and light state
+        std::string out;
+        out.reserve(256);
+        out += "ZORK_SAVE_V2\n";
+        out += "player_name=" + state.playerName + "\n";
+        out += "current_room=" + state.currentRoomId + "\n";
+        out += "score=" + std::to_string(state.score) + "\n";
+        out += "moves=" + std::to_string(state.moves) + "\n";
+        out += "health=" + std::to_string(state.health) + "\n";
+        out += "inventory=" + joinList(state.inventory) + "\n";
+        out += "flags=" + joinList(state.flags) + "\n";
         
-        ss << "inventory=";
-        for (size_t i = 0; i < state.inventory.size(); ++i) {
-            ss << state.inventory[i];
-            if (i < state.inventory.size() - 1) {
-                ss << ",";
+        std::vector<std::string> visited;
+        for (const auto& entry : state.visitedRooms) {
+            if (entry.second) {
+                visited.push_back(entry.first);
             }
         }
-        ss << "\n";
+        out += "visited=" + joinList(visited) + "\n";
         
-        return ss.str();
+        for (const auto& entry : state.roomItems) {
+            out += "room:" + entry.first + "=" + joinList(entry.second) + "\n";
+        }
+        for (const auto& entry : state.lights) {
+            out += "light:" + entry.first + "=" + (entry.second.first ? "1," : "0,") +
+                   std::to_string(entry.second.second) + "\n";
+        }
+        return out;
     }
     
     GameState SaveManager::deserializeGameState(const std::string& data) {
-        // TODO: Implement proper deserialization matching the save format
         GameState state;
         
         std::istringstream ss(data);
@@ -53,11 +90,26 @@ namespace Zork {
                 } else if (key == "current_room") {
                     state.currentRoomId = value;
                 } else if (key == "score") {
-                    state.score = std::stoi(value);
+                    state.score = std::atoi(value.c_str());
                 } else if (key == "moves") {
-                    state.moves = std::stoi(value);
+                    state.moves = std::atoi(value.c_str());
                 } else if (key == "health") {
-                    state.health = std::stoi(value);
+                    state.health = std::atoi(value.c_str());
+                } else if (key == "inventory") {
+                    state.inventory = Utils::split(value, ',');
+                } else if (key == "flags") {
+                    state.flags = Utils::split(value, ',');
+                } else if (key == "visited") {
+                    for (const auto& room : Utils::split(value, ',')) {
+                        state.visitedRooms[room] = true;
+                    }
+                } else if (key.compare(0, 5, "room:") == 0) {
+                    state.roomItems[key.substr(5)] = Utils::split(value, ',');
+                } else if (key.compare(0, 6, "light:") == 0) {
+                    std::vector<std::string> parts = Utils::split(value, ',');
+                    if (parts.size() == 2) {
+                        state.lights[key.substr(6)] = {parts[0] == "1", std::atoi(parts[1].c_str())};
+                    }
                 }
             }
         }
@@ -66,30 +118,29 @@ namespace Zork {
     }
     
     bool SaveManager::save(const GameState& state, const std::string& filename) {
-        std::string filepath = saveDirectory_ + filename;
-        std::string data = serializeGameState(state);
-        return Utils::writeFile(filepath, data);
+        return store().put(filename, serializeGameState(state));
     }
     
     bool SaveManager::load(GameState& state, const std::string& filename) {
-        std::string filepath = saveDirectory_ + filename;
-        if (!Utils::fileExists(filepath)) {
+        std::string data;
+        if (!store().get(filename, data)) {
             return false;
         }
-        
-        std::string data = Utils::readFile(filepath);
         state = deserializeGameState(data);
         return true;
     }
     
     std::vector<std::string> SaveManager::listSaveFiles() {
-        // TODO: Implement directory listing to find all .sav files
-        std::vector<std::string> saves;
-        return saves;
+        return store().keys();
     }
     
     bool SaveManager::deleteSave(const std::string& filename) {
-        std::string filepath = saveDirectory_ + filename;
-        return std::remove(filepath.c_str()) == 0;
+        return store().erase(filename);
+    }
+    
+    bool SaveManager::isOpen(std::string& error) {
+        SaveStore& saves = store();
+        error = saves.getError();
+        return saves.isOpen();
     }
 }
@@ -0,0 +1,564 @@
+#include "../include/SaveStore.h"
+#include "../include/MemoryAccount.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Zork {
+
+    namespace {
+        // Record: magic, CRC-32 of everything after it, key length, value
+        // length (TOMBSTONE for a delete), then the key and value bytes
+        const uint32_t RECORD_MAGIC = 0x5a535631;   // "ZSV1"
+        const uint32_t TOMBSTONE = 0xffffffff;
+        const size_t HEADER_SIZE = 16;
+        const size_t MAX_KEY = 4096;
+        const char* const SEGMENT_PREFIX = "saves-";
+        const char* const SEGMENT_SUFFIX = ".log";
+        const char* const LOCK_FILE = "saves.lock";
+
+        uint32_t crc32(const char* data, size_t length, uint32_t crc = 0) {
+            static const auto table = []() {
+                std::array<uint32_t, 256> entries{};
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t value = i;
+                    for (int bit = 0; bit < 8; ++bit) {
+                        value = (value & 1) ? 0xedb88320 ^ (value >> 1) : value >> 1;
+                    }
+                    entries[i] = value;
+                }
+                return entries;
+            }();
+
+            crc = ~crc;
+            for (size_t i = 0; i < length; ++i) {
+                crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+        void putWord(std::string& out, size_t at, uint32_t value) {
+            std::memcpy(&out[at], &value, sizeof(value));
+        }
+
+        uint32_t getWord(const char* in) {
+            uint32_t value;
+            std::memcpy(&value, in, sizeof(value));
+            return value;
+        }
+
+        bool readAt(int fd, char* buffer, size_t length, uint64_t offset) {
+            while (length > 0) {
+                ssize_t got = ::pread(fd, buffer, length, static_cast<off_t>(offset));
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got <= 0) {
+                    return false;
+                }
+                buffer += got;
+                length -= static_cast<size_t>(got);
+                offset += static_cast<uint64_t>(got);
+            }
+            return true;
+        }
+
+        bool writeAt(int fd, const char* buffer, size_t length, uint64_t offset) {
+            while (length > 0) {
+                ssize_t put = ::pwrite(fd, buffer, length, static_cast<off_t>(offset));
+                if (put < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (put <= 0) {
+                    return false;
+                }
+                buffer += put;
+                length -= static_cast<size_t>(put);
+                offset += static_cast<uint64_t>(put);
+            }
+            return true;
+        }
+
+        // Makes creating or removing files in directory durable
+        bool syncDirectory(const std::string& directory) {
+            int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0) {
+                return false;
+            }
+            bool synced = ::fsync(fd) == 0;
+            ::close(fd);
+            return synced;
+        }
+
+        // Checks one record at the start of data; returns its length, or 0
+        // if it is torn or corrupt
+        size_t parseRecord(const char* data, size_t available, std::string& key,
+                           const char*& value, uint32_t& valueLength) {
+            if (available < HEADER_SIZE || getWord(data) != RECORD_MAGIC) {
+                return 0;
+            }
+            uint32_t keyLength = getWord(data + 8);
+            valueLength = getWord(data + 12);
+            uint64_t bodyLength = static_cast<uint64_t>(keyLength) +
+                                  (valueLength == TOMBSTONE ? 0 : valueLength);
+            if (keyLength == 0 || keyLength > MAX_KEY || HEADER_SIZE + bodyLength > available) {
+                return 0;
+            }
+            size_t length = HEADER_SIZE + static_cast<size_t>(bodyLength);
+            if (crc32(data + 8, length - 8) != getWord(data + 4)) {
+                return 0;
+            }
+            key.assign(data + HEADER_SIZE, keyLength);
+            value = data + HEADER_SIZE + keyLength;
+            return length;
+        }
+
+        // Offset of the first intact record at or after from, or the end of
+        // contents if there is none
+        size_t findRecord(const std::string& contents, size_t from) {
+            std::string magic(sizeof(RECORD_MAGIC), '\0');
+            putWord(magic, 0, RECORD_MAGIC);
+            std::string key;
+            const char* value;
+            uint32_t valueLength;
+            for (size_t at = contents.find(magic, from); at != std::string::npos;
+                 at = contents.find(magic, at + 1)) {
+                if (parseRecord(contents.data() + at, contents.size() - at, key, value, valueLength) > 0) {
+                    return at;
+                }
+            }
+            return contents.size();
+        }
+    }
+
+    SaveStore::Segment::~Segment() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    SaveStore::SaveStore(const std::string& directory)
+        : directory_(directory), lockFd_(-1), sealedBytes_(0), sealedLive_(0),
+          compactPending_(false), stopping_(false) {
+        if (!directory_.empty() && directory_.back() != '/') {
+            directory_ += '/';
+        }
+        std::error_code ignored;
+        std::filesystem::create_directories(directory_, ignored);
+
+        // Two stores appending to the same segments would overwrite each
+        // other's records and compact away each other's segments. The lock
+        // goes with the descriptor, so it is released however we exit.
+        std::string lockPath = directory_ + LOCK_FILE;
+        lockFd_ = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (lockFd_ < 0) {
+            error_ = "Cannot open " + lockPath + ": " + std::strerror(errno);
+            return;
+        }
+        if (::flock(lockFd_, LOCK_EX | LOCK_NB) != 0) {
+            error_ = errno == EWOULDBLOCK ? directory_ + " is in use by another process"
+                                          : "Cannot lock " + lockPath + ": " + std::strerror(errno);
+            ::close(lockFd_);
+            lockFd_ = -1;
+            return;
+        }
+
+        std::vector<uint64_t> ids;
+        std::error_code listError;
+        for (const auto& entry : std::filesystem::directory_iterator(directory_, listError)) {
+            std::string name = entry.path().filename().string();
+            size_t prefix = std::strlen(SEGMENT_PREFIX);
+            size_t suffix = std::strlen(SEGMENT_SUFFIX);
+            if (name.size() > prefix + suffix && name.compare(0, prefix, SEGMENT_PREFIX) == 0 &&
+                name.compare(name.size() - suffix, suffix, SEGMENT_SUFFIX) == 0) {
+                ids.push_back(std::strtoull(name.c_str() + prefix, nullptr, 10));
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+
+        for (uint64_t id : ids) {
+            if (!openSegment(id, false)) {
+                segments_.clear();
+                index_.clear();
+                return;
+            }
+            replay(*segments_.rbegin()->second, id == ids.back());
+        }
+
+        // Start a fresh segment if there is none or the last one is full
+        uint64_t next = ids.empty() ? 1 : ids.back() + 1;
+        if (segments_.empty() || segments_.rbegin()->second->size >= SEGMENT_BYTES) {
+            if (!openSegment(next, true)) {
+                segments_.clear();
+                index_.clear();
+                return;
+            }
+        }
+        for (const auto& pair : segments_) {
+            if (pair.second != segments_.rbegin()->second) {
+                sealedBytes_ += pair.second->size;
+                sealedLive_ += pair.second->liveBytes;
+            }
+        }
+
+        compactor_ = std::thread([this]() { compactorLoop(); });
+        if (wantsCompaction()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            compactPending_ = true;
+            wake_.notify_one();
+        }
+    }
+
+    SaveStore::~SaveStore() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        if (compactor_.joinable()) {
+            compactor_.join();
+        }
+        segments_.clear();
+        if (lockFd_ >= 0) {
+            ::close(lockFd_);
+        }
+    }
+
+    std::string SaveStore::segmentPath(uint64_t id) const {
+        char name[48];
+        std::snprintf(name, sizeof(name), "%s%010llu%s", SEGMENT_PREFIX,
+                      static_cast<unsigned long long>(id), SEGMENT_SUFFIX);
+        return directory_ + name;
+    }
+
+    bool SaveStore::openSegment(uint64_t id, bool create) {
+        std::string path = segmentPath(id);
+        int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0);
+        int fd = ::open(path.c_str(), flags, 0644);
+        if (fd < 0) {
+            error_ = "Cannot open " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        // A new segment's records are only safe once its name is on disk
+        if (create && !syncDirectory(directory_)) {
+            error_ = "Cannot sync " + directory_ + ": " + std::strerror(errno);
+            ::close(fd);
+            std::remove(path.c_str());
+            return false;
+        }
+        segments_[id] = std::make_shared<Segment>(id, fd);
+        return true;
+    }
+
+    void SaveStore::replay(Segment& segment, bool newest) {
+        struct stat info;
+        if (::fstat(segment.fd, &info) != 0 || info.st_size == 0) {
+            return;
+        }
+        std::string contents(static_cast<size_t>(info.st_size), '\0');
+        if (!readAt(segment.fd, &contents[0], contents.size(), 0)) {
+            error_ = "Cannot read " + segmentPath(segment.id);
+            return;
+        }
+
+        SegmentPtr owner = segments_[segment.id];
+        size_t offset = 0;
+        size_t skipped = 0;
+        std::string key;
+        while (offset < contents.size()) {
+            const char* value;
+            uint32_t valueLength;
+            size_t length = parseRecord(contents.data() + offset, contents.size() - offset,
+                                        key, value, valueLength);
+            if (length == 0) {
+                // A damaged record; pick up again at the next intact one
+                size_t next = findRecord(contents, offset + 1);
+                if (next == contents.size()) {
+                    break;
+                }
+                skipped += next - offset;
+                offset = next;
+                continue;
+            }
+
+            auto found = index_.find(key);
+            if (found != index_.end()) {
+                found->second.segment->liveBytes -= found->second.length;
+            }
+            if (valueLength == TOMBSTONE) {
+                if (found != index_.end()) {
+                    index_.erase(found);
+                }
+            } else {
+                index_[key] = Location{owner, offset, static_cast<uint32_t>(length)};
+                segment.liveBytes += length;
+            }
+            offset += length;
+        }
+
+        if (offset < contents.size()) {
+            if (newest) {
+                // Nothing intact follows: a torn append. Cut it off so new
+                // records follow valid ones
+                if (::ftruncate(segment.fd, static_cast<off_t>(offset)) != 0) {
+                    error_ = "Cannot truncate " + segmentPath(segment.id);
+                }
+            } else {
+                // Sealed segments are never written again; leave the bytes
+                // for compaction to drop
+                skipped += contents.size() - offset;
+                offset = contents.size();
+            }
+        }
+        if (skipped > 0) {
+            error_ = "Skipped " + std::to_string(skipped) + " corrupt bytes in " + segmentPath(segment.id);
+        }
+        segment.size = offset;
+    }
+
+    bool SaveStore::append(const std::string& key, const std::string* value, Location& where) {
+        size_t length = HEADER_SIZE + key.size() + (value ? value->size() : 0);
+
+        SegmentPtr active = segments_.rbegin()->second;
+        if (active->size > 0 && active->size + length > SEGMENT_BYTES) {
+            if (!openSegment(active->id + 1, true)) {
+                return false;
+            }
+            sealedBytes_ += active->size;
+            sealedLive_ += active->liveBytes;
+            active = segments_.rbegin()->second;
+        }
+
+        std::string record(length, '\0');
+        putWord(record, 0, RECORD_MAGIC);
+        putWord(record, 8, static_cast<uint32_t>(key.size()));
+        putWord(record, 12, value ? static_cast<uint32_t>(value->size()) : TOMBSTONE);
+        std::memcpy(&record[HEADER_SIZE], key.data(), key.size());
+        if (value) {
+            std::memcpy(&record[HEADER_SIZE + key.size()], value->data(), value->size());
+        }
+        putWord(record, 4, crc32(record.data() + 8, length - 8));
+
+        if (!writeAt(active->fd, record.data(), length, active->size)) {
+            error_ = "Cannot write " + segmentPath(active->id) + ": " + std::strerror(errno);
+            return false;
+        }
+        where = Location{active, active->size, static_cast<uint32_t>(length)};
+        active->size += length;
+        if (value) {
+            active->liveBytes += length;
+        }
+        return true;
+    }
+
+    void SaveStore::release(const Location& where) {
+        where.segment->liveBytes -= where.length;
+        if (where.segment != segments_.rbegin()->second) {
+            sealedLive_ -= where.length;
+        }
+    }
+
+    bool SaveStore::wantsCompaction() const {
+        uint64_t stale = sealedBytes_ - sealedLive_;
+        return stale >= COMPACT_MIN_BYTES && stale >= sealedLive_;
+    }
+
+    bool SaveStore::isOpen() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !segments_.empty();
+    }
+
+    bool SaveStore::put(const std::string& key, const std::string& value) {
+        if (key.empty() || key.size() > MAX_KEY || value.size() >= TOMBSTONE) {
+            return false;
+        }
+        // Index entries and new segments belong to the store, not to the
+        // session that happens to be saving
+        MemoryAccount::Scope shared(nullptr);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (segments_.empty()) {
+            return false;
+        }
+
+        Location where;
+        if (!append(key, &value, where)) {
+            return false;
+        }
+        auto found = index_.find(key);
+        if (found != index_.end()) {
+            release(found->second);
+            found->second = std::move(where);
+        } else {
+            index_.emplace(key, std::move(where));
+        }
+
+        if (!compactPending_ && wantsCompaction()) {
+            compactPending_ = true;
+            wake_.notify_one();
+        }
+        return true;
+    }
+
+    bool SaveStore::get(const std::string& key, std::string& value) const {
+        Location where;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = index_.find(key);
+            if (found == index_.end()) {
+                return false;
+            }
+            where = found->second;
+        }
+
+        // The segment stays open while we hold it, even if compaction has
+        // since dropped it from the store
+        std::string record(where.length, '\0');
+        if (!readAt(where.segment->fd, &record[0], record.size(), where.offset)) {
+            return false;
+        }
+        std::string storedKey;
+        const char* data;
+        uint32_t length;
+        if (parseRecord(record.data(), record.size(), storedKey, data, length) != record.size() ||
+            storedKey != key || length == TOMBSTONE) {
+            return false;
+        }
+        value.assign(data, length);
+        return true;
+    }
+
+    bool SaveStore::erase(const std::string& key) {
+        MemoryAccount::Scope shared(nullptr);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(key);
+        if (found == index_.end()) {
+            return false;
+        }
+        Location tombstone;
+        if (!append(key, nullptr, tombstone)) {
+            return false;
+        }
+        release(found->second);
+        index_.erase(found);
+        return true;
+    }
+
+    bool SaveStore::contains(const std::string& key) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return index_.count(key) > 0;
+    }
+
+    std::vector<std::string> SaveStore::keys() const {
+        std::vector<std::string> result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            result.reserve(index_.size());
+            for (const auto& pair : index_) {
+                result.push_back(pair.first);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    size_t SaveStore::segmentCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return segments_.size();
+    }
+
+    void SaveStore::compact() {
+        // Everything older than the active segment is immutable, so its live
+        // records can be read without the lock. Tombstones in those segments
+        // only ever hide records in the same or older ones, which all go
+        // away together.
+        std::vector<SegmentPtr> sealed;
+        std::vector<std::pair<std::string, Location>> live;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (segments_.size() < 2) {
+                return;
+            }
+            uint64_t activeId = segments_.rbegin()->first;
+            for (const auto& pair : segments_) {
+                if (pair.first != activeId) {
+                    sealed.push_back(pair.second);
+                }
+            }
+            for (const auto& pair : index_) {
+                if (pair.second.segment->id < activeId) {
+                    live.emplace_back(pair.first, pair.second);
+                }
+            }
+        }
+
+        std::string value;
+        for (const auto& entry : live) {
+            bool readable = get(entry.first, value);
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = index_.find(entry.first);
+            if (found == index_.end() || found->second.segment != entry.second.segment ||
+                found->second.offset != entry.second.offset) {
+                continue;   // Rewritten or deleted meanwhile
+            }
+            Location where;
+            if (!readable) {
+                release(found->second);   // Corrupt on disk; nothing to save
+                index_.erase(found);
+            } else if (append(entry.first, &value, where)) {
+                release(found->second);
+                found->second = std::move(where);
+            } else {
+                return;   // Out of space; keep the old segments
+            }
+        }
+
+        // The copies must be on disk before the only other copy goes. They
+        // went to the active segment and any it rolled over into since.
+        std::vector<SegmentPtr> copies;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = segments_.upper_bound(sealed.back()->id); it != segments_.end(); ++it) {
+                copies.push_back(it->second);
+            }
+        }
+        for (const auto& segment : copies) {
+            if (::fdatasync(segment->fd) != 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                error_ = "Cannot sync " + segmentPath(segment->id) + ": " + std::strerror(errno);
+                return;
+            }
+        }
+
+        // Oldest first, so a crash part way through never leaves a record
+        // whose tombstone has already been removed
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& segment : sealed) {
+            segments_.erase(segment->id);
+            sealedBytes_ -= segment->size;
+            sealedLive_ -= segment->liveBytes;
+            std::remove(segmentPath(segment->id).c_str());
+        }
+        syncDirectory(directory_);
+    }
+
+    void SaveStore::compactorLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this]() { return compactPending_ || stopping_; });
+            if (stopping_) {
+                break;
+            }
+            lock.unlock();
+            compact();
+            lock.lock();
+            compactPending_ = false;
+        }
+    }
+}
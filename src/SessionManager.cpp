@@ -0,0 +1,459 @@
+#include "../include/SessionManager.h"
+#include "../include/Constants.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <future>
+#include <iostream>
+#include <sys/random.h>
+#include <unistd.h>
+
+namespace Zork {
+
+    namespace {
+        const char* const SHARED_WORLD_SAVE = "shared-world";
+
+        // Session ids are bearer tokens, so they come from the kernel's
+        // CSPRNG; /dev/urandom covers kernels without getrandom
+        bool secureRandom(unsigned char* out, size_t length) {
+            while (length > 0) {
+                ssize_t got = ::getrandom(out, length, 0);
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got < 0 && errno == ENOSYS) {
+                    break;
+                }
+                if (got <= 0) {
+                    return false;
+                }
+                out += got;
+                length -= static_cast<size_t>(got);
+            }
+            if (length == 0) {
+                return true;
+            }
+
+            int fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return false;
+            }
+            while (length > 0) {
+                ssize_t got = ::read(fd, out, length);
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got <= 0) {
+                    break;
+                }
+                out += got;
+                length -= static_cast<size_t>(got);
+            }
+            ::close(fd);
+            return length == 0;
+        }
+
+        // Drops room entries that still match the template: importState
+        // leaves unlisted rooms as the template has them, so only rooms the
+        // player actually changed need to reach the disk
+        void dropUnchangedRooms(GameState& state, const WorldSnapshot& world) {
+            for (auto it = state.roomItems.begin(); it != state.roomItems.end();) {
+                auto image = std::lower_bound(world.rooms.begin(), world.rooms.end(), it->first,
+                    [](const RoomImage& room, const std::string& id) { return room.id < id; });
+                bool unchanged = image != world.rooms.end() && image->id == it->first &&
+                                 image->items.size() == it->second.size();
+                for (size_t i = 0; unchanged && i < it->second.size(); ++i) {
+                    const std::string& name = it->second[i];
+                    unchanged = world.items[image->items[i]].name == name && !state.lights.count(name);
+                }
+                it = unchanged ? state.roomItems.erase(it) : std::next(it);
+            }
+        }
+    }
+
+    SessionManager::SessionManager(SnapshotPtr fallback, const WorldWatcher* watcher, ThreadPool* pool)
+        : fallback_(std::move(fallback)), watcher_(watcher), pool_(pool), leaderboard_(nullptr), seedSource_(std::random_device{}()),
+          resident_(0), softBudget_(0), hardBudget_(0), totalBudget_(0), shared_(nullptr), sharedSaved_(0) {
+        // Another server holding the directory may still be serving what it
+        // hibernated there, so leave it all alone
+        std::string error;
+        if (!saves_.isOpen(error)) {
+            std::cerr << "Saves are disabled: " << error << std::endl;
+            return;
+        }
+        // Sessions do not outlive the process, so anything hibernated by an
+        // earlier run can never be woken
+        for (const auto& key : saves_.listSaveFiles()) {
+            if (key.compare(0, 8, "session-") == 0) {
+                saves_.deleteSave(key);
+            }
+        }
+    }
+
+    SessionManager::~SessionManager() {
+        saveSharedWorld();
+    }
+
+    void SessionManager::setSharedWorld(SharedWorld* world) {
+        shared_ = world;
+        GameState state;
+        if (saves_.load(state, SHARED_WORLD_SAVE)) {
+            world->importState(state);
+        }
+        sharedSaved_ = world->getChanges();
+    }
+
+    void SessionManager::saveSharedWorld() {
+        if (!shared_) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(sharedSaveMutex_);
+        uint64_t changes = shared_->getChanges();
+        if (changes == sharedSaved_) {
+            return;
+        }
+        GameState state;
+        shared_->exportState(state);
+        if (saves_.save(state, SHARED_WORLD_SAVE)) {
+            sharedSaved_ = changes;
+        }
+    }
+
+    void SessionManager::setMemoryBudget(size_t soft, size_t hard, size_t total) {
+        softBudget_ = soft;
+        hardBudget_ = hard;
+        totalBudget_ = total;
+    }
+
+    std::string SessionManager::newId() {
+        static const char HEX[] = "0123456789abcdef";
+        unsigned char bytes[16];
+        if (!secureRandom(bytes, sizeof(bytes))) {
+            return "";
+        }
+        std::string id(2 * sizeof(bytes), '0');
+        for (size_t i = 0; i < sizeof(bytes); ++i) {
+            id[2 * i] = HEX[bytes[i] >> 4];
+            id[2 * i + 1] = HEX[bytes[i] & 0xf];
+        }
+        return id;
+    }
+
+    SnapshotPtr SessionManager::currentWorld() const {
+        SnapshotPtr world = watcher_ ? watcher_->current() : nullptr;
+        return world ? world : fallback_;
+    }
+
+    std::string SessionManager::hibernationFile(const std::string& id) {
+        return "session-" + id + ".hib";
+    }
+
+    void SessionManager::attach(Game& game) {
+        if (!leaderboard_) {
+            return;
+        }
+        Leaderboard* board = leaderboard_;
+        game.setScoreObserver([board](const Game& played, bool) {
+            board->record(played.getPlayer()->getName(), played.getScore(), played.getMoves());
+        });
+    }
+
+    void SessionManager::fillReply(Game& game, TurnReply& reply) {
+        reply.output = game.takeOutput();
+        RoomPtr room = game.getPlayer()->getCurrentRoom();
+        reply.roomId = room->getId();
+        reply.roomName = room->getName();
+        reply.score = game.getScore();
+    }
+
+    void SessionManager::fillReply(const SharedWorld::Resident& resident, TurnReply& reply) {
+        const RoomPtr& room = resident.player->getCurrentRoom();
+        reply.roomId = room->getId();
+        reply.roomName = room->getName();
+        reply.score = 0;
+    }
+
+    std::string SessionManager::create(TurnReply& reply, const std::string& playerName) {
+        if (overMemoryBudget()) {
+            return "";
+        }
+
+        auto session = std::make_shared<Session>();
+        MemoryAccount::Scope charge(shared_ ? nullptr : session->account.get());
+        if (!shared_) {
+            session->world = currentWorld();
+            session->game = std::make_unique<Game>(*session->world);
+            session->game->setOutput(nullptr);
+            session->game->setWorldSource(watcher_);
+        }
+        session->lastActive = std::chrono::steady_clock::now();
+        if (pool_) {
+            session->strand = std::make_shared<Strand>(*pool_, Constants::SESSION_QUEUE_DEPTH);
+        }
+
+        std::string id = newId();
+        if (id.empty()) {
+            return "";
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            MemoryAccount::Scope shared(nullptr);   // The table is not the session's
+            if (session->game) {
+                session->game->reseed(static_cast<uint32_t>(seedSource_()));
+            }
+            sessions_.emplace(id, session);
+        }
+        std::string name = playerName.empty() ? "player-" + id.substr(0, 8) : playerName;
+        reply.result = CommandResult(true, "", true);
+
+        std::lock_guard<std::mutex> turn(session->mutex);
+        if (shared_) {
+            size_t others = shared_->playerCount();
+            reply.output = "Welcome to the shared world of Zork. ";
+            if (others == 0) {
+                reply.output += "Nobody else is here yet.";
+            } else {
+                reply.output += std::to_string(others) + (others == 1 ? " other adventurer is" : " other adventurers are");
+                reply.output += " exploring it with you.";
+            }
+            reply.output += "\nType 'help' for a list of commands.\n";
+            session->resident = shared_->join(name, reply.output);
+            fillReply(*session->resident, reply);
+            return id;
+        }
+
+        session->game->getPlayer()->setName(name);
+        attach(*session->game);
+        resident_.fetch_add(1, std::memory_order_relaxed);
+        session->game->start();
+        fillReply(*session->game, reply);
+        reply.memory = session->account->bytes();
+        return id;
+    }
+
+    TurnStatus SessionManager::execute(const std::string& id, const std::string& command, TurnReply& reply) {
+        return execute(id, CommandParser::parsePipeline(command), reply);
+    }
+
+    TurnStatus SessionManager::execute(const std::string& id, const std::vector<Command>& commands, TurnReply& reply) {
+        if (shared_) {
+            // The world's regions answer from the pool; wait for them
+            std::promise<TurnStatus> finished;
+            submitShared(id, commands, [&finished, &reply](TurnStatus status, TurnReply& turn) {
+                reply = std::move(turn);
+                finished.set_value(status);
+            });
+            return finished.get_future().get();
+        }
+
+        std::shared_ptr<Session> session;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = sessions_.find(id);
+            if (found == sessions_.end()) {
+                return TurnStatus::NO_SESSION;
+            }
+            session = found->second;
+        }
+
+        TurnStatus status = TurnStatus::DONE;
+        {
+            std::lock_guard<std::mutex> turn(session->mutex);
+            if (session->closed) {
+                return TurnStatus::NO_SESSION;
+            }
+            MemoryAccount::Scope charge(session->account.get());
+            if (!session->game && !wake(id, *session)) {
+                // The hibernation record is gone; nothing left to resume
+                status = TurnStatus::NO_SESSION;
+            } else {
+                reply.result = session->game->processCommands(commands);
+                fillReply(*session->game, reply);
+                session->lastActive = std::chrono::steady_clock::now();
+
+                // The reply's strings were charged too but leave with it
+                size_t used = session->account->bytes();
+                reply.memory = used - std::min(used, reply.output.capacity() + reply.roomName.capacity() +
+                                                     reply.roomId.capacity());
+                if (hardBudget_ > 0 && reply.memory > hardBudget_) {
+                    status = TurnStatus::OVER_BUDGET;
+                } else if (softBudget_ > 0 && reply.memory > softBudget_ && reply.result.continueGame &&
+                           !session->game->isInCombat()) {
+                    hibernate(id, *session);
+                }
+            }
+        }
+
+        if (status != TurnStatus::DONE || !reply.result.continueGame) {
+            remove(id);
+        }
+        return status;
+    }
+
+    void SessionManager::submitShared(const std::string& id, std::vector<Command> commands, TurnCallback done) {
+        SharedWorld::ResidentPtr resident;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = sessions_.find(id);
+            if (found != sessions_.end()) {
+                resident = found->second->resident;
+            }
+        }
+        if (!resident) {
+            TurnReply reply;
+            done(TurnStatus::NO_SESSION, reply);
+            return;
+        }
+
+        auto finished = [this, id, resident, done](CommandResult& result, std::string& output) {
+            TurnReply reply;
+            reply.result = std::move(result);
+            reply.output = std::move(output);
+            fillReply(*resident, reply);
+            if (!reply.result.continueGame) {
+                remove(id);
+            }
+            done(TurnStatus::DONE, reply);
+        };
+        if (!shared_->submit(resident, std::move(commands), std::move(finished))) {
+            TurnReply reply;
+            done(TurnStatus::BUSY, reply);
+        }
+    }
+
+    void SessionManager::submit(const std::string& id, const std::string& command, TurnCallback done) {
+        submit(id, CommandParser::parsePipeline(command), std::move(done));
+    }
+
+    void SessionManager::submit(const std::string& id, std::vector<Command> commands, TurnCallback done) {
+        if (shared_) {
+            submitShared(id, std::move(commands), std::move(done));
+            return;
+        }
+
+        StrandPtr strand;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = sessions_.find(id);
+            if (found != sessions_.end()) {
+                strand = found->second->strand;
+            }
+        }
+
+        auto run = [this, id, commands = std::move(commands), done]() {
+            TurnReply reply;
+            TurnStatus status = execute(id, commands, reply);
+            done(status, reply);
+        };
+        if (!strand) {
+            run();
+        } else if (!strand->post(std::move(run))) {
+            TurnReply reply;
+            done(TurnStatus::BUSY, reply);
+        }
+    }
+
+    bool SessionManager::hibernate(const std::string& id, Session& session) {
+        GameState state;
+        session.game->exportState(state);
+        dropUnchangedRooms(state, *session.world);
+        if (!saves_.save(state, hibernationFile(id))) {
+            return false;
+        }
+        session.game.reset();
+        resident_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool SessionManager::wake(const std::string& id, Session& session) {
+        GameState state;
+        if (!saves_.load(state, hibernationFile(id))) {
+            return false;
+        }
+
+        // Wake into whatever the world is now; importState carries the
+        // player's changes across a reload the same way a live migration does
+        session.world = currentWorld();
+        auto game = std::make_unique<Game>(*session.world);
+        game->setOutput(nullptr);
+        game->importState(state);
+        game->setRunning(true);
+        game->setWorldSource(watcher_);
+        attach(*game);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            game->reseed(static_cast<uint32_t>(seedSource_()));
+        }
+
+        session.game = std::move(game);
+        resident_.fetch_add(1, std::memory_order_relaxed);
+        saves_.deleteSave(hibernationFile(id));
+        return true;
+    }
+
+    size_t SessionManager::hibernateIdle(std::chrono::steady_clock::duration maxIdle) {
+        std::vector<std::pair<std::string, std::shared_ptr<Session>>> candidates;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            candidates.assign(sessions_.begin(), sessions_.end());
+        }
+
+        saveSharedWorld();
+        if (shared_) {
+            shared_->rebalance();
+        }
+
+        // Over the total budget, idle or not no longer matters
+        auto cutoff = std::chrono::steady_clock::now() - maxIdle;
+        bool squeezed = overMemoryBudget();
+        size_t hibernated = 0;
+        for (auto& candidate : candidates) {
+            Session& session = *candidate.second;
+            // A session that is busy right now is by definition not idle
+            std::unique_lock<std::mutex> turn(session.mutex, std::try_to_lock);
+            if (!turn.owns_lock() || session.closed || !session.game || session.game->isInCombat()) {
+                continue;
+            }
+            bool heavy = softBudget_ > 0 && session.account->bytes() > softBudget_;
+            if (session.lastActive > cutoff && !heavy && !squeezed) {
+                continue;
+            }
+            if (hibernate(candidate.first, session)) {
+                ++hibernated;
+            }
+        }
+        return hibernated;
+    }
+
+    bool SessionManager::remove(const std::string& id) {
+        std::shared_ptr<Session> session;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = sessions_.find(id);
+            if (found == sessions_.end()) {
+                return false;
+            }
+            session = found->second;
+            sessions_.erase(found);
+        }
+
+        std::lock_guard<std::mutex> turn(session->mutex);
+        session->closed = true;
+        if (session->resident) {
+            shared_->leave(session->resident);
+            session->resident.reset();
+        } else if (session->game) {
+            session->game.reset();
+            resident_.fetch_sub(1, std::memory_order_relaxed);
+        } else {
+            saves_.deleteSave(hibernationFile(id));
+        }
+        return true;
+    }
+
+    size_t SessionManager::size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.size();
+    }
+}
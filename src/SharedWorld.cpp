@@ -0,0 +1,700 @@
+#include "../include/SharedWorld.h"
+#include "../include/Utils.h"
+#include "../include/Constants.h"
+#include <algorithm>
+
+namespace Zork {
+
+    namespace {
+        const char* const SHARED_HELP =
+            "\nIn the shared world you can:\n"
+            "  north, south, east, west, up, down (or go <direction>)\n"
+            "  look, examine <item>, take <item>, drop <item>, inventory\n"
+            "  who - see who else is here\n"
+            "  quit - leave the world (what you carry stays behind)\n";
+    }
+
+    SharedWorld::SharedWorld(SnapshotPtr world, ThreadPool& pool, size_t regions)
+        : template_(std::move(world)), pool_(pool), start_(0), changes_(0), epoch_(0),
+          inlineBatches_(0), deferredSheds_(0), nextResident_(1) {
+        const WorldSnapshot& snapshot = *template_;
+        itemList_.reserve(snapshot.items.size());
+        for (const ItemImage& image : snapshot.items) {
+            auto item = std::make_shared<Item>(image.name, image.description,
+                                               image.weight, image.takeable, image.type);
+            item->setValue(image.value);
+            item->setDamage(image.damage);
+            item->setDefense(image.defense);
+            item->setLightSource(image.lightSource);
+            item->setLightOn(image.lightOn);
+            item->setFuel(image.fuel);
+            // No light radius: light stays in its own room here, and a
+            // radiant item moving would touch the neighbours' light cache,
+            // which may belong to another region
+            items_.emplace(Utils::toLower(image.name), item);
+            itemList_.push_back(std::move(item));
+        }
+
+        slots_.reserve(snapshot.rooms.size());
+        for (const RoomImage& image : snapshot.rooms) {
+            auto room = std::make_shared<Room>(image.id, image.name, image.description);
+            room->setLit(image.lit);
+            room->setLocked(image.locked);
+            for (uint32_t index : image.items) {
+                room->addItem(itemList_[index]);
+            }
+            slots_.push_back(std::make_unique<RoomSlot>(std::move(room)));
+        }
+        for (size_t i = 0; i < snapshot.rooms.size(); ++i) {
+            for (const auto& exit : snapshot.rooms[i].exits) {
+                slots_[i]->room->addExit(exit.first, slots_[exit.second]->room);
+            }
+        }
+        start_ = snapshot.playerRoom < slots_.size() ? snapshot.playerRoom : 0;
+
+        partition(regions ? regions : pool_.size() * Constants::REGIONS_PER_WORKER);
+    }
+
+    void SharedWorld::partition(size_t regions) {
+        regions = std::max<size_t>(1, std::min(regions, slots_.size()));
+        regions_.reserve(regions);
+        for (size_t i = 0; i < regions; ++i) {
+            regions_.push_back(std::make_unique<Region>());
+            regions_.back()->mailbox = std::make_shared<Strand>(pool_, Constants::REGION_QUEUE_DEPTH);
+        }
+
+        // Breadth-first from the start room, cut into equal runs: rooms
+        // close together in the walk are close together in the world, so
+        // most moves stay inside a region. Rooms the walk never reaches
+        // follow in template order.
+        const WorldSnapshot& snapshot = *template_;
+        std::vector<uint32_t> order;
+        std::vector<bool> seen(slots_.size(), false);
+        order.reserve(slots_.size());
+        auto walk = [&](uint32_t root) {
+            if (seen[root]) {
+                return;
+            }
+            seen[root] = true;
+            order.push_back(root);
+            for (size_t head = order.size() - 1; head < order.size(); ++head) {
+                for (const auto& exit : snapshot.rooms[order[head]].exits) {
+                    if (!seen[exit.second]) {
+                        seen[exit.second] = true;
+                        order.push_back(exit.second);
+                    }
+                }
+            }
+        };
+        if (!slots_.empty()) {
+            walk(start_);
+        }
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            walk(static_cast<uint32_t>(i));
+        }
+
+        for (size_t i = 0; i < order.size(); ++i) {
+            slots_[order[i]]->owner.store(static_cast<uint32_t>(i * regions / order.size()), std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t SharedWorld::indexOf(const std::string& roomId) const {
+        auto found = std::lower_bound(slots_.begin(), slots_.end(), roomId,
+            [](const std::unique_ptr<RoomSlot>& slot, const std::string& id) { return slot->room->getId() < id; });
+        return static_cast<uint32_t>(found - slots_.begin());
+    }
+
+    void SharedWorld::touch(RoomSlot& slot) {
+        uint32_t epoch = epoch_.load(std::memory_order_relaxed);
+        if (slot.epoch != epoch) {
+            slot.lastHeat = slot.epoch + 1 == epoch ? slot.heat : 0;
+            slot.heat = 0;
+            slot.epoch = epoch;
+        }
+        ++slot.heat;
+    }
+
+    uint32_t SharedWorld::heatIn(const RoomSlot& slot, uint32_t epoch) const {
+        if (slot.epoch == epoch) {
+            return slot.heat;
+        }
+        return slot.epoch == epoch + 1 ? slot.lastHeat : 0;
+    }
+
+    bool SharedWorld::isLit(const Room& room, const Player& player) const {
+        return room.isLit() || room.hasLightSource(0) || player.carriesLight(0);
+    }
+
+    void SharedWorld::describe(const RoomSlot& slot, const Player& player, std::string& output) const {
+        const Room& room = *slot.room;
+        bool lit = isLit(room, player);
+        output += *room.render(lit);
+
+        // A crowd is summed up rather than listed in full
+        size_t others = 0;
+        std::string listed;
+        for (const std::string& name : room.getOccupants()) {
+            if (name == player.getName()) {
+                continue;
+            }
+            if (others < LISTED_OCCUPANTS) {
+                listed += others ? ", " + name : name;
+            }
+            ++others;
+        }
+        if (others == 0) {
+            return;
+        }
+        if (!lit) {
+            output += "You can hear someone else breathing nearby.\n";
+            return;
+        }
+        output += "Also here: " + listed;
+        if (others > LISTED_OCCUPANTS) {
+            output += " and " + std::to_string(others - LISTED_OCCUPANTS) + " others";
+        }
+        output += "\n";
+    }
+
+    void SharedWorld::publish(RoomSlot& slot, const Resident& author, std::string text) {
+        const std::vector<std::string>& occupants = slot.room->getOccupants();
+        if (occupants.empty() || (occupants.size() == 1 && occupants[0] == author.player->getName())) {
+            return;     // Nobody to tell
+        }
+        if (slot.events.empty()) {
+            slot.events.resize(EVENT_HISTORY);
+        }
+        Event& event = slot.events[slot.published % EVENT_HISTORY];
+        event.author = author.id;
+        event.text = std::make_shared<const std::string>(std::move(text));
+        ++slot.published;
+    }
+
+    void SharedWorld::catchUp(Resident& resident, std::string& output) {
+        const RoomSlot& slot = *slots_[resident.room];
+        uint64_t from = resident.seen;
+        resident.seen = slot.published;
+        if (from >= slot.published) {
+            return;
+        }
+        uint64_t oldest = slot.published > EVENT_HISTORY ? slot.published - EVENT_HISTORY : 0;
+        uint64_t missed = from < oldest ? oldest - from : 0;
+
+        // A run of the same event reads as one line with a count
+        std::vector<std::pair<const std::string*, size_t>> lines;
+        for (uint64_t sequence = std::max(from, oldest); sequence < slot.published; ++sequence) {
+            const Event& event = slot.events[sequence % EVENT_HISTORY];
+            if (event.author == resident.id) {
+                continue;
+            }
+            if (!lines.empty() && *lines.back().first == *event.text) {
+                ++lines.back().second;
+            } else {
+                lines.emplace_back(event.text.get(), 1);
+            }
+        }
+
+        // and a burst is cut down to its newest lines
+        size_t first = lines.size() > SHOWN_EVENTS ? lines.size() - SHOWN_EVENTS : 0;
+        for (size_t i = 0; i < first; ++i) {
+            missed += lines[i].second;
+        }
+        if (missed > 0) {
+            output += "(" + std::to_string(missed) + " earlier goings-on here passed you by.)\n";
+        }
+        for (size_t i = first; i < lines.size(); ++i) {
+            output += *lines[i].first;
+            if (lines[i].second > 1) {
+                output += " (" + std::to_string(lines[i].second) + " times)";
+            }
+            output += "\n";
+        }
+    }
+
+    SharedWorld::ResidentPtr SharedWorld::join(const std::string& name, std::string& output) {
+        std::string unique = name;
+        {
+            std::lock_guard<std::mutex> lock(namesMutex_);
+            for (int suffix = 2; !names_.insert(unique).second; ++suffix) {
+                unique = name + "-" + std::to_string(suffix);
+            }
+        }
+
+        auto resident = std::make_shared<Resident>();
+        resident->id = nextResident_.fetch_add(1, std::memory_order_relaxed);
+        resident->room = start_;
+        resident->player = std::make_shared<Player>(unique, slots_[start_]->room);
+
+        // Step in as the start room's actor would; its owner may change
+        // between looking it up and getting the lock
+        while (true) {
+            uint32_t region = ownerOf(start_);
+            std::lock_guard<std::mutex> lock(regions_[region]->mutex);
+            if (ownerOf(start_) == region) {
+                arrive(*resident, start_, output, " appears out of nowhere.");
+                return resident;
+            }
+        }
+    }
+
+    void SharedWorld::leave(const ResidentPtr& resident) {
+        auto batch = std::make_shared<Batch>();
+        batch->resident = resident;
+        batch->leaving = true;
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lock(resident->mutex);
+            idle = resident->pending.empty();
+            resident->pending.push_back(batch);
+        }
+        if (idle) {
+            dispatch(batch);
+        }
+    }
+
+    bool SharedWorld::submit(const ResidentPtr& resident, std::vector<Command> commands, Done done) {
+        auto batch = std::make_shared<Batch>();
+        batch->resident = resident;
+        batch->commands = std::move(commands);
+        batch->done = std::move(done);
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lock(resident->mutex);
+            if (resident->pending.size() >= Constants::SESSION_QUEUE_DEPTH) {
+                return false;
+            }
+            idle = resident->pending.empty();
+            resident->pending.push_back(batch);
+        }
+        if (idle) {
+            dispatch(batch);
+        }
+        return true;
+    }
+
+    void SharedWorld::dispatch(const std::shared_ptr<Batch>& batch) {
+        uint32_t room = batch->arriving != NOWHERE ? batch->arriving : batch->resident->room;
+        uint32_t region = ownerOf(room);
+        if (regions_[region]->mailbox->post([this, region, batch]() { step(region, batch); })) {
+            return;
+        }
+        if (batch->retries < DISPATCH_RETRIES) {
+            // A full mailbox: try again once the pool has run something else
+            ++batch->retries;
+            pool_.yield([this, batch]() { dispatch(batch); });
+            return;
+        }
+        // Still full: run it here instead, which holds this worker until the
+        // region catches up. step takes the region's lock and checks it still
+        // owns the room, as join does.
+        inlineBatches_.fetch_add(1, std::memory_order_relaxed);
+        step(region, batch);
+    }
+
+    void SharedWorld::step(uint32_t region, const std::shared_ptr<Batch>& batch) {
+        Region& self = *regions_[region];
+        std::unique_lock<std::mutex> lock(self.mutex);
+        Resident& resident = *batch->resident;
+        uint32_t room = batch->arriving != NOWHERE ? batch->arriving : resident.room;
+        if (ownerOf(room) != region) {
+            // The room was handed to another region while this waited
+            lock.unlock();
+            dispatch(batch);
+            return;
+        }
+        batch->retries = 0;
+        self.load.fetch_add(1, std::memory_order_relaxed);
+        touch(*slots_[room]);
+
+        if (resident.gone) {
+            lock.unlock();
+            batch->last = CommandResult(false, "You are no longer in the world.", false);
+            finish(batch);
+            return;
+        }
+        if (batch->arriving != NOWHERE) {
+            arrive(resident, batch->arriving, batch->output, " arrives.");
+            batch->arriving = NOWHERE;
+        } else if (!batch->leaving) {
+            catchUp(resident, batch->output);
+        }
+
+        if (batch->leaving) {
+            // What they carry stays where they stood
+            Player& player = *resident.player;
+            Room& here = *slots_[resident.room]->room;
+            std::vector<ItemPtr> carried = player.getInventory();
+            for (const auto& item : carried) {
+                player.removeInventoryItem(item);
+                here.addItem(item);
+            }
+            if (!carried.empty()) {
+                changes_.fetch_add(1, std::memory_order_relaxed);
+            }
+            depart(resident, " fades from the world.");
+            resident.gone = true;
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> names(namesMutex_);
+                names_.erase(resident.player->getName());
+            }
+            finish(batch);
+            return;
+        }
+
+        while (batch->next < batch->commands.size()) {
+            const Command& command = batch->commands[batch->next++];
+            if (command.getVerb().empty()) {
+                continue;
+            }
+            uint32_t handoff = NOWHERE;
+            CommandResult result = apply(resident, command, batch->output, handoff);
+            if (!result.message.empty()) {
+                batch->output += result.message;
+                batch->output += "\n";
+            }
+            batch->last = std::move(result);
+            if (handoff != NOWHERE) {
+                // The rest of the batch runs wherever the player ends up
+                batch->arriving = handoff;
+                lock.unlock();
+                dispatch(batch);
+                return;
+            }
+            if (!batch->last.success || !batch->last.continueGame) {
+                break;
+            }
+        }
+        lock.unlock();
+        finish(batch);
+    }
+
+    void SharedWorld::finish(const std::shared_ptr<Batch>& batch) {
+        if (batch->done) {
+            batch->done(batch->last, batch->output);
+        }
+        Resident& resident = *batch->resident;
+        std::shared_ptr<Batch> next;
+        {
+            std::lock_guard<std::mutex> lock(resident.mutex);
+            resident.pending.pop_front();
+            if (!resident.pending.empty()) {
+                next = resident.pending.front();
+            }
+        }
+        if (next) {
+            dispatch(next);
+        }
+    }
+
+    CommandResult SharedWorld::apply(Resident& resident, const Command& command, std::string& output, uint32_t& handoff) {
+        std::string verb = CommandParser::canonicalVerb(command.getVerb());
+        std::string object = command.getArgsAsString();
+
+        if (verb == "north" || verb == "south" || verb == "east" ||
+            verb == "west" || verb == "up" || verb == "down") {
+            return move(resident, verb, output, handoff);
+        } else if (verb == "go" && command.hasArgs()) {
+            return move(resident, CommandParser::canonicalVerb(Utils::toLower(command.getArgs()[0])), output, handoff);
+        } else if (verb == "look" && !command.hasArgs()) {
+            return look(resident, output);
+        } else if (verb == "look" || verb == "examine") {
+            return object.empty() ? CommandResult(false, "Examine what?", true) : examine(resident, object);
+        } else if (verb == "take") {
+            return object.empty() ? CommandResult(false, "Take what?", true) : take(resident, object);
+        } else if (verb == "drop") {
+            return object.empty() ? CommandResult(false, "Drop what?", true) : drop(resident, object);
+        } else if (verb == "inventory") {
+            return CommandResult(true, resident.player->getInventoryList(), true);
+        } else if (verb == "who") {
+            return who(resident);
+        } else if (verb == "help") {
+            return CommandResult(true, SHARED_HELP, true);
+        } else if (verb == "quit") {
+            return CommandResult(true, "You leave the world.", false);
+        }
+        return CommandResult(false, "That can't be done in the shared world. Type 'help' for what can.", true);
+    }
+
+    CommandResult SharedWorld::move(Resident& resident, const std::string& direction, std::string& output, uint32_t& handoff) {
+        // Exits and locks never change once the world is built, so the
+        // target may be read whoever owns it
+        RoomPtr target = slots_[resident.room]->room->getExit(direction);
+        if (!target || target->isLocked()) {
+            return CommandResult(false, "You can't go that way.", true);
+        }
+
+        uint32_t to = indexOf(target->getId());
+        depart(resident, " goes " + direction + ".");
+        if (ownerOf(to) != ownerOf(resident.room)) {
+            handoff = to;
+        } else {
+            arrive(resident, to, output, " arrives.");
+        }
+        return CommandResult(true, "", true);
+    }
+
+    void SharedWorld::depart(Resident& resident, const std::string& how) {
+        RoomSlot& slot = *slots_[resident.room];
+        slot.room->removeOccupant(resident.player->getName());
+        publish(slot, resident, resident.player->getName() + how);
+    }
+
+    void SharedWorld::arrive(Resident& resident, uint32_t room, std::string& output, const char* how) {
+        RoomSlot& slot = *slots_[room];
+        publish(slot, resident, resident.player->getName() + how);
+        resident.room = room;
+        resident.seen = slot.published;
+        resident.player->setCurrentRoom(slot.room);
+        slot.room->addOccupant(resident.player->getName());
+        describe(slot, *resident.player, output);
+    }
+
+    CommandResult SharedWorld::take(Resident& resident, const std::string& itemName) {
+        Player& player = *resident.player;
+        RoomSlot& slot = *slots_[resident.room];
+
+        ItemPtr item = slot.room->removeItem(itemName);
+        if (!item) {
+            if (!slot.lastTaken.empty() && Utils::equalsIgnoreCase(slot.lastTaken, itemName) &&
+                slot.lastTaker != player.getName()) {
+                return CommandResult(false, slot.lastTaker + " got to the " + slot.lastTaken + " first.", true);
+            }
+            return CommandResult(false, "You don't see that here.", true);
+        }
+
+        std::string message;
+        if (!player.takeItem(item, message)) {
+            slot.room->addItem(item);
+            return CommandResult(false, message, true);
+        }
+        slot.lastTaken = item->getName();
+        slot.lastTaker = player.getName();
+        changes_.fetch_add(1, std::memory_order_relaxed);
+        publish(slot, resident, player.getName() + " takes the " + item->getName() + ".");
+        return CommandResult(true, message, true);
+    }
+
+    CommandResult SharedWorld::drop(Resident& resident, const std::string& itemName) {
+        Player& player = *resident.player;
+        ItemPtr item = player.getInventoryItem(itemName);
+        std::string message;
+        bool dropped = player.dropItem(itemName, message);
+        if (dropped) {
+            changes_.fetch_add(1, std::memory_order_relaxed);
+            publish(*slots_[resident.room], resident, player.getName() + " drops the " + item->getName() + ".");
+        }
+        return CommandResult(dropped, message, true);
+    }
+
+    CommandResult SharedWorld::examine(Resident& resident, const std::string& itemName) {
+        ItemPtr item = resident.player->getInventoryItem(itemName);
+        if (!item) {
+            item = slots_[resident.room]->room->getItem(itemName);
+        }
+        if (!item) {
+            return CommandResult(false, "You don't see that here.", true);
+        }
+        return CommandResult(true, item->getDescription(), true);
+    }
+
+    CommandResult SharedWorld::look(Resident& resident, std::string& output) {
+        describe(*slots_[resident.room], *resident.player, output);
+        return CommandResult(true, "", true);
+    }
+
+    CommandResult SharedWorld::who(Resident& resident) {
+        const std::string& self = resident.player->getName();
+        std::vector<std::string> others;
+        for (const std::string& name : slots_[resident.room]->room->getOccupants()) {
+            if (name != self) {
+                others.push_back(name);
+            }
+        }
+        if (others.empty()) {
+            return CommandResult(true, "You are alone here.", true);
+        }
+        return CommandResult(true, "Here with you: " + Utils::join(others, ", ") + ".", true);
+    }
+
+    void SharedWorld::rebalance() {
+        if (regions_.size() < 2) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(rebalanceMutex_);
+        std::vector<uint64_t> loads(regions_.size());
+        uint64_t total = 0;
+        for (size_t i = 0; i < regions_.size(); ++i) {
+            loads[i] = regions_[i]->load.exchange(0, std::memory_order_relaxed);
+            total += loads[i];
+        }
+        uint32_t ended = epoch_.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t mean = total / regions_.size();
+        for (size_t i = 0; i < regions_.size(); ++i) {
+            if (loads[i] < REBALANCE_MIN_LOAD || loads[i] <= REBALANCE_FACTOR * mean) {
+                continue;
+            }
+            // Shedding only half the excess leaves room to overshoot
+            // without the rooms bouncing straight back
+            uint64_t budget = (loads[i] - mean) / 2;
+            uint32_t region = static_cast<uint32_t>(i);
+            bool posted = regions_[i]->mailbox->post([this, region, budget, loads, ended]() {
+                std::lock_guard<std::mutex> held(regions_[region]->mutex);
+                shed(region, budget, loads, ended);
+            });
+            if (!posted) {
+                // Too busy to take the message: carry the load into the next
+                // window so the next call finds it hot and tries again
+                regions_[i]->load.fetch_add(loads[i], std::memory_order_relaxed);
+                deferredSheds_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void SharedWorld::shed(uint32_t region, uint64_t budget, const std::vector<uint64_t>& loads, uint32_t epoch) {
+        const WorldSnapshot& snapshot = *template_;
+        std::vector<uint32_t> owned;
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            if (ownerOf(static_cast<uint32_t>(i)) == region) {
+                owned.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        // Border rooms go to their quietest neighbouring region, busiest
+        // room first. A room hotter than what is left to shed stays: moving
+        // it would only move the hot spot. Each pass exposes a new border.
+        std::vector<uint64_t> estimate = loads;
+        uint64_t moved = 0;
+        size_t left = owned.size();
+        for (int pass = 0; pass < SHED_PASSES && moved < budget && left > 1; ++pass) {
+            std::vector<std::pair<uint32_t, uint32_t>> border;    // Heat, room
+            for (uint32_t room : owned) {
+                if (ownerOf(room) == region) {
+                    for (const auto& exit : snapshot.rooms[room].exits) {
+                        if (ownerOf(exit.second) != region) {
+                            border.emplace_back(heatIn(*slots_[room], epoch), room);
+                            break;
+                        }
+                    }
+                }
+            }
+            std::sort(border.begin(), border.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+
+            bool progress = false;
+            for (const auto& candidate : border) {
+                uint32_t heat = candidate.first;
+                uint32_t room = candidate.second;
+                if (left <= 1 || moved >= budget) {
+                    break;
+                }
+                if (heat == 0 || moved + heat > budget) {
+                    continue;
+                }
+                uint32_t target = region;
+                for (const auto& exit : snapshot.rooms[room].exits) {
+                    uint32_t neighbour = ownerOf(exit.second);
+                    if (neighbour != region && (target == region || estimate[neighbour] < estimate[target])) {
+                        target = neighbour;
+                    }
+                }
+                if (target == region || estimate[target] + heat >= estimate[region] - heat) {
+                    continue;
+                }
+                // The new owner may run the room's next message as soon as
+                // it sees this; nothing here touches the room after it
+                slots_[room]->owner.store(target, std::memory_order_release);
+                estimate[target] += heat;
+                estimate[region] -= heat;
+                moved += heat;
+                --left;
+                progress = true;
+            }
+            if (!progress) {
+                break;
+            }
+        }
+    }
+
+    void SharedWorld::exportState(GameState& state) const {
+        // With every region's lock held no actor is running, so each item
+        // is seen exactly once even while rooms change hands
+        std::vector<std::unique_lock<std::mutex>> held;
+        held.reserve(regions_.size());
+        for (const auto& region : regions_) {
+            held.emplace_back(region->mutex);
+        }
+
+        const WorldSnapshot& snapshot = *template_;
+        state.roomItems.clear();
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            const RoomSlot& slot = *slots_[i];
+            std::vector<std::string> names;
+            for (const auto& item : slot.room->getItems()) {
+                names.push_back(item->getName());
+            }
+
+            const std::vector<uint32_t>& original = snapshot.rooms[i].items;
+            bool unchanged = names.size() == original.size();
+            for (size_t j = 0; unchanged && j < names.size(); ++j) {
+                unchanged = snapshot.items[original[j]].name == names[j];
+            }
+            if (!unchanged) {
+                state.roomItems.emplace(slot.room->getId(), std::move(names));
+            }
+        }
+    }
+
+    void SharedWorld::importState(const GameState& state) {
+        // Every item ends up in exactly one room: where the state lists it,
+        // or else where the template put it
+        std::unordered_set<const Item*> placed;
+        std::vector<std::vector<ItemPtr>> contents(slots_.size());
+        for (const auto& listed : state.roomItems) {
+            uint32_t index = indexOf(listed.first);
+            if (index >= slots_.size() || slots_[index]->room->getId() != listed.first) {
+                continue;
+            }
+            for (const std::string& name : listed.second) {
+                auto item = items_.find(Utils::toLower(name));
+                if (item != items_.end() && placed.insert(item->second.get()).second) {
+                    contents[index].push_back(item->second);
+                }
+            }
+        }
+
+        const WorldSnapshot& snapshot = *template_;
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            for (uint32_t itemIndex : snapshot.rooms[i].items) {
+                const ItemPtr& item = itemList_[itemIndex];
+                if (placed.insert(item.get()).second) {
+                    contents[i].push_back(item);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            Room& room = *slots_[i]->room;
+            std::vector<ItemPtr> current = room.getItems();
+            for (const auto& item : current) {
+                room.removeItem(item);
+            }
+            for (auto& item : contents[i]) {
+                room.addItem(std::move(item));
+            }
+        }
+    }
+
+    std::vector<size_t> SharedWorld::regionSizes() const {
+        std::vector<size_t> sizes(regions_.size(), 0);
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            ++sizes[ownerOf(static_cast<uint32_t>(i))];
+        }
+        return sizes;
+    }
+
+    size_t SharedWorld::playerCount() {
+        std::lock_guard<std::mutex> lock(namesMutex_);
+        return names_.size();
+    }
+}
@@ -0,0 +1,163 @@
+#include "../include/ThreadPool.h"
+#include <algorithm>
+
+namespace Zork {
+
+    namespace {
+        // Which pool (and which of its workers) the current thread belongs to
+        thread_local const ThreadPool* currentPool = nullptr;
+        thread_local size_t currentWorker = 0;
+    }
+
+    ThreadPool::ThreadPool(size_t threads)
+        : queued_(0), sleepers_(0), nextWorker_(0), stopping_(false) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        shutdown();
+    }
+
+    void ThreadPool::submit(Task task) {
+        push(std::move(task), true);
+    }
+
+    void ThreadPool::yield(Task task) {
+        push(std::move(task), false);
+    }
+
+    void ThreadPool::push(Task task, bool back) {
+        if (stopping_.load()) {
+            task();
+            return;
+        }
+
+        size_t index = currentPool == this ? currentWorker
+                                           : nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+        {
+            std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+            if (back) {
+                workers_[index]->tasks.push_back(std::move(task));
+            } else {
+                workers_[index]->tasks.push_front(std::move(task));
+            }
+        }
+
+        // queued_ is raised before sleepers_ is read, and a worker raises
+        // sleepers_ before re-checking queued_, so a wakeup cannot be lost
+        queued_.fetch_add(1);
+        if (sleepers_.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            wake_.notify_one();
+        }
+    }
+
+    bool ThreadPool::popLocal(size_t index, Task& task) {
+        Worker& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) {
+            return false;
+        }
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool ThreadPool::steal(size_t thief, Task& task) {
+        for (size_t offset = 1; offset < workers_.size(); ++offset) {
+            Worker& victim = *workers_[(thief + offset) % workers_.size()];
+            std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+            if (!lock.owns_lock() || victim.tasks.empty()) {
+                continue;
+            }
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void ThreadPool::workerLoop(size_t index) {
+        currentPool = this;
+        currentWorker = index;
+
+        while (true) {
+            Task task;
+            if (popLocal(index, task) || steal(index, task)) {
+                queued_.fetch_sub(1);
+                task();
+                continue;
+            }
+
+            // try_lock in steal() can miss work; only sleep once the
+            // counter agrees there is nothing left
+            if (queued_.load() > 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (stopping_.load()) {
+                return;
+            }
+
+            sleepers_.fetch_add(1);
+            {
+                std::unique_lock<std::mutex> lock(sleepMutex_);
+                wake_.wait(lock, [this]() { return queued_.load() > 0 || stopping_.load(); });
+            }
+            sleepers_.fetch_sub(1);
+        }
+    }
+
+    void ThreadPool::shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            if (stopping_.exchange(true)) {
+                return;
+            }
+            wake_.notify_all();
+        }
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+    bool Strand::post(Task task) {
+        if (!queue_.tryPush(std::move(task))) {
+            return false;
+        }
+        if (count_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            auto self = shared_from_this();
+            pool_.submit([self]() { self->drain(); });
+        }
+        return true;
+    }
+
+    void Strand::drain() {
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            Task task;
+            // The count says a task is there; its producer may still be
+            // between claiming the cell and publishing it
+            while (!queue_.tryPop(task)) {
+                std::this_thread::yield();
+            }
+            task();
+            task = nullptr;
+            if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                return;
+            }
+        }
+
+        // Still busy: let other sessions on this worker have a turn
+        auto self = shared_from_this();
+        pool_.yield([self]() { self->drain(); });
+    }
+}
@@ -0,0 +1,131 @@
+#include "../include/Triggers.h"
+#include "../include/Utils.h"
+
+namespace Zork {
+
+    TriggerRegistry::TriggerRegistry() : slots_(16, Slot{0, 0, 0, EMPTY, EMPTY}), used_(0) {
+    }
+
+    uint64_t TriggerRegistry::hashKey(uint32_t room, uint32_t verb, uint32_t object) {
+        uint64_t h = (static_cast<uint64_t>(room) << 32 | verb) * 0x9e3779b97f4a7c15ULL;
+        h ^= (static_cast<uint64_t>(object) + (h >> 29)) * 0xbf58476d1ce4e5b9ULL;
+        return h ^ (h >> 32);
+    }
+
+    uint32_t TriggerRegistry::intern(const std::string& name) {
+        if (name.empty() || name == "*") {
+            return WILDCARD;
+        }
+        std::string key = Utils::toLower(name);
+        auto found = symbols_.find(key);
+        if (found != symbols_.end()) {
+            return found->second;
+        }
+        uint32_t id = static_cast<uint32_t>(symbols_.size() + 1);
+        symbols_.emplace(std::move(key), id);
+        return id;
+    }
+
+    uint32_t TriggerRegistry::lookup(const std::string& name) const {
+        if (name.empty() || name == "*") {
+            return WILDCARD;
+        }
+        auto found = symbols_.find(Utils::toLower(name));
+        return found != symbols_.end() ? found->second : UNKNOWN;
+    }
+
+    const TriggerRegistry::Slot* TriggerRegistry::findSlot(uint32_t room, uint32_t verb, uint32_t object) const {
+        size_t mask = slots_.size() - 1;
+        size_t index = hashKey(room, verb, object) & mask;
+        while (true) {
+            const Slot& slot = slots_[index];
+            if (slot.first == EMPTY) {
+                return nullptr;
+            }
+            if (slot.room == room && slot.verb == verb && slot.object == object) {
+                return &slot;
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+    void TriggerRegistry::rehash(size_t capacity) {
+        std::vector<Slot> old = std::move(slots_);
+        slots_.assign(capacity, Slot{0, 0, 0, EMPTY, EMPTY});
+        size_t mask = capacity - 1;
+        for (const Slot& slot : old) {
+            if (slot.first == EMPTY) {
+                continue;
+            }
+            size_t index = hashKey(slot.room, slot.verb, slot.object) & mask;
+            while (slots_[index].first != EMPTY) {
+                index = (index + 1) & mask;
+            }
+            slots_[index] = slot;
+        }
+    }
+
+    void TriggerRegistry::add(const std::string& room, const std::string& verb,
+                              const std::string& object, uint32_t action) {
+        uint32_t r = intern(room);
+        uint32_t v = intern(verb);
+        uint32_t o = intern(object);
+
+        // Keep the load factor at or below one half
+        if ((used_ + 1) * 2 > slots_.size()) {
+            rehash(slots_.size() * 2);
+        }
+
+        uint32_t entry = static_cast<uint32_t>(entries_.size());
+        entries_.push_back({action, EMPTY});
+
+        size_t mask = slots_.size() - 1;
+        size_t index = hashKey(r, v, o) & mask;
+        while (true) {
+            Slot& slot = slots_[index];
+            if (slot.first == EMPTY) {
+                slot = Slot{r, v, o, entry, entry};
+                ++used_;
+                return;
+            }
+            if (slot.room == r && slot.verb == v && slot.object == o) {
+                entries_[slot.last].next = entry;
+                slot.last = entry;
+                return;
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+    size_t TriggerRegistry::match(const std::string& room, const std::string& verb,
+                                  const std::string& object, std::vector<uint32_t>& actions) const {
+        if (entries_.empty()) {
+            return 0;
+        }
+
+        uint32_t v = lookup(verb);
+        if (v == UNKNOWN) {
+            return 0;
+        }
+        uint32_t r = lookup(room);
+        uint32_t o = lookup(object);
+
+        const uint32_t keys[4][2] = {{r, o}, {r, WILDCARD}, {WILDCARD, o}, {WILDCARD, WILDCARD}};
+        for (const auto& key : keys) {
+            if (key[0] == UNKNOWN || key[1] == UNKNOWN) {
+                continue;
+            }
+            const Slot* slot = findSlot(key[0], v, key[1]);
+            if (!slot) {
+                continue;
+            }
+            size_t count = 0;
+            for (uint32_t entry = slot->first; entry != EMPTY; entry = entries_[entry].next) {
+                actions.push_back(entries_[entry].action);
+                ++count;
+            }
+            return count;
+        }
+        return 0;
+    }
+}
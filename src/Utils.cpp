@@ -1,24 +1,39 @@
 #include "../include/Utils.h"
 #include <iostream>
 #include <fstream>
-#include <random>
 #include <cstdlib>
 
 namespace Zork {
     namespace Utils {
         
+        namespace {
+            thread_local std::mt19937* boundEngine = nullptr;
+        }
+        
+        std::mt19937& randomEngine() {
+            if (boundEngine) {
+                return *boundEngine;
+            }
+            static thread_local std::mt19937 gen(std::random_device{}());
+            return gen;
+        }
+        
         int randomInt(int min, int max) {
-            static std::random_device rd;
-            static std::mt19937 gen(rd());
             std::uniform_int_distribution<> dis(min, max);
-            return dis(gen);
+            return dis(randomEngine());
         }
         
         bool randomBool(double probability) {
-            static std::random_device rd;
-            static std::mt19937 gen(rd());
             std::uniform_real_distribution<> dis(0.0, 1.0);
-            return dis(gen) < probability;
+            return dis(randomEngine()) < probability;
+        }
+        
+        RandomScope::RandomScope(std::mt19937& engine) : previous_(boundEngine) {
+            boundEngine = &engine;
+        }
+        
+        RandomScope::~RandomScope() {
+            boundEngine = previous_;
         }
         
         bool fileExists(const std::string& filename) {
@@ -61,19 +76,21 @@ namespace Zork {
 #endif
         }
         
+        std::string separator(char ch, int length) {
+            return std::string(length > 0 ? length : 0, ch) + "\n";
+        }
+        
+        std::string centered(const std::string& text, int width) {
+            int padding = (width - static_cast<int>(text.length())) / 2;
+            return std::string(padding > 0 ? padding : 0, ' ') + text + "\n";
+        }
+        
         void printSeparator(char ch, int length) {
-            for (int i = 0; i < length; ++i) {
-                std::cout << ch;
-            }
-            std::cout << std::endl;
+            std::cout << separator(ch, length) << std::flush;
         }
         
         void printCentered(const std::string& text, int width) {
-            int padding = (width - text.length()) / 2;
-            for (int i = 0; i < padding; ++i) {
-                std::cout << " ";
-            }
-            std::cout << text << std::endl;
+            std::cout << centered(text, width) << std::flush;
         }
         
         std::string getInput(const std::string& prompt) {
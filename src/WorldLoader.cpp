@@ -0,0 +1,156 @@
+#include "../include/WorldLoader.h"
+#include "../include/Constants.h"
+#include "../include/Utils.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace Zork {
+
+    bool WorldLoader::fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+
+    ItemType WorldLoader::parseItemType(const std::string& type) {
+        std::string lower = Utils::toLower(type);
+        if (lower == "weapon") return ItemType::WEAPON;
+        if (lower == "armor") return ItemType::ARMOR;
+        if (lower == "key") return ItemType::KEY;
+        if (lower == "consumable") return ItemType::CONSUMABLE;
+        if (lower == "quest" || lower == "quest_item") return ItemType::QUEST_ITEM;
+        return ItemType::MISC;
+    }
+
+    std::string WorldLoader::itemTypeName(ItemType type) {
+        switch (type) {
+            case ItemType::WEAPON: return "weapon";
+            case ItemType::ARMOR: return "armor";
+            case ItemType::KEY: return "key";
+            case ItemType::CONSUMABLE: return "consumable";
+            case ItemType::QUEST_ITEM: return "quest_item";
+            default: return "misc";
+        }
+    }
+
+    bool WorldLoader::loadDirectory(const std::string& directory, WorldSnapshot& world) {
+        std::string base = directory;
+        if (!base.empty() && base.back() != '/') {
+            base += '/';
+        }
+
+        std::string roomsText = Utils::readFile(base + "rooms.json");
+        if (roomsText.empty()) {
+            return fail("Cannot read " + base + "rooms.json");
+        }
+
+        std::string parseError;
+        JsonValue rooms;
+        if (!JsonValue::parse(roomsText, rooms, parseError)) {
+            return fail("rooms.json: " + parseError);
+        }
+
+        // Items are optional; an empty world is still a world
+        JsonValue items;
+        std::string itemsText = Utils::readFile(base + "items.json");
+        if (!itemsText.empty() && !JsonValue::parse(itemsText, items, parseError)) {
+            return fail("items.json: " + parseError);
+        }
+
+        if (!loadJson(rooms, items, world)) {
+            return false;
+        }
+        
+        RuleCompiler compiler;
+        world.rules = compiler.loadFile(base + "rules.json");
+        if (!compiler.getError().empty()) {
+            return fail(compiler.getError());
+        }
+        return true;
+    }
+
+    bool WorldLoader::loadJson(const JsonValue& rooms, const JsonValue& items, WorldSnapshot& world) {
+        error_.clear();
+        world = WorldSnapshot();
+
+        const JsonValue& roomList = rooms["rooms"];
+        if (!roomList.isArray() || roomList.size() == 0) {
+            return fail("rooms.json: no rooms defined");
+        }
+
+        // Rooms are stored sorted by id; remember where each one came from
+        std::vector<size_t> order(roomList.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return roomList[a]["id"].asString() < roomList[b]["id"].asString();
+        });
+
+        std::unordered_map<std::string, uint32_t> roomIndex;
+        world.rooms.reserve(order.size());
+        for (size_t source : order) {
+            const JsonValue& room = roomList[source];
+            std::string id = room["id"].asString();
+            if (id.empty()) {
+                return fail("rooms.json: room " + std::to_string(source) + " has no id");
+            }
+            if (!roomIndex.emplace(id, static_cast<uint32_t>(world.rooms.size())).second) {
+                return fail("rooms.json: duplicate room id '" + id + "'");
+            }
+            world.rooms.push_back({id, room["name"].asString(id), room["description"].asString(),
+                                   false, room["lit"].asBool(true), room["locked"].asBool(false),
+                                   {}, {}});
+        }
+
+        const JsonValue& connections = rooms["connections"];
+        for (size_t i = 0; i < connections.size(); ++i) {
+            const JsonValue& link = connections[i];
+            auto from = roomIndex.find(link["from"].asString());
+            auto to = roomIndex.find(link["to"].asString());
+            std::string direction = Utils::toLower(link["direction"].asString());
+            if (from == roomIndex.end() || to == roomIndex.end() || direction.empty()) {
+                return fail("rooms.json: connection " + std::to_string(i) + " references an unknown room");
+            }
+            world.rooms[from->second].exits.emplace_back(direction, to->second);
+        }
+
+        const JsonValue& itemList = items["items"];
+        for (size_t i = 0; i < itemList.size(); ++i) {
+            const JsonValue& item = itemList[i];
+            std::string name = item["name"].asString();
+            if (name.empty()) {
+                return fail("items.json: item " + std::to_string(i) + " has no name");
+            }
+
+            // Items without a location are defined but not placed
+            std::string location = item["location"].asString();
+            auto room = roomIndex.end();
+            if (!location.empty()) {
+                room = roomIndex.find(location);
+                if (room == roomIndex.end()) {
+                    return fail("items.json: item '" + name + "' is in unknown room '" + location + "'");
+                }
+            }
+
+            uint32_t index = static_cast<uint32_t>(world.items.size());
+            world.items.push_back({name, item["description"].asString(), item["weight"].asInt(1),
+                                   item["takeable"].asBool(true),
+                                   parseItemType(item["type"].asString("misc")),
+                                   item["value"].asInt(0), item["damage"].asInt(0),
+                                   item["defense"].asInt(0), item["light_source"].asBool(false),
+                                   item["on"].asBool(false), item["fuel"].asInt(-1),
+                                   item["light_radius"].asInt(0)});
+            if (room != roomIndex.end()) {
+                world.rooms[room->second].items.push_back(index);
+            }
+        }
+
+        std::string start = rooms["start"].asString("west_of_house");
+        auto startRoom = roomIndex.find(start);
+        world.playerRoom = startRoom != roomIndex.end() ? startRoom->second
+                                                        : roomIndex[roomList[0]["id"].asString()];
+        world.playerName = "Adventurer";
+        world.playerHealth = Constants::INITIAL_PLAYER_HEALTH;
+        return true;
+    }
+}
@@ -0,0 +1,307 @@
+#include "../include/WorldPager.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace Zork {
+
+    namespace {
+        uint64_t mix(uint64_t value) {
+            value += 0x9e3779b97f4a7c15ULL;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+            return value ^ (value >> 31);
+        }
+
+        const char* const ROOM_NAMES[] = {
+            "Twisty Passage", "Damp Tunnel", "Collapsed Gallery",
+            "Echoing Cavern", "Narrow Crawlway", "Dusty Chamber"
+        };
+
+        const char* const ROOM_DESCRIPTIONS[] = {
+            "You are in a maze of twisty little passages, all alike.",
+            "Water drips steadily from the ceiling of this low tunnel.",
+            "Fallen rubble nearly blocks this once-grand gallery.",
+            "Your footsteps echo for a long time in this vast cavern.",
+            "You have to stoop to make your way through here.",
+            "A thick layer of dust covers everything in this chamber."
+        };
+
+        void releaseRooms(std::vector<RoomPtr>& rooms) {
+            for (auto& room : rooms) {
+                room->clearExits();
+            }
+            rooms.clear();
+        }
+    }
+
+    GridRegionSource::GridRegionSource(uint64_t seed, int width, int height, int regionSize,
+                                       const std::string& exitRoom)
+        : seed_(seed),
+          width_(width),
+          height_(height),
+          regionSize_(regionSize < 1 ? 1 : regionSize),
+          exitRoom_(exitRoom) {
+    }
+
+    std::string GridRegionSource::roomId(int x, int y) {
+        return "grid_" + std::to_string(x) + "_" + std::to_string(y);
+    }
+
+    bool GridRegionSource::parseRoomId(const std::string& roomId, int& x, int& y) const {
+        if (std::sscanf(roomId.c_str(), "grid_%d_%d", &x, &y) != 2) {
+            return false;
+        }
+        return x >= 0 && y >= 0 && x < width_ && y < height_;
+    }
+
+    std::string GridRegionSource::regionOf(const std::string& roomId) const {
+        int x, y;
+        if (!parseRoomId(roomId, x, y)) {
+            return "";
+        }
+        return "region_" + std::to_string(x / regionSize_) + "_" + std::to_string(y / regionSize_);
+    }
+
+    std::vector<RoomPtr> GridRegionSource::loadRegion(const std::string& regionId) {
+        std::vector<RoomPtr> rooms;
+        int rx, ry;
+        if (std::sscanf(regionId.c_str(), "region_%d_%d", &rx, &ry) != 2) {
+            return rooms;
+        }
+
+        int x0 = rx * regionSize_;
+        int y0 = ry * regionSize_;
+        int x1 = std::min(x0 + regionSize_, width_);
+        int y1 = std::min(y0 + regionSize_, height_);
+        int span = x1 - x0;
+        if (span <= 0 || y1 <= y0) {
+            return rooms;
+        }
+
+        const size_t variants = sizeof(ROOM_NAMES) / sizeof(ROOM_NAMES[0]);
+        rooms.reserve(static_cast<size_t>(span) * (y1 - y0));
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                uint64_t h = mix(seed_ ^ mix((static_cast<uint64_t>(x) << 32) | static_cast<uint32_t>(y)));
+                auto room = std::make_shared<Room>(roomId(x, y),
+                                                   ROOM_NAMES[h % variants],
+                                                   ROOM_DESCRIPTIONS[(h >> 8) % variants]);
+                if ((h >> 16) % 8 == 0) {
+                    room->setLit(false);
+                }
+                if ((h >> 24) % 16 == 0) {
+                    room->addItem(std::make_shared<Item>("coin", "A tarnished gold coin.", 1,
+                                                         true, ItemType::MISC));
+                }
+                rooms.push_back(room);
+            }
+        }
+
+        auto local = [&](int x, int y) { return rooms[(y - y0) * span + (x - x0)]; };
+        struct Step { const char* direction; int dx; int dy; };
+        const Step steps[] = {{"north", 0, -1}, {"south", 0, 1}, {"east", 1, 0}, {"west", -1, 0}};
+
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                for (const Step& step : steps) {
+                    int nx = x + step.dx;
+                    int ny = y + step.dy;
+                    if (nx < 0 || ny < 0 || nx >= width_ || ny >= height_) {
+                        continue;
+                    }
+                    if (nx >= x0 && nx < x1 && ny >= y0 && ny < y1) {
+                        local(x, y)->addExit(step.direction, local(nx, ny));
+                    } else {
+                        local(x, y)->addRemoteExit(step.direction, roomId(nx, ny));
+                    }
+                }
+            }
+        }
+        if (x0 == 0 && y0 == 0 && !exitRoom_.empty()) {
+            local(0, 0)->addRemoteExit("up", exitRoom_);
+        }
+        return rooms;
+    }
+
+    std::vector<std::string> GridRegionSource::neighborRegions(const std::string& regionId) const {
+        std::vector<std::string> neighbors;
+        int rx, ry;
+        if (std::sscanf(regionId.c_str(), "region_%d_%d", &rx, &ry) != 2) {
+            return neighbors;
+        }
+
+        int regionsX = (width_ + regionSize_ - 1) / regionSize_;
+        int regionsY = (height_ + regionSize_ - 1) / regionSize_;
+        const int offsets[][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}};
+        for (const auto& offset : offsets) {
+            int nx = rx + offset[0];
+            int ny = ry + offset[1];
+            if (nx >= 0 && ny >= 0 && nx < regionsX && ny < regionsY) {
+                neighbors.push_back("region_" + std::to_string(nx) + "_" + std::to_string(ny));
+            }
+        }
+        return neighbors;
+    }
+
+    WorldPager::WorldPager(std::unique_ptr<RegionSource> source, size_t capacity)
+        : source_(std::move(source)),
+          capacity_(capacity < 2 ? 2 : capacity),
+          stopping_(false),
+          faults_(0),
+          prefetchHits_(0),
+          evictions_(0) {
+        worker_ = std::thread(&WorldPager::prefetchLoop, this);
+    }
+
+    WorldPager::~WorldPager() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        worker_.join();
+
+        for (auto& pair : prefetched_) {
+            releaseRooms(pair.second);
+        }
+        for (auto& pair : resident_) {
+            releaseRooms(pair.second.rooms);
+        }
+    }
+
+    void WorldPager::prefetchLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this] { return stopping_ || !prefetchQueue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+
+            std::string regionId = prefetchQueue_.front();
+            prefetchQueue_.pop_front();
+
+            lock.unlock();
+            std::vector<RoomPtr> rooms = source_->loadRegion(regionId);
+            lock.lock();
+
+            prefetched_[regionId] = std::move(rooms);
+            inFlight_.erase(regionId);
+            loaded_.notify_all();
+        }
+    }
+
+    void WorldPager::schedulePrefetch(const std::string& regionId) {
+        std::vector<std::string> neighbors = source_->neighborRegions(regionId);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Speculative loads for a region we have walked away from are dropped
+        for (auto it = prefetched_.begin(); it != prefetched_.end();) {
+            if (std::find(neighbors.begin(), neighbors.end(), it->first) == neighbors.end()) {
+                releaseRooms(it->second);
+                it = prefetched_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (const std::string& neighbor : neighbors) {
+            if (resident_.count(neighbor) || inFlight_.count(neighbor) || prefetched_.count(neighbor)) {
+                continue;
+            }
+            inFlight_.insert(neighbor);
+            prefetchQueue_.push_back(neighbor);
+        }
+        wake_.notify_one();
+    }
+
+    std::vector<RoomPtr> WorldPager::acquireRegion(const std::string& regionId) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            
+            // Still queued behind other prefetches: take it over ourselves
+            auto queued = std::find(prefetchQueue_.begin(), prefetchQueue_.end(), regionId);
+            if (queued != prefetchQueue_.end()) {
+                prefetchQueue_.erase(queued);
+                inFlight_.erase(regionId);
+            }
+            loaded_.wait(lock, [&] { return !inFlight_.count(regionId); });
+
+            auto ready = prefetched_.find(regionId);
+            if (ready != prefetched_.end()) {
+                std::vector<RoomPtr> rooms = std::move(ready->second);
+                prefetched_.erase(ready);
+                ++prefetchHits_;
+                return rooms;
+            }
+        }
+
+        ++faults_;
+        return source_->loadRegion(regionId);
+    }
+
+    void WorldPager::makeResident(const std::string& regionId, std::vector<RoomPtr> rooms) {
+        for (auto& room : rooms) {
+            auto saved = overlay_.find(room->getId());
+            if (saved != overlay_.end()) {
+                room->setVisited(saved->second.visited);
+                std::vector<ItemPtr> stale = room->getItems();
+                for (const auto& item : stale) {
+                    room->removeItem(item);
+                }
+                for (auto& item : saved->second.items) {
+                    room->addItem(item);
+                }
+                overlay_.erase(saved);
+            }
+            roomIndex_[room->getId()] = room;
+        }
+
+        lru_.push_front(regionId);
+        Region& region = resident_[regionId];
+        region.rooms = std::move(rooms);
+        region.lruPosition = lru_.begin();
+
+        while (resident_.size() > capacity_) {
+            evictOne();
+        }
+    }
+
+    void WorldPager::evictOne() {
+        std::string victim = lru_.back();
+        lru_.pop_back();
+
+        auto it = resident_.find(victim);
+        for (auto& room : it->second.rooms) {
+            // Only rooms the player has been in can differ from the source
+            if (room->isVisited()) {
+                overlay_[room->getId()] = RoomState{true, room->getItems()};
+            }
+            roomIndex_.erase(room->getId());
+        }
+        releaseRooms(it->second.rooms);
+        resident_.erase(it);
+        ++evictions_;
+    }
+
+    RoomPtr WorldPager::getRoom(const std::string& roomId) {
+        std::string regionId = source_->regionOf(roomId);
+        if (regionId.empty()) {
+            return nullptr;
+        }
+
+        auto region = resident_.find(regionId);
+        if (region != resident_.end()) {
+            if (region->second.lruPosition != lru_.begin()) {
+                lru_.splice(lru_.begin(), lru_, region->second.lruPosition);
+                schedulePrefetch(regionId);
+            }
+        } else {
+            makeResident(regionId, acquireRegion(regionId));
+            schedulePrefetch(regionId);
+        }
+
+        auto room = roomIndex_.find(roomId);
+        return room != roomIndex_.end() ? room->second : nullptr;
+    }
+}
@@ -0,0 +1,157 @@
+#include "../include/WorldWatcher.h"
+#include "../include/WorldLoader.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace Zork {
+
+    namespace {
+        // ConfigMap updates arrive as a burst of symlink swaps; wait for
+        // the directory to go quiet before rebuilding
+        const int SETTLE_MILLISECONDS = 250;
+        const int POLL_INTERVAL_MILLISECONDS = 2000;
+
+        uint64_t directoryFingerprint(const std::string& directory) {
+            namespace fs = std::filesystem;
+            uint64_t fingerprint = 0;
+            std::error_code ec;
+            for (const auto& entry : fs::directory_iterator(directory, ec)) {
+                auto stamp = fs::last_write_time(entry.path(), ec).time_since_epoch().count();
+                auto size = entry.is_regular_file(ec) ? entry.file_size(ec) : 0;
+                fingerprint = fingerprint * 1099511628211ULL ^ static_cast<uint64_t>(stamp) ^ (size << 1);
+            }
+            return fingerprint;
+        }
+    }
+
+    WorldWatcher::WorldWatcher(const std::string& directory)
+        : directory_(directory),
+          version_(0),
+          stopping_(false),
+          wakeFd_{-1, -1} {
+        std::string error;
+        if (!reload(error)) {
+            std::cerr << "World data not loaded: " << error << std::endl;
+        }
+
+#ifdef __linux__
+        if (pipe(wakeFd_) != 0) {
+            wakeFd_[0] = wakeFd_[1] = -1;
+        }
+        thread_ = std::thread(&WorldWatcher::watchLoop, this);
+#else
+        thread_ = std::thread(&WorldWatcher::pollLoop, this);
+#endif
+    }
+
+    WorldWatcher::~WorldWatcher() {
+        stopping_ = true;
+#ifdef __linux__
+        if (wakeFd_[1] >= 0) {
+            char byte = 0;
+            ssize_t ignored = write(wakeFd_[1], &byte, 1);
+            (void)ignored;
+        }
+#endif
+        thread_.join();
+#ifdef __linux__
+        if (wakeFd_[0] >= 0) {
+            close(wakeFd_[0]);
+            close(wakeFd_[1]);
+        }
+#endif
+    }
+
+    bool WorldWatcher::reload(std::string& error) {
+        auto world = std::make_shared<WorldSnapshot>();
+        WorldLoader loader;
+        if (!loader.loadDirectory(directory_, *world)) {
+            error = loader.getError();
+            return false;
+        }
+        world->rng.seed(std::random_device{}());
+
+        std::atomic_store(&current_, SnapshotPtr(std::move(world)));
+        version_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    void WorldWatcher::watchLoop() {
+#ifdef __linux__
+        int fd = inotify_init1(IN_CLOEXEC);
+        if (fd < 0 || wakeFd_[0] < 0 ||
+            inotify_add_watch(fd, directory_.c_str(),
+                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                              IN_CREATE | IN_DELETE | IN_ATTRIB) < 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            pollLoop();
+            return;
+        }
+
+        pollfd fds[2] = {{fd, POLLIN, 0}, {wakeFd_[0], POLLIN, 0}};
+        bool pending = false;
+        while (!stopping_) {
+            int ready = poll(fds, 2, pending ? SETTLE_MILLISECONDS : -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (fds[1].revents) {
+                break;
+            }
+            if (ready == 0) {
+                pending = false;
+                std::string error;
+                if (!reload(error)) {
+                    std::cerr << "World reload rejected: " << error << std::endl;
+                }
+                continue;
+            }
+            if (fds[0].revents & POLLIN) {
+                char buffer[4096];
+                ssize_t drained = read(fd, buffer, sizeof(buffer));
+                (void)drained;
+                pending = true;
+            }
+        }
+        close(fd);
+#else
+        pollLoop();
+#endif
+    }
+
+    void WorldWatcher::pollLoop() {
+        uint64_t last = directoryFingerprint(directory_);
+        int waited = 0;
+        while (!stopping_) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            waited += 100;
+            if (waited < POLL_INTERVAL_MILLISECONDS) {
+                continue;
+            }
+            waited = 0;
+
+            uint64_t fingerprint = directoryFingerprint(directory_);
+            if (fingerprint != last) {
+                last = fingerprint;
+                std::string error;
+                if (!reload(error)) {
+                    std::cerr << "World reload rejected: " << error << std::endl;
+                }
+            }
+        }
+    }
+}
@@ -1,16 +1,171 @@
 #include "../include/Game.h"
+#include "../include/WorldWatcher.h"
+#include "../include/SessionManager.h"
+#include "../include/GameServer.h"
+#include "../include/Constants.h"
+#include "../include/Leaderboard.h"
+#include "../include/SharedWorld.h"
 #include <iostream>
 #include <exception>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <random>
+
+namespace {
+    Zork::GameServer* runningServer = nullptr;
+
+    void stopServer(int) {
+        if (runningServer) {
+            runningServer->stop();
+        }
+    }
+
+    size_t byteSetting(const char* name, size_t fallback) {
+        const char* configured = std::getenv(name);
+        return configured && *configured ? std::strtoull(configured, nullptr, 10) : fallback;
+    }
+
+    double rateSetting(const char* name, double fallback) {
+        const char* configured = std::getenv(name);
+        return configured && *configured ? std::strtod(configured, nullptr) : fallback;
+    }
+
+    int serve(const std::string& address, uint16_t port, size_t threads, bool shared, Zork::WorldWatcher* watcher) {
+        // The built-in world doubles as the template when there is no data
+        // directory (or it failed to load)
+        Zork::Game base;
+        base.setOutput(nullptr);
+        base.start();
+        Zork::Leaderboard leaderboard(Zork::SaveManager().getSaveDirectory());
+        Zork::ThreadPool pool(threads);
+
+        // One world for everybody instead of a game per session. It is
+        // stamped once, so it does not follow later data reloads, and it
+        // outlives the sessions, which save it as they shut down.
+        std::unique_ptr<Zork::SharedWorld> world;
+        if (shared) {
+            Zork::SnapshotPtr current = watcher ? watcher->current() : nullptr;
+            world = std::make_unique<Zork::SharedWorld>(current ? current : base.snapshot(), pool);
+        }
+        Zork::SessionManager sessions(base.snapshot(), watcher, &pool);
+        sessions.setLeaderboard(&leaderboard);
+        if (world) {
+            sessions.setSharedWorld(world.get());
+        }
+        sessions.setMemoryBudget(byteSetting("ZORK_SESSION_SOFT_BYTES", Zork::Constants::SESSION_SOFT_BUDGET_BYTES),
+                                 byteSetting("ZORK_SESSION_HARD_BYTES", Zork::Constants::SESSION_HARD_BUDGET_BYTES),
+                                 byteSetting("ZORK_MEMORY_BUDGET_BYTES", Zork::Constants::MEMORY_BUDGET_BYTES));
+
+        Zork::GameServer server(sessions, &pool, &leaderboard);
+        int hibernateAfter = Zork::Constants::HIBERNATE_AFTER_SECONDS;
+        if (const char* configured = std::getenv("ZORK_HIBERNATE_SECONDS")) {
+            hibernateAfter = std::atoi(configured);
+        }
+        server.setHibernateAfter(hibernateAfter);
+        server.setRateLimits(rateSetting("ZORK_SESSION_RATE", Zork::Constants::SESSION_COMMAND_RATE),
+                             rateSetting("ZORK_SESSION_BURST", Zork::Constants::SESSION_COMMAND_BURST),
+                             rateSetting("ZORK_ADDRESS_RATE", Zork::Constants::ADDRESS_REQUEST_RATE),
+                             rateSetting("ZORK_ADDRESS_BURST", Zork::Constants::ADDRESS_REQUEST_BURST));
+        server.setAdmissionLimits(byteSetting("ZORK_MAX_IN_FLIGHT", Zork::Constants::MAX_IN_FLIGHT),
+                                  static_cast<int>(byteSetting("ZORK_MAX_P99_MS", Zork::Constants::MAX_P99_MS)));
+        if (!server.listen(address, port)) {
+            std::cerr << "Cannot start server: " << server.getHttp().getError() << std::endl;
+            return 1;
+        }
+
+        runningServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        std::cout << "Zork server listening on " << address << ":" << server.getHttp().getPort()
+                  << " with " << pool.size() << " worker threads" << (world ? " (shared world)" : "") << std::endl;
+        server.run();
+        runningServer = nullptr;
+        // Finish queued turns while the server they answer to still exists
+        pool.shutdown();
+        return 0;
+    }
+}
 
 int main(int argc, char* argv[]) {
     try {
-        Zork::Game game;
-        game.start();
-        game.run();
+        bool serverMode = false;
+        bool shared = false;
+        std::string address = "0.0.0.0";
+        uint16_t port = 8080;
+        size_t threads = 0;
+        int gridWidth = 0;
+        int gridHeight = 0;
+        uint64_t gridSeed = 1;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--serve") == 0) {
+                serverMode = true;
+            } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+                port = static_cast<uint16_t>(std::atoi(argv[++i]));
+            } else if (std::strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+                address = argv[++i];
+            } else if (std::strcmp(argv[i], "--shared") == 0) {
+                shared = true;
+            } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                threads = static_cast<size_t>(std::atoi(argv[++i]));
+            } else if (std::strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+                if (std::sscanf(argv[++i], "%dx%d", &gridWidth, &gridHeight) != 2 ||
+                    gridWidth <= 0 || gridHeight <= 0) {
+                    std::cerr << "--grid expects WIDTHxHEIGHT, e.g. 1000x1000" << std::endl;
+                    return 2;
+                }
+            } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+                gridSeed = std::strtoull(argv[++i], nullptr, 10);
+            }
+        }
+
+        // With ZORK_DATA_DIR set, the world comes from the data files and
+        // follows them as they change; otherwise the built-in world is used
+        std::unique_ptr<Zork::WorldWatcher> watcher;
+        const char* dataDir = std::getenv("ZORK_DATA_DIR");
+        if (dataDir && *dataDir) {
+            watcher = std::make_unique<Zork::WorldWatcher>(dataDir);
+        }
+
+        if (serverMode) {
+            if (gridWidth > 0) {
+                // Sessions are stamped from snapshots, which leave paged rooms out
+                std::cerr << "--grid is only available in single-player mode; ignoring it" << std::endl;
+            }
+            return serve(address, port, threads, shared, watcher.get());
+        }
+
+        std::unique_ptr<Zork::Game> game;
+        if (watcher) {
+            if (Zork::SnapshotPtr world = watcher->current()) {
+                game = std::make_unique<Zork::Game>(*world);
+                game->reseed(std::random_device{}());
+                game->setWorldSource(watcher.get());
+            }
+        }
+        if (!game) {
+            game = std::make_unique<Zork::Game>();
+        }
+        // A procedural maze below the cellar, paged in a region at a time
+        if (gridWidth > 0) {
+            game->enablePaging(std::make_unique<Zork::GridRegionSource>(gridSeed, gridWidth, gridHeight,
+                                                                        Zork::Constants::GRID_REGION_SIZE,
+                                                                        Zork::Constants::GRID_ENTRANCE),
+                               Zork::Constants::RESIDENT_REGIONS, Zork::Constants::GRID_ENTRANCE);
+        }
+
+        Zork::Leaderboard leaderboard(Zork::SaveManager().getSaveDirectory());
+        game->setScoreObserver([&leaderboard](const Zork::Game& played, bool) {
+            leaderboard.record(played.getPlayer()->getName(), played.getScore(), played.getMoves());
+        });
+
+        game->start();
+        game->run();
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
         return 1;
     }
-    
+
     return 0;
 }
@@ -0,0 +1,45 @@
+#include "../include/Game.h"
+#include "../include/MemoryAccount.h"
+#include "Check.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Zork;
+
+namespace {
+    const int ROUNDS = 1000;
+
+    // Heap allocations per command once the game has warmed up, counted by
+    // the MemoryAccount operator new hook. Commands are parsed up front, so
+    // only running them is measured.
+    double allocationsPer(Game& game, const std::string& input) {
+        std::vector<Command> commands{Command(input)};
+        game.processCommands(commands);
+
+        MemoryAccountPtr account = MemoryAccount::create();
+        {
+            MemoryAccount::Scope charge(account.get());
+            for (int i = 0; i < ROUNDS; ++i) {
+                game.processCommands(commands);
+            }
+        }
+        double perCommand = static_cast<double>(account->allocations()) / ROUNDS;
+        std::cout << input << ": " << perCommand << " allocations per command" << std::endl;
+        return perCommand;
+    }
+}
+
+int main() {
+    std::ostream discard(nullptr);
+    Game game;
+    game.setOutput(&discard);
+    game.start();
+    game.processCommand("take leaflet");
+
+    // Rooms render from their cached text and getters hand out references,
+    // so neither command should copy the world
+    CHECK(allocationsPer(game, "look") < 1);
+    CHECK(allocationsPer(game, "inventory") <= 4);
+    return TEST_RESULT();
+}
@@ -0,0 +1,22 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+namespace ZorkTest {
+    inline int failures = 0;
+}
+
+// Reports a failed condition and carries on, so one run shows every failure
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #condition      \
+                      << std::endl;                                             \
+            ++ZorkTest::failures;                                               \
+        }                                                                       \
+    } while (false)
+
+#define TEST_RESULT() (ZorkTest::failures == 0 ? 0 : 1)
+
+#endif // CHECK_H
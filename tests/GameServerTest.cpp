@@ -0,0 +1,192 @@
+#include "../include/GameServer.h"
+#include "../include/Json.h"
+#include "Check.h"
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <filesystem>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace Zork;
+namespace fs = std::filesystem;
+
+namespace {
+    struct Response {
+        int status = 0;
+        std::string body;
+    };
+
+    // A keep-alive client that reads responses one at a time, so several
+    // requests can be written before any answer is read
+    class Client {
+    private:
+        int fd_;
+        std::string buffer_;
+
+    public:
+        explicit Client(uint16_t port) : fd_(::socket(AF_INET, SOCK_STREAM, 0)) {
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+        ~Client() {
+            if (fd_ >= 0) {
+                ::close(fd_);
+            }
+        }
+
+        bool connected() const { return fd_ >= 0; }
+
+        static std::string request(const std::string& method, const std::string& path,
+                                   const std::string& body = "") {
+            return method + " " + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Length: " +
+                   std::to_string(body.size()) + "\r\n\r\n" + body;
+        }
+
+        bool send(const std::string& data) {
+            return ::send(fd_, data.data(), data.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(data.size());
+        }
+
+        Response receive() {
+            Response response;
+            size_t headerEnd;
+            while ((headerEnd = buffer_.find("\r\n\r\n")) == std::string::npos) {
+                if (!fill()) {
+                    return response;
+                }
+            }
+            response.status = std::atoi(buffer_.c_str() + buffer_.find(' ') + 1);
+            size_t length = 0;
+            size_t field = buffer_.find("Content-Length: ");
+            if (field != std::string::npos && field < headerEnd) {
+                length = std::strtoull(buffer_.c_str() + field + 16, nullptr, 10);
+            }
+            size_t bodyStart = headerEnd + 4;
+            while (buffer_.size() < bodyStart + length) {
+                if (!fill()) {
+                    response.status = 0;
+                    return response;
+                }
+            }
+            response.body = buffer_.substr(bodyStart, length);
+            buffer_.erase(0, bodyStart + length);
+            return response;
+        }
+
+    private:
+        bool fill() {
+            char chunk[4096];
+            ssize_t got = ::recv(fd_, chunk, sizeof(chunk), 0);
+            if (got <= 0) {
+                return false;
+            }
+            buffer_.append(chunk, static_cast<size_t>(got));
+            return true;
+        }
+    };
+
+    JsonValue parse(const std::string& body) {
+        JsonValue document;
+        std::string error;
+        JsonValue::parse(body, document, error);
+        return document;
+    }
+
+    std::string command(const std::string& id, const std::string& text) {
+        return Client::request("POST", "/session/" + id + "/command", "{\"command\":\"" + text + "\"}");
+    }
+
+    void testSessionLifecycle(uint16_t port) {
+        Client client(port);
+        CHECK(client.connected());
+
+        CHECK(client.send(Client::request("POST", "/session", "{\"name\":\"tester\"}")));
+        Response created = client.receive();
+        CHECK(created.status == 201);
+        std::string id = parse(created.body)["session"].asString();
+        CHECK(id.size() == 32);
+        CHECK(parse(created.body)["roomId"].asString() == "west_of_house");
+
+        // One request, a pipeline of two moves
+        CHECK(client.send(command(id, "s. e")));
+        Response moved = client.receive();
+        CHECK(moved.status == 200);
+        CHECK(parse(moved.body)["roomId"].asString() == "kitchen");
+
+        // Two requests written back to back are answered in order
+        CHECK(client.send(command(id, "take lamp") + command(id, "w")));
+        Response taken = client.receive();
+        Response walked = client.receive();
+        CHECK(taken.status == 200 && parse(taken.body)["success"].asBool());
+        CHECK(parse(taken.body)["roomId"].asString() == "kitchen");
+        CHECK(walked.status == 200 && parse(walked.body)["roomId"].asString() == "behind_house");
+
+        CHECK(client.send(Client::request("DELETE", "/session/" + id)));
+        CHECK(client.receive().status == 204);
+        CHECK(client.send(command(id, "look")));
+        CHECK(client.receive().status == 404);
+    }
+
+    void testIdsDiffer(uint16_t port) {
+        Client client(port);
+        std::string ids[2];
+        for (std::string& id : ids) {
+            CHECK(client.send(Client::request("POST", "/session")));
+            id = parse(client.receive().body)["session"].asString();
+        }
+        CHECK(!ids[0].empty() && ids[0] != ids[1]);
+    }
+
+    // Paths that only look like a command still pay the address's token
+    void testMalformedPathsPay(uint16_t port) {
+        Client client(port);
+        for (const char* path : {"/sessionX/command", "/session/a/b/command", "/session//command"}) {
+            CHECK(client.send(Client::request("POST", path, "look")));
+            CHECK(client.receive().status == 404);
+        }
+        CHECK(client.send(Client::request("POST", "/session/a/b/command", "look")));
+        CHECK(client.receive().status == 429);
+    }
+}
+
+int main() {
+    fs::path saves = fs::temp_directory_path() / ("zork-server-" + std::to_string(::getpid()));
+    ::setenv("ZORK_SAVE_DIR", saves.c_str(), 1);
+    {
+        Game base;
+        base.setOutput(nullptr);
+        base.start();
+        ThreadPool pool(2);
+        SessionManager sessions(base.snapshot(), nullptr, &pool);
+        GameServer server(sessions, &pool);
+        CHECK(server.listen("127.0.0.1", 0));
+        std::thread loop([&server]() { server.run(); });
+
+        uint16_t port = server.getHttp().getPort();
+        testSessionLifecycle(port);
+        testIdsDiffer(port);
+
+        // An address may make three requests, and never earns another
+        GameServer limited(sessions, &pool);
+        limited.setRateLimits(0, 0, 0.001, 3);
+        CHECK(limited.listen("127.0.0.1", 0));
+        std::thread limitedLoop([&limited]() { limited.run(); });
+        testMalformedPathsPay(limited.getHttp().getPort());
+
+        limited.stop();
+        limitedLoop.join();
+        server.stop();
+        loop.join();
+        pool.shutdown();
+    }
+    fs::remove_all(saves);
+    return TEST_RESULT();
+}
@@ -0,0 +1,71 @@
+#include "../include/Leaderboard.h"
+#include "Check.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+using namespace Zork;
+namespace fs = std::filesystem;
+
+namespace {
+    std::string freshDirectory(const std::string& name) {
+        fs::path path = fs::temp_directory_path() /
+                        ("zork-" + name + "-" + std::to_string(::getpid()));
+        fs::remove_all(path);
+        return path.string() + "/";
+    }
+
+    void append(const std::string& path, const std::string& text) {
+        std::ofstream out(path, std::ios::app | std::ios::binary);
+        out << text;
+    }
+
+    void testTornAndDamagedLines() {
+        std::string directory = freshDirectory("leaderboard");
+        std::string log = directory + "leaderboard.wal";
+        {
+            Leaderboard board(directory);
+            board.record("alice", 120, 14);
+            board.record("bob", 90, 30);
+            board.sync();
+        }
+        // A line whose checksum does not match, then a crash mid-name
+        append(log, "500\t1\tmallory\t00000000\n");
+        append(log, "130\t12\talic");
+
+        size_t position;
+        LeaderboardEntry entry;
+        {
+            Leaderboard board(directory);
+            CHECK(board.size() == 2);
+            CHECK(!board.rank("alic", position, entry));
+            CHECK(!board.rank("mallory", position, entry));
+            CHECK(board.rank("alice", position, entry) && position == 1 && entry.score == 120);
+            board.record("carol", 100, 20);
+            board.sync();
+        }
+        // The torn tail was cut off, so the next record starts a line of its own
+        Leaderboard board(directory);
+        CHECK(board.size() == 3);
+        CHECK(board.rank("carol", position, entry) && position == 2);
+        fs::remove_all(directory);
+    }
+
+    void testThreeFieldLinesStillLoad() {
+        std::string directory = freshDirectory("leaderboard-old");
+        fs::create_directories(directory);
+        append(directory + "leaderboard.wal", "75\t40\tdave\n");
+        Leaderboard board(directory);
+        size_t position;
+        LeaderboardEntry entry;
+        CHECK(board.rank("dave", position, entry) && entry.score == 75 && entry.moves == 40);
+        fs::remove_all(directory);
+    }
+}
+
+int main() {
+    testTornAndDamagedLines();
+    testThreeFieldLinesStillLoad();
+    return TEST_RESULT();
+}
@@ -0,0 +1,121 @@
+#include "../include/SaveStore.h"
+#include "Check.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+using namespace Zork;
+namespace fs = std::filesystem;
+
+namespace {
+    // Records of these keys and values are 20 bytes each: a 16-byte header,
+    // then the key and the value
+    const size_t RECORD = 20;
+
+    std::string freshDirectory(const std::string& name) {
+        fs::path path = fs::temp_directory_path() /
+                        ("zork-" + name + "-" + std::to_string(::getpid()));
+        fs::remove_all(path);
+        return path.string() + "/";
+    }
+
+    void writeThree(const std::string& directory) {
+        SaveStore store(directory);
+        CHECK(store.isOpen());
+        CHECK(store.put("k1", "v1"));
+        CHECK(store.put("k2", "v2"));
+        CHECK(store.put("k3", "v3"));
+    }
+
+    void flipByte(const std::string& path, size_t offset) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(offset));
+        char byte = 0;
+        file.get(byte);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(static_cast<char>(byte ^ 0x5a));
+    }
+
+    void testCorruptRecordInSealedSegment() {
+        std::string directory = freshDirectory("sealed");
+        writeThree(directory);
+        std::string first = directory + "saves-0000000001.log";
+        flipByte(first, RECORD + 18);
+        // A later segment makes the first one sealed
+        std::ofstream(directory + "saves-0000000002.log").close();
+
+        {
+            SaveStore store(directory);
+            std::string value;
+            CHECK(store.get("k1", value) && value == "v1");
+            CHECK(!store.contains("k2"));
+            CHECK(store.get("k3", value) && value == "v3");
+            CHECK(!store.getError().empty());
+        }
+        CHECK(fs::file_size(first) == 3 * RECORD);
+        fs::remove_all(directory);
+    }
+
+    void testCorruptRecordInActiveSegment() {
+        std::string directory = freshDirectory("active");
+        writeThree(directory);
+        flipByte(directory + "saves-0000000001.log", RECORD + 18);
+
+        {
+            SaveStore store(directory);
+            std::string value;
+            CHECK(store.get("k1", value) && value == "v1");
+            CHECK(!store.contains("k2"));
+            CHECK(store.get("k3", value) && value == "v3");
+            CHECK(store.put("k4", "v4"));
+        }
+        SaveStore store(directory);
+        std::string value;
+        CHECK(store.get("k3", value) && value == "v3");
+        CHECK(store.get("k4", value) && value == "v4");
+        fs::remove_all(directory);
+    }
+
+    void testTornTailIsCut() {
+        std::string directory = freshDirectory("torn");
+        writeThree(directory);
+        std::string first = directory + "saves-0000000001.log";
+        fs::resize_file(first, 3 * RECORD - 5);
+
+        {
+            SaveStore store(directory);
+            CHECK(store.contains("k1"));
+            CHECK(store.contains("k2"));
+            CHECK(!store.contains("k3"));
+        }
+        CHECK(fs::file_size(first) == 2 * RECORD);
+        fs::remove_all(directory);
+    }
+
+    void testOneStorePerDirectory() {
+        std::string directory = freshDirectory("locked");
+        {
+            SaveStore first(directory);
+            CHECK(first.isOpen());
+            CHECK(first.put("k1", "v1"));
+            SaveStore second(directory);
+            CHECK(!second.isOpen());
+            CHECK(!second.put("k2", "v2"));
+            CHECK(!second.getError().empty());
+        }
+        SaveStore reopened(directory);
+        CHECK(reopened.isOpen());
+        std::string value;
+        CHECK(reopened.get("k1", value) && value == "v1");
+        fs::remove_all(directory);
+    }
+}
+
+int main() {
+    testCorruptRecordInSealedSegment();
+    testCorruptRecordInActiveSegment();
+    testTornTailIsCut();
+    testOneStorePerDirectory();
+    return TEST_RESULT();
+}
@@ -0,0 +1,95 @@
+#include "../include/Game.h"
+#include "Check.h"
+#include <string>
+
+using namespace Zork;
+
+namespace {
+    bool run(Game& game, const std::string& input) {
+        bool success = game.processCommand(input).success;
+        game.takeOutput();
+        return success;
+    }
+
+    void startQuietly(Game& game) {
+        game.setOutput(nullptr);
+        game.start();
+        game.takeOutput();
+    }
+
+    void testTakeDropMove() {
+        Game game;
+        startQuietly(game);
+        // Triggers score too, and undo has to take that back with the drop
+        game.addTrigger("west_of_house", "drop", "leaflet",
+                        [](Game& played, std::string&) { played.addScore(7); });
+        PlayerPtr player = game.getPlayer();
+        RoomPtr field = player->getCurrentRoom();
+        int start = game.getScore();
+
+        CHECK(run(game, "take leaflet"));
+        int taken = game.getScore();
+        CHECK(run(game, "drop leaflet"));
+        int dropped = game.getScore();
+        CHECK(dropped == taken + 7);
+        CHECK(run(game, "s"));
+        RoomPtr behind = player->getCurrentRoom();
+        int moved = game.getScore();
+        CHECK(behind != field);
+
+        CHECK(run(game, "undo"));
+        CHECK(player->getCurrentRoom() == field);
+        CHECK(game.getScore() == dropped);
+        CHECK(run(game, "undo"));
+        CHECK(player->hasItem("leaflet") && !field->hasItem("leaflet"));
+        CHECK(game.getScore() == taken);
+        CHECK(run(game, "undo"));
+        CHECK(!player->hasItem("leaflet") && field->hasItem("leaflet"));
+        CHECK(game.getScore() == start);
+        CHECK(!run(game, "undo"));
+
+        CHECK(run(game, "redo"));
+        CHECK(player->hasItem("leaflet") && game.getScore() == taken);
+        CHECK(run(game, "redo"));
+        CHECK(field->hasItem("leaflet") && game.getScore() == dropped);
+        CHECK(run(game, "redo"));
+        CHECK(player->getCurrentRoom() == behind && game.getScore() == moved);
+        CHECK(!run(game, "redo"));
+    }
+
+    void testNewCommandDropsRedo() {
+        Game game;
+        startQuietly(game);
+        CHECK(run(game, "take leaflet"));
+        CHECK(run(game, "undo"));
+        CHECK(run(game, "s"));
+        CHECK(!run(game, "redo"));
+    }
+
+    void testRuleEffects() {
+        Game game;
+        startQuietly(game);
+        PlayerPtr player = game.getPlayer();
+        for (const char* step : {"s", "e", "u", "take rope"}) {
+            CHECK(run(game, step));
+        }
+        int taken = game.getScore();
+        CHECK(run(game, "use rope"));
+        CHECK(!player->hasItem("rope"));
+
+        CHECK(run(game, "undo"));
+        CHECK(player->hasItem("rope"));
+        CHECK(game.getScore() == taken);
+        // The rope_tied flag went back too, so the rule applies again
+        CHECK(run(game, "use rope"));
+        CHECK(!player->hasItem("rope"));
+        CHECK(!player->getCurrentRoom()->hasItem("rope"));
+    }
+}
+
+int main() {
+    testTakeDropMove();
+    testNewCommandDropsRedo();
+    testRuleEffects();
+    return TEST_RESULT();
+}
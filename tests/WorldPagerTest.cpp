@@ -0,0 +1,69 @@
+#include "../include/Game.h"
+#include "Check.h"
+#include <memory>
+#include <string>
+
+using namespace Zork;
+
+namespace {
+    bool run(Game& game, const std::string& input) {
+        bool success = game.processCommand(input).success;
+        game.takeOutput();
+        return success;
+    }
+
+    // A 4x1 grid of one-room regions with two kept resident, so walking
+    // three rooms east pages out the first one
+    void testUndoDropAfterEviction() {
+        Game game;
+        game.setOutput(nullptr);
+        game.enablePaging(std::make_unique<GridRegionSource>(7, 4, 1, 1, "cellar"), 2, "cellar");
+        game.start();
+
+        for (const char* step : {"take leaflet", "s", "e", "take lamp", "use lamp", "d", "d"}) {
+            CHECK(run(game, step));
+        }
+        PlayerPtr player = game.getPlayer();
+        CHECK(player->getCurrentRoom()->getId() == GridRegionSource::roomId(0, 0));
+        CHECK(run(game, "drop leaflet"));
+        for (int i = 0; i < 3; ++i) {
+            CHECK(run(game, "e"));
+        }
+        CHECK(game.getPager()->getEvictions() > 0);
+
+        for (int i = 0; i < 4; ++i) {
+            CHECK(run(game, "undo"));
+        }
+        RoomPtr corner = game.getRoom(GridRegionSource::roomId(0, 0));
+        CHECK(player->getCurrentRoom() == corner);
+        CHECK(player->hasItem("leaflet"));
+        CHECK(!corner->hasItem("leaflet"));
+
+        CHECK(run(game, "redo"));
+        CHECK(!player->hasItem("leaflet"));
+        CHECK(corner->hasItem("leaflet"));
+    }
+
+    // Paged rooms are left out of snapshots, so a clone taken down there
+    // puts the player back at the entrance rather than in some other room
+    void testCloneInPagedRoom() {
+        Game game;
+        game.setOutput(nullptr);
+        game.enablePaging(std::make_unique<GridRegionSource>(7, 4, 1, 1, "cellar"), 2, "cellar");
+        game.start();
+        for (const char* step : {"s", "e", "take lamp", "use lamp", "d", "d", "e"}) {
+            CHECK(run(game, step));
+        }
+        CHECK(game.getPlayer()->getCurrentRoom()->getId() == GridRegionSource::roomId(1, 0));
+
+        std::unique_ptr<Game> copy = game.clone();
+        CHECK(copy->getPlayer()->getCurrentRoom()->getId() == "cellar");
+        CHECK(copy->getPlayer()->hasItem("lamp"));
+    }
+}
+
+int main() {
+    testUndoDropAfterEviction();
+    testCloneInPagedRoom();
+    return TEST_RESULT();
+}
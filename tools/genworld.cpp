@@ -0,0 +1,424 @@
+// zork-genworld: writes a procedurally generated world in the data/ schema
+// (rooms.json, items.json, enemies.json) for load and soak tests. Point
+// ZORK_DATA_DIR or zork-validate at the output directory. The same seed and
+// options always give byte-identical files.
+//
+//     zork-genworld [--seed N] [--rooms N] [--levels N] [--branching B]
+//                   [--item-density D] [--enemy-density D] [--dark F] <output directory>
+//
+// Rooms sit on a grid, one grid per level. A random spanning tree over each
+// grid (each room links west or north) plus one stair per pair of levels
+// keeps every room reachable from room_0; further grid edges are added at
+// random until rooms average --branching exits. Every exit has its way
+// back. Each room is derived from the seed and its index alone, so the
+// files are streamed out in constant memory whatever the size.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+    const uint64_t MAX_ROOMS = 10000000;
+    const size_t FLUSH_BYTES = 1 << 20;
+
+    // Independent random streams, one per kind of decision
+    enum Stream : uint64_t {
+        TREE = 1, EAST, SOUTH, DOWN, STAIRS, DARK, ROOM_NAME, ROOM_TEXT,
+        ITEM, ITEM_ROOM, ENEMY, ENEMY_ROOM
+    };
+
+    uint64_t mix(uint64_t value) {
+        value += 0x9e3779b97f4a7c15ULL;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    uint64_t roll(uint64_t seed, Stream stream, uint64_t index) {
+        return mix(mix(seed ^ (static_cast<uint64_t>(stream) << 56)) ^ index);
+    }
+
+    bool chance(uint64_t roll, double probability) {
+        return static_cast<double>(roll >> 11) * (1.0 / 9007199254740992.0) < probability;
+    }
+
+    int between(uint64_t roll, int low, int high) {
+        return low + static_cast<int>(roll % static_cast<uint64_t>(high - low + 1));
+    }
+
+    template <size_t N>
+    const char* pick(const char* const (&table)[N], uint64_t roll) {
+        return table[roll % N];
+    }
+
+    const char* const PLACE_ADJECTIVES[] = {
+        "Twisty", "Damp", "Collapsed", "Echoing", "Narrow", "Dusty", "Flooded", "Crumbling",
+        "Silent", "Frozen", "Smoky", "Winding", "Vaulted", "Sunken", "Mossy", "Forgotten"
+    };
+
+    const char* const PLACE_NOUNS[] = {
+        "Passage", "Tunnel", "Gallery", "Cavern", "Crawlway", "Chamber", "Grotto", "Hall",
+        "Stairwell", "Vault", "Cellar", "Clearing", "Corridor", "Crypt", "Shaft", "Alcove"
+    };
+
+    const char* const ROOM_SENTENCES[] = {
+        "You are in a maze of twisty little passages, all alike.",
+        "Water drips steadily from the ceiling.",
+        "Fallen rubble nearly blocks the way.",
+        "Your footsteps echo for a long time.",
+        "You have to stoop to make your way through here.",
+        "A thick layer of dust covers everything.",
+        "Faded carvings line the walls.",
+        "A cold draft blows from somewhere ahead.",
+        "Roots have forced their way through the stonework.",
+        "The air smells of old smoke.",
+        "Something skitters away into the dark.",
+        "Scratches on the floor suggest heavy things were dragged through here."
+    };
+
+    const uint64_t SENTENCES = sizeof(ROOM_SENTENCES) / sizeof(ROOM_SENTENCES[0]);
+
+    const char* const ITEM_ADJECTIVES[] = {
+        "rusty", "old", "brass", "silver", "bent", "heavy", "tiny", "ornate",
+        "cracked", "polished", "battered", "golden"
+    };
+
+    struct ItemKind {
+        const char* noun;
+        const char* type;
+        bool lightSource;
+    };
+
+    const ItemKind ITEM_KINDS[] = {
+        {"sword", "weapon", false}, {"dagger", "weapon", false}, {"axe", "weapon", false},
+        {"shield", "armor", false}, {"helmet", "armor", false},
+        {"key", "key", false},
+        {"bread", "consumable", false}, {"potion", "consumable", false},
+        {"coin", "misc", false}, {"rope", "misc", false}, {"book", "misc", false},
+        {"lamp", "misc", true}, {"torch", "misc", true}
+    };
+
+    const char* const ENEMY_KINDS[] = {
+        "Troll", "Thief", "Goblin", "Giant Rat", "Skeleton", "Cultist", "Bat Swarm", "Ghoul"
+    };
+
+    struct Options {
+        uint64_t seed = 1;
+        uint64_t rooms = 1000;
+        uint64_t levels = 1;
+        double branching = 3.0;
+        double itemDensity = 0.1;
+        double enemyDensity = 0.01;
+        double dark = 0.125;
+        std::string directory;
+    };
+
+    // Streams one file in large writes, under a temporary name until it
+    // is complete
+    class OutputFile {
+    private:
+        std::string path_;
+        std::ofstream file_;
+        std::string buffer_;
+
+    public:
+        explicit OutputFile(const std::string& path)
+            : path_(path), file_(path + ".tmp", std::ios::binary | std::ios::trunc) {
+            buffer_.reserve(FLUSH_BYTES * 2);
+        }
+
+        bool isOpen() const { return file_.is_open(); }
+
+        OutputFile& operator<<(const std::string& text) {
+            buffer_ += text;
+            if (buffer_.size() >= FLUSH_BYTES) {
+                file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+                buffer_.clear();
+            }
+            return *this;
+        }
+
+        bool close() {
+            file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            file_.close();
+            if (!file_) {
+                std::remove((path_ + ".tmp").c_str());
+                return false;
+            }
+            return std::rename((path_ + ".tmp").c_str(), path_.c_str()) == 0;
+        }
+    };
+
+    class WorldGenerator {
+    private:
+        Options options_;
+        uint64_t perLevel_;
+        uint64_t width_;
+        double extraEdge_;      // Chance that a non-tree grid edge is an exit
+        uint64_t exits_ = 0;
+
+        static std::string roomId(uint64_t room) {
+            return "room_" + std::to_string(room);
+        }
+
+        uint64_t levelSize(uint64_t level) const {
+            return std::min(perLevel_, options_.rooms - level * perLevel_);
+        }
+
+        // Room index of grid cell (x, y) on level, or rooms when there is none
+        uint64_t at(uint64_t level, uint64_t x, uint64_t y) const {
+            uint64_t local = y * width_ + x;
+            if (x >= width_ || local >= levelSize(level)) {
+                return options_.rooms;
+            }
+            return level * perLevel_ + local;
+        }
+
+        // Whether this room's spanning tree edge leads west (else north)
+        bool treeGoesWest(uint64_t room) const {
+            uint64_t local = room % perLevel_;
+            uint64_t x = local % width_;
+            uint64_t y = local / width_;
+            if (y == 0) {
+                return true;
+            }
+            if (x == 0) {
+                return false;
+            }
+            return roll(options_.seed, TREE, room) & 1;
+        }
+
+        uint64_t stairsFrom(uint64_t level) const {
+            return level * perLevel_ + roll(options_.seed, STAIRS, level) % levelSize(level + 1);
+        }
+
+        void writeExit(OutputFile& out, bool& first, uint64_t from, const char* direction, uint64_t to) {
+            out << (first ? "\n" : ",\n");
+            out << "{\"from\":\"" + roomId(from) + "\",\"direction\":\"" + direction +
+                   "\",\"to\":\"" + roomId(to) + "\"}";
+            first = false;
+            ++exits_;
+        }
+
+        // Each edge is written from its west, north or upper end
+        void writeExits(OutputFile& out, bool& first, uint64_t room) {
+            uint64_t level = room / perLevel_;
+            uint64_t local = room % perLevel_;
+            uint64_t x = local % width_;
+            uint64_t y = local / width_;
+
+            uint64_t east = at(level, x + 1, y);
+            if (east < options_.rooms &&
+                (treeGoesWest(east) || chance(roll(options_.seed, EAST, room), extraEdge_))) {
+                writeExit(out, first, room, "east", east);
+                writeExit(out, first, east, "west", room);
+            }
+
+            uint64_t south = at(level, x, y + 1);
+            if (south < options_.rooms &&
+                (!treeGoesWest(south) || chance(roll(options_.seed, SOUTH, room), extraEdge_))) {
+                writeExit(out, first, room, "south", south);
+                writeExit(out, first, south, "north", room);
+            }
+
+            if (level + 1 < options_.levels && local < levelSize(level + 1)) {
+                uint64_t below = room + perLevel_;
+                if (room == stairsFrom(level) || chance(roll(options_.seed, DOWN, room), extraEdge_)) {
+                    writeExit(out, first, room, "down", below);
+                    writeExit(out, first, below, "up", room);
+                }
+            }
+        }
+
+        std::string generatorInfo() const {
+            return "{\"seed\":" + std::to_string(options_.seed) +
+                   ",\"rooms\":" + std::to_string(options_.rooms) +
+                   ",\"levels\":" + std::to_string(options_.levels) +
+                   ",\"branching\":" + std::to_string(options_.branching) +
+                   ",\"item_density\":" + std::to_string(options_.itemDensity) +
+                   ",\"enemy_density\":" + std::to_string(options_.enemyDensity) +
+                   ",\"dark\":" + std::to_string(options_.dark) + "}";
+        }
+
+        bool writeRooms(const std::string& path) {
+            OutputFile out(path);
+            if (!out.isOpen()) {
+                return false;
+            }
+            out << "{\"start\":\"room_0\",\"generator\":" + generatorInfo() + ",\n\"rooms\":[";
+            for (uint64_t room = 0; room < options_.rooms; ++room) {
+                uint64_t name = roll(options_.seed, ROOM_NAME, room);
+                uint64_t text = roll(options_.seed, ROOM_TEXT, room);
+                bool lit = room == 0 || !chance(roll(options_.seed, DARK, room), options_.dark);
+                out << (room == 0 ? "\n" : ",\n");
+                out << "{\"id\":\"" + roomId(room) + "\",\"name\":\"" + pick(PLACE_ADJECTIVES, name) + " " +
+                       pick(PLACE_NOUNS, name >> 8) + "\",\"description\":\"" + pick(ROOM_SENTENCES, text) + " " +
+                       pick(ROOM_SENTENCES, text + 1 + (text >> 8) % (SENTENCES - 1)) + "\",\"lit\":" + (lit ? "true" : "false") + "}";
+            }
+            out << "],\n\"connections\":[";
+            bool first = true;
+            for (uint64_t room = 0; room < options_.rooms; ++room) {
+                writeExits(out, first, room);
+            }
+            out << "]}\n";
+            return out.close();
+        }
+
+        bool writeItems(const std::string& path, uint64_t& count) {
+            OutputFile out(path);
+            if (!out.isOpen()) {
+                return false;
+            }
+            count = static_cast<uint64_t>(std::llround(static_cast<double>(options_.rooms) * options_.itemDensity));
+            out << "{\"items\":[";
+            for (uint64_t item = 0; item < count; ++item) {
+                uint64_t h = roll(options_.seed, ITEM, item);
+                const ItemKind& kind = ITEM_KINDS[h % (sizeof(ITEM_KINDS) / sizeof(ITEM_KINDS[0]))];
+                std::string type = kind.type;
+
+                // The index keeps names unique, which the loaders require
+                std::string name = std::string(pick(ITEM_ADJECTIVES, h >> 8)) + " " + kind.noun + " " +
+                                   std::to_string(item);
+                std::string fields = "\"name\":\"" + name + "\",\"description\":\"A " + name.substr(0, name.rfind(' ')) +
+                                     ".\",\"weight\":" + std::to_string(between(h >> 16, 1, 10)) +
+                                     ",\"takeable\":true,\"type\":\"" + type + "\",\"value\":" +
+                                     std::to_string(between(h >> 24, 0, 50));
+                if (type == "weapon") {
+                    fields += ",\"damage\":" + std::to_string(between(h >> 32, 3, 15));
+                } else if (type == "armor") {
+                    fields += ",\"defense\":" + std::to_string(between(h >> 32, 1, 8));
+                } else if (kind.lightSource) {
+                    fields += ",\"light_source\":true,\"fuel\":" + std::to_string(between(h >> 32, 50, 500));
+                }
+                out << (item == 0 ? "\n{" : ",\n{") + fields + ",\"location\":\"" +
+                       roomId(roll(options_.seed, ITEM_ROOM, item) % options_.rooms) + "\"}";
+            }
+            out << "]}\n";
+            return out.close();
+        }
+
+        bool writeEnemies(const std::string& path, uint64_t& count) {
+            OutputFile out(path);
+            if (!out.isOpen()) {
+                return false;
+            }
+            count = static_cast<uint64_t>(std::llround(static_cast<double>(options_.rooms) * options_.enemyDensity));
+            out << "{\"enemies\":[";
+            for (uint64_t enemy = 0; enemy < count; ++enemy) {
+                uint64_t h = roll(options_.seed, ENEMY, enemy);
+                std::string kind = pick(ENEMY_KINDS, h);
+
+                // Never in the start room, so a player always gets a first move
+                uint64_t room = options_.rooms == 1 ? 0 : 1 + roll(options_.seed, ENEMY_ROOM, enemy) % (options_.rooms - 1);
+                out << (enemy == 0 ? "\n" : ",\n");
+                out << "{\"name\":\"" + kind + " " + std::to_string(enemy) + "\",\"description\":\"A menacing " + kind + ".\",\"health\":" + std::to_string(between(h >> 8, 10, 60)) +
+                       ",\"attack\":" + std::to_string(between(h >> 16, 3, 20)) +
+                       ",\"defense\":" + std::to_string(between(h >> 24, 0, 8)) +
+                       ",\"experience\":" + std::to_string(between(h >> 32, 10, 100)) +
+                       ",\"hostile\":" + ((h >> 40) % 4 != 0 ? "true" : "false") +
+                       ",\"location\":\"" + roomId(room) + "\"}";
+            }
+            out << "]}\n";
+            return out.close();
+        }
+
+    public:
+        explicit WorldGenerator(const Options& options) : options_(options) {
+            perLevel_ = (options_.rooms + options_.levels - 1) / options_.levels;
+            options_.levels = (options_.rooms + perLevel_ - 1) / perLevel_;   // None left empty
+            width_ = static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(perLevel_))));
+
+            // The tree gives one edge per room; the rest of the target comes
+            // from the other grid edges (east and south, plus down on every
+            // level but the last)
+            double levels = static_cast<double>(options_.levels);
+            double candidates = 2.0 + (levels - 1.0) / levels;
+            extraEdge_ = std::min(1.0, std::max(0.0, (options_.branching / 2.0 - 1.0) / (candidates - 1.0)));
+        }
+
+        bool run() {
+            std::string base = options_.directory;
+            if (base.back() != '/') {
+                base += '/';
+            }
+            uint64_t items = 0;
+            uint64_t enemies = 0;
+            if (!writeRooms(base + "rooms.json")) {
+                std::cerr << "Cannot write " << base << "rooms.json" << std::endl;
+                return false;
+            }
+            if (!writeItems(base + "items.json", items)) {
+                std::cerr << "Cannot write " << base << "items.json" << std::endl;
+                return false;
+            }
+            if (!writeEnemies(base + "enemies.json", enemies)) {
+                std::cerr << "Cannot write " << base << "enemies.json" << std::endl;
+                return false;
+            }
+            std::cout << "Wrote " << options_.rooms << " rooms (" << exits_ << " exits, "
+                      << static_cast<double>(exits_) / static_cast<double>(options_.rooms) << " per room), "
+                      << items << " items and " << enemies << " enemies to " << options_.directory
+                      << " with seed " << options_.seed << std::endl;
+            return true;
+        }
+    };
+
+    bool parseNumber(const char* text, double low, double high, double& value) {
+        char* end = nullptr;
+        value = std::strtod(text, &end);
+        return end != text && *end == '\0' && value >= low && value <= high;
+    }
+
+    int usage(const char* program) {
+        std::cerr << "Usage: " << program << " [--seed N] [--rooms N] [--levels N] [--branching B]\n"
+                  << "       [--item-density D] [--enemy-density D] [--dark F] <output directory>\n"
+                  << "  --rooms          1 to " << MAX_ROOMS << " (default 1000)\n"
+                  << "  --levels         grids stacked with up/down exits (default 1)\n"
+                  << "  --branching      average exits per room, 2 to 4 on one level, up to 6 with more (default 3)\n"
+                  << "  --item-density   items per room (default 0.1)\n"
+                  << "  --enemy-density  enemies per room (default 0.01)\n"
+                  << "  --dark           fraction of unlit rooms (default 0.125)" << std::endl;
+        return 2;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        double value = 0;
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--rooms" && hasValue && parseNumber(argv[++i], 1, MAX_ROOMS, value)) {
+            options.rooms = static_cast<uint64_t>(value);
+        } else if (arg == "--levels" && hasValue && parseNumber(argv[++i], 1, 1000, value)) {
+            options.levels = static_cast<uint64_t>(value);
+        } else if (arg == "--branching" && hasValue && parseNumber(argv[++i], 2, 6, value)) {
+            options.branching = value;
+        } else if (arg == "--item-density" && hasValue && parseNumber(argv[++i], 0, 100, value)) {
+            options.itemDensity = value;
+        } else if (arg == "--enemy-density" && hasValue && parseNumber(argv[++i], 0, 100, value)) {
+            options.enemyDensity = value;
+        } else if (arg == "--dark" && hasValue && parseNumber(argv[++i], 0, 1, value)) {
+            options.dark = value;
+        } else if (options.directory.empty() && !arg.empty() && arg[0] != '-') {
+            options.directory = arg;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (options.directory.empty() || options.levels > options.rooms ||
+        options.branching > 2.0 * (3.0 - 1.0 / static_cast<double>(options.levels))) {
+        return usage(argv[0]);
+    }
+
+    WorldGenerator generator(options);
+    return generator.run() ? 0 : 1;
+}
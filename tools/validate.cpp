@@ -0,0 +1,603 @@
+// zork-validate: checks a world directory (rooms.json, items.json,
+// enemies.json) the way a content pipeline needs: referential integrity,
+// duplicate ids and names, and reachability from the start room. Files are
+// streamed, so packs with millions of rooms fit in memory; the checks run
+// on every core. Prints a JSON report.
+//
+//     zork-validate [--threads N] [--max-issues N] [--strict] [--output FILE] <data directory>
+//
+// Exits 0 when the world is valid, 1 when it has errors (or warnings with
+// --strict) and 2 when it cannot be read at all.
+
+#include "../include/Json.h"
+#include "../include/Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using namespace Zork;
+
+namespace {
+
+    const uint32_t NO_ROOM = 0xffffffff;
+    const size_t MIN_CHUNK = 4096;   // Smaller jobs are not worth a thread
+    const char* const DARK_ROOMS = "dark_rooms";
+
+    // Runs body(begin, end) over [0, count) split across up to threads
+    // threads; the calling thread takes the first share
+    void parallelFor(size_t count, size_t threads, const std::function<void(size_t, size_t)>& body) {
+        size_t workers = std::max<size_t>(1, std::min(threads, (count + MIN_CHUNK - 1) / MIN_CHUNK));
+        if (workers == 1) {
+            body(0, count);
+            return;
+        }
+        size_t share = (count + workers - 1) / workers;
+        std::vector<std::thread> pool;
+        for (size_t w = 1; w < workers; ++w) {
+            size_t begin = std::min(count, w * share);
+            size_t end = std::min(count, begin + share);
+            pool.emplace_back(body, begin, end);
+        }
+        body(0, std::min(count, share));
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+
+    // One read for the whole file; Utils::readFile goes line by line,
+    // which is most of the load time on a large pack
+    bool readWhole(const std::string& path, std::string& contents) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            return false;
+        }
+        contents.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        return static_cast<bool>(file.read(&contents[0], static_cast<std::streamsize>(contents.size())));
+    }
+
+    struct Issue {
+        std::string kind;
+        std::string file;
+        size_t index;
+        std::string message;
+
+        bool operator<(const Issue& other) const {
+            return std::tie(file, index, kind, message) < std::tie(other.file, other.index, other.kind, other.message);
+        }
+    };
+
+    // Collects issues from any thread. Everything is counted, but only the
+    // maxIssues lowest of each severity by (file, index) are kept in full,
+    // so the report is the same however the work was split
+    class Report {
+    private:
+        std::mutex mutex_;
+        size_t maxIssues_;
+        std::vector<Issue> errors_;
+        std::vector<Issue> warnings_;
+        size_t errorCount_ = 0;
+        size_t warningCount_ = 0;
+        std::map<std::string, size_t> counts_;
+
+        void add(std::vector<Issue>& list, size_t& count, Issue issue) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++count;
+            ++counts_[issue.kind];
+            // list is a max-heap while collecting
+            if (list.size() < maxIssues_) {
+                list.push_back(std::move(issue));
+                std::push_heap(list.begin(), list.end());
+            } else if (!list.empty() && issue < list.front()) {
+                std::pop_heap(list.begin(), list.end());
+                list.back() = std::move(issue);
+                std::push_heap(list.begin(), list.end());
+            }
+        }
+
+        static void appendIssues(std::string& json, std::vector<Issue>& issues) {
+            std::sort_heap(issues.begin(), issues.end());
+            json += "[";
+            for (size_t i = 0; i < issues.size(); ++i) {
+                const Issue& issue = issues[i];
+                json += i > 0 ? ",\n    " : "\n    ";
+                json += "{\"kind\":\"" + issue.kind + "\",\"file\":\"" + issue.file +
+                        "\",\"index\":" + std::to_string(issue.index) +
+                        ",\"message\":\"" + JsonValue::escape(issue.message) + "\"}";
+            }
+            json += issues.empty() ? "]" : "\n  ]";
+        }
+
+    public:
+        explicit Report(size_t maxIssues) : maxIssues_(maxIssues) {}
+
+        void error(const std::string& kind, const std::string& file, size_t index, const std::string& message) {
+            add(errors_, errorCount_, {kind, file, index, message});
+        }
+
+        void warning(const std::string& kind, const std::string& file, size_t index, const std::string& message) {
+            add(warnings_, warningCount_, {kind, file, index, message});
+        }
+
+        size_t errorCount() const { return errorCount_; }
+        size_t warningCount() const { return warningCount_; }
+
+        std::string json(const std::map<std::string, std::string>& summary, bool ok) {
+            std::string out = "{\n  \"ok\": ";
+            out += ok ? "true" : "false";
+            for (const auto& field : summary) {
+                out += ",\n  \"" + field.first + "\": " + field.second;
+            }
+            out += ",\n  \"errorCount\": " + std::to_string(errorCount_);
+            out += ",\n  \"warningCount\": " + std::to_string(warningCount_);
+            out += ",\n  \"counts\": {";
+            bool first = true;
+            for (const auto& count : counts_) {
+                out += first ? "" : ",";
+                out += "\"" + count.first + "\": " + std::to_string(count.second);
+                first = false;
+            }
+            out += "},\n  \"errors\": ";
+            appendIssues(out, errors_);
+            out += ",\n  \"warnings\": ";
+            appendIssues(out, warnings_);
+            out += "\n}\n";
+            return out;
+        }
+    };
+
+    // Only what the checks need, so a million rooms stay compact
+    struct RoomRecord {
+        std::string id;
+        bool named;
+        bool described;
+        bool lit;
+    };
+
+    struct LinkRecord {
+        std::string from;
+        std::string to;
+        std::string direction;
+        uint32_t fromRoom;
+        uint32_t toRoom;
+    };
+
+    struct PlacedRecord {
+        std::string name;
+        std::string location;
+        std::string type;      // Items only
+        bool described;
+    };
+
+    // Room id -> index, sharded by hash so every thread can build its own
+    // shard with no locking
+    class RoomIndex {
+    private:
+        std::vector<std::unordered_map<std::string, uint32_t>> shards_;
+
+    public:
+        void build(const std::vector<RoomRecord>& rooms, size_t threads, Report& report) {
+            std::vector<size_t> hashes(rooms.size());
+            parallelFor(rooms.size(), threads, [&](size_t begin, size_t end) {
+                std::hash<std::string> hash;
+                for (size_t i = begin; i < end; ++i) {
+                    hashes[i] = hash(rooms[i].id);
+                }
+            });
+
+            shards_.assign(std::max<size_t>(1, threads), {});
+            size_t shardCount = shards_.size();
+            std::vector<std::thread> pool;
+            for (size_t shard = 0; shard < shardCount; ++shard) {
+                pool.emplace_back([&, shard]() {
+                    auto& map = shards_[shard];
+                    map.reserve(rooms.size() / shardCount + 1);
+                    for (size_t i = 0; i < rooms.size(); ++i) {
+                        if (hashes[i] % shardCount != shard || rooms[i].id.empty()) {
+                            continue;
+                        }
+                        auto inserted = map.emplace(rooms[i].id, static_cast<uint32_t>(i));
+                        if (!inserted.second) {
+                            report.error("duplicate_room_id", "rooms.json", i,
+                                         "room id '" + rooms[i].id + "' is also used by room " +
+                                         std::to_string(inserted.first->second));
+                        }
+                    }
+                });
+            }
+            for (auto& thread : pool) {
+                thread.join();
+            }
+        }
+
+        uint32_t find(const std::string& id) const {
+            const auto& map = shards_[std::hash<std::string>()(id) % shards_.size()];
+            auto found = map.find(id);
+            return found == map.end() ? NO_ROOM : found->second;
+        }
+    };
+
+    class Validator {
+    private:
+        size_t threads_;
+        Report& report_;
+
+        std::vector<RoomRecord> rooms_;
+        std::vector<LinkRecord> links_;
+        std::vector<PlacedRecord> items_;
+        std::vector<PlacedRecord> enemies_;
+        std::string start_;
+        RoomIndex index_;
+
+        // Exits in CSR form: room r's targets are targets_[offsets_[r] .. offsets_[r + 1])
+        std::vector<size_t> offsets_;
+        std::vector<uint32_t> targets_;
+        size_t reachable_ = 0;
+
+        static std::string text(const JsonValue& value) {
+            return value.isString() ? value.asString() : "";
+        }
+
+        bool stream(const std::string& base, const std::string& file, bool required,
+                    const std::function<void(const std::string&, const JsonValue&)>& onElement,
+                    JsonValue& rest) {
+            std::string path = base + file;
+            std::string contents;
+            if (!readWhole(path, contents) || contents.empty()) {
+                if (required) {
+                    report_.error("unreadable_file", file, 0, "cannot read " + path);
+                }
+                return false;
+            }
+            std::string parseError;
+            bool parsed = JsonValue::parseStreaming(contents, rest,
+                [&](const std::string& key, size_t, const JsonValue& element) {
+                    onElement(key, element);
+                    return true;
+                }, parseError);
+            if (!parsed) {
+                report_.error("malformed_json", file, 0, parseError);
+            }
+            return parsed;
+        }
+
+        void load(const std::string& base) {
+            JsonValue rest;
+            stream(base, "rooms.json", true, [this](const std::string& key, const JsonValue& element) {
+                if (key == "rooms") {
+                    rooms_.push_back({text(element["id"]), !text(element["name"]).empty(),
+                                      !text(element["description"]).empty(), element["lit"].asBool(true)});
+                } else if (key == "connections") {
+                    links_.push_back({text(element["from"]), text(element["to"]),
+                                      Utils::toLower(text(element["direction"])), NO_ROOM, NO_ROOM});
+                }
+            }, rest);
+            start_ = rest["start"].asString("west_of_house");
+
+            stream(base, "items.json", false, [this](const std::string& key, const JsonValue& element) {
+                if (key == "items") {
+                    items_.push_back({text(element["name"]), text(element["location"]),
+                                      element["type"].asString("misc"), !text(element["description"]).empty()});
+                }
+            }, rest);
+
+            stream(base, "enemies.json", false, [this](const std::string& key, const JsonValue& element) {
+                if (key == "enemies") {
+                    enemies_.push_back({text(element["name"]), text(element["location"]), "",
+                                        !text(element["description"]).empty()});
+                }
+            }, rest);
+        }
+
+        void checkRooms() {
+            if (rooms_.empty()) {
+                report_.error("no_rooms", "rooms.json", 0, "no rooms defined");
+                return;
+            }
+            parallelFor(rooms_.size(), threads_, [this](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const RoomRecord& room = rooms_[i];
+                    if (room.id.empty()) {
+                        report_.error("missing_field", "rooms.json", i, "room has no id");
+                    }
+                    if (!room.named) {
+                        report_.error("missing_field", "rooms.json", i, "room '" + room.id + "' has no name");
+                    }
+                    if (!room.described) {
+                        report_.warning("missing_field", "rooms.json", i, "room '" + room.id + "' has no description");
+                    }
+                }
+            });
+            index_.build(rooms_, threads_, report_);
+            if (index_.find(start_) == NO_ROOM) {
+                report_.error("unknown_start", "rooms.json", 0, "start room '" + start_ + "' does not exist");
+            }
+        }
+
+        void checkLinks() {
+            parallelFor(links_.size(), threads_, [this](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    LinkRecord& link = links_[i];
+                    link.fromRoom = index_.find(link.from);
+                    link.toRoom = index_.find(link.to);
+                    if (link.fromRoom == NO_ROOM) {
+                        report_.error("dangling_exit", "rooms.json", i,
+                                      "connection from unknown room '" + link.from + "'");
+                    }
+                    if (link.toRoom == NO_ROOM) {
+                        report_.error("dangling_exit", "rooms.json", i,
+                                      "connection to unknown room '" + link.to + "'");
+                    }
+                    const std::string& d = link.direction;
+                    if (d != "north" && d != "south" && d != "east" && d != "west" && d != "up" && d != "down") {
+                        report_.error("unknown_direction", "rooms.json", i,
+                                      "the parser has no direction '" + d + "'");
+                    }
+                }
+            });
+
+            // Counting pass, then fill; exits keep their file order per room
+            offsets_.assign(rooms_.size() + 1, 0);
+            for (const LinkRecord& link : links_) {
+                if (link.fromRoom != NO_ROOM && link.toRoom != NO_ROOM) {
+                    ++offsets_[link.fromRoom + 1];
+                }
+            }
+            for (size_t i = 0; i < rooms_.size(); ++i) {
+                offsets_[i + 1] += offsets_[i];
+            }
+            targets_.resize(offsets_.back());
+            std::vector<uint32_t> linkOf(offsets_.back());
+            std::vector<size_t> fill(offsets_.begin(), offsets_.end() - 1);
+            for (size_t i = 0; i < links_.size(); ++i) {
+                const LinkRecord& link = links_[i];
+                if (link.fromRoom != NO_ROOM && link.toRoom != NO_ROOM) {
+                    linkOf[fill[link.fromRoom]] = static_cast<uint32_t>(i);
+                    targets_[fill[link.fromRoom]++] = link.toRoom;
+                }
+            }
+
+            // A room can only have one exit each way
+            parallelFor(rooms_.size(), threads_, [&](size_t begin, size_t end) {
+                for (size_t room = begin; room < end; ++room) {
+                    for (size_t a = offsets_[room]; a < offsets_[room + 1]; ++a) {
+                        for (size_t b = offsets_[room]; b < a; ++b) {
+                            if (links_[linkOf[a]].direction == links_[linkOf[b]].direction) {
+                                report_.error("duplicate_exit", "rooms.json", linkOf[a],
+                                              "room '" + rooms_[room].id + "' already has an exit " +
+                                              links_[linkOf[a]].direction);
+                                break;
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        // Level-synchronous BFS: each level's frontier is split across
+        // threads, and a room is claimed by whichever thread flips its
+        // visited flag first
+        void checkReachability() {
+            uint32_t start = index_.find(start_);
+            if (start == NO_ROOM) {
+                return;
+            }
+            std::unique_ptr<std::atomic<bool>[]> visited(new std::atomic<bool>[rooms_.size()]());
+            visited[start] = true;
+            std::vector<uint32_t> frontier{start};
+            reachable_ = 1;
+
+            while (!frontier.empty()) {
+                size_t workers = std::max<size_t>(1, std::min(threads_, (frontier.size() + MIN_CHUNK - 1) / MIN_CHUNK));
+                std::vector<std::vector<uint32_t>> found(workers);
+                size_t share = (frontier.size() + workers - 1) / workers;
+                parallelFor(frontier.size(), workers, [&](size_t begin, size_t end) {
+                    std::vector<uint32_t>& next = found[begin / share];
+                    for (size_t i = begin; i < end; ++i) {
+                        uint32_t room = frontier[i];
+                        for (size_t e = offsets_[room]; e < offsets_[room + 1]; ++e) {
+                            uint32_t target = targets_[e];
+                            if (!visited[target].load(std::memory_order_relaxed) &&
+                                !visited[target].exchange(true, std::memory_order_relaxed)) {
+                                next.push_back(target);
+                            }
+                        }
+                    }
+                });
+
+                frontier.clear();
+                for (const auto& part : found) {
+                    frontier.insert(frontier.end(), part.begin(), part.end());
+                }
+                reachable_ += frontier.size();
+            }
+
+            parallelFor(rooms_.size(), threads_, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    // Duplicates are reported already and never indexed
+                    if (!visited[i].load(std::memory_order_relaxed) && !rooms_[i].id.empty() &&
+                        index_.find(rooms_[i].id) == i) {
+                        report_.warning("unreachable_room", "rooms.json", i,
+                                        "room '" + rooms_[i].id + "' cannot be reached from '" + start_ + "'");
+                    }
+                }
+            });
+        }
+
+        static bool knownItemType(const std::string& type) {
+            std::string lower = Utils::toLower(type);
+            return lower == "weapon" || lower == "armor" || lower == "key" || lower == "consumable" ||
+                   lower == "quest" || lower == "quest_item" || lower == "misc";
+        }
+
+        // Players refer to things by name, case-insensitively, so two
+        // with the same name are ambiguous
+        void checkDuplicateNames(const std::vector<PlacedRecord>& records, const std::string& file,
+                                 const std::string& kind) {
+            size_t shardCount = std::max<size_t>(1, threads_);
+            std::vector<std::thread> pool;
+            for (size_t shard = 0; shard < shardCount; ++shard) {
+                pool.emplace_back([&, shard]() {
+                    std::unordered_map<std::string, size_t> seen;
+                    std::hash<std::string> hash;
+                    for (size_t i = 0; i < records.size(); ++i) {
+                        if (records[i].name.empty()) {
+                            continue;
+                        }
+                        std::string name = Utils::toLower(records[i].name);
+                        if (hash(name) % shardCount != shard) {
+                            continue;
+                        }
+                        auto inserted = seen.emplace(name, i);
+                        if (!inserted.second) {
+                            report_.error(kind, file, i, "name '" + records[i].name + "' is also used by entry " +
+                                                         std::to_string(inserted.first->second));
+                        }
+                    }
+                });
+            }
+            for (auto& thread : pool) {
+                thread.join();
+            }
+        }
+
+        void checkItems() {
+            parallelFor(items_.size(), threads_, [this](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const PlacedRecord& item = items_[i];
+                    if (item.name.empty()) {
+                        report_.error("missing_field", "items.json", i, "item has no name");
+                    }
+                    if (!item.described) {
+                        report_.warning("missing_field", "items.json", i, "item '" + item.name + "' has no description");
+                    }
+                    if (!knownItemType(item.type)) {
+                        report_.error("unknown_item_type", "items.json", i,
+                                      "item '" + item.name + "' has unknown type '" + item.type + "'");
+                    }
+                    if (!item.location.empty() && index_.find(item.location) == NO_ROOM) {
+                        report_.error("unknown_location", "items.json", i,
+                                      "item '" + item.name + "' is in unknown room '" + item.location + "'");
+                    }
+                }
+            });
+            checkDuplicateNames(items_, "items.json", "duplicate_item_name");
+        }
+
+        void checkEnemies() {
+            bool anyDark = std::any_of(rooms_.begin(), rooms_.end(), [](const RoomRecord& room) { return !room.lit; });
+            for (size_t i = 0; i < enemies_.size(); ++i) {
+                const PlacedRecord& enemy = enemies_[i];
+                if (enemy.name.empty()) {
+                    report_.error("missing_field", "enemies.json", i, "enemy has no name");
+                }
+                if (enemy.location == DARK_ROOMS) {
+                    if (!anyDark) {
+                        report_.warning("dark_rooms_unmatched", "enemies.json", i,
+                                        "enemy '" + enemy.name + "' lurks in dark rooms, but every room is lit");
+                    }
+                } else if (!enemy.location.empty() && index_.find(enemy.location) == NO_ROOM) {
+                    report_.error("unknown_location", "enemies.json", i,
+                                  "enemy '" + enemy.name + "' is in unknown room '" + enemy.location + "'");
+                }
+            }
+            checkDuplicateNames(enemies_, "enemies.json", "duplicate_enemy_name");
+        }
+
+    public:
+        Validator(size_t threads, Report& report) : threads_(threads), report_(report) {}
+
+        // False only if rooms.json could not be read or parsed
+        bool run(const std::string& directory) {
+            std::string base = directory;
+            if (!base.empty() && base.back() != '/') {
+                base += '/';
+            }
+            load(base);
+            if (report_.errorCount() > 0 && rooms_.empty()) {
+                return false;
+            }
+            checkRooms();
+            checkLinks();
+            checkReachability();
+            checkItems();
+            checkEnemies();
+            return true;
+        }
+
+        std::map<std::string, std::string> summary() const {
+            return {{"rooms", std::to_string(rooms_.size())},
+                    {"connections", std::to_string(links_.size())},
+                    {"items", std::to_string(items_.size())},
+                    {"enemies", std::to_string(enemies_.size())},
+                    {"reachable", std::to_string(reachable_)}};
+        }
+    };
+}
+
+int main(int argc, char* argv[]) {
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t maxIssues = 1000;
+    bool strict = false;
+    std::string output;
+    std::string directory;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-issues" && i + 1 < argc) {
+            maxIssues = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--strict") {
+            strict = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (directory.empty() && arg[0] != '-') {
+            directory = arg;
+        } else {
+            directory.clear();
+            break;
+        }
+    }
+    if (directory.empty()) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--threads N] [--max-issues N] [--strict] [--output FILE] <data directory>" << std::endl;
+        return 2;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    Report report(maxIssues);
+    Validator validator(threads, report);
+    bool readable = validator.run(directory);
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    bool ok = readable && report.errorCount() == 0 && (!strict || report.warningCount() == 0);
+    std::map<std::string, std::string> summary = validator.summary();
+    summary["directory"] = "\"" + JsonValue::escape(directory) + "\"";
+    summary["threads"] = std::to_string(threads);
+    summary["elapsedMs"] = std::to_string(static_cast<long long>(elapsed));
+    std::string json = report.json(summary, ok);
+
+    if (output.empty()) {
+        std::cout << json;
+    } else if (!Utils::writeFile(output, json)) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 2;
+    }
+    if (!readable) {
+        return 2;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,391 @@
+// zork-worldgen: compiles data/rooms.json, items.json and enemies.json into
+// the constant tables declared in include/EmbeddedWorld.h, and carries
+// rules.json along as text. Runs as part of the build; any content error is
+// reported and fails it.
+//
+//     zork-worldgen <data directory> <output .cpp>
+
+#include "../include/Json.h"
+#include "../include/Utils.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace Zork;
+
+namespace {
+
+    const uint32_t NO_ROOM = 0xffffffff;
+    const char* const DARK_ROOMS = "dark_rooms";
+
+    struct Exit {
+        std::string direction;
+        uint32_t room;
+    };
+
+    class WorldCompiler {
+    private:
+        std::vector<std::string> errors_;
+        std::unordered_map<std::string, uint32_t> roomIndex_;
+        std::vector<std::vector<Exit>> exits_;
+        std::ostringstream rooms_;
+        std::ostringstream items_;
+        std::ostringstream enemies_;
+        std::string rules_;             // rules.json as written, if any
+        size_t itemCount_ = 0;
+        size_t enemyCount_ = 0;
+        uint32_t startRoom_ = 0;
+
+        void error(const std::string& message) {
+            errors_.push_back(message);
+        }
+
+        // Required string member; reports and returns "" when missing
+        std::string text(const JsonValue& object, const std::string& key, const std::string& where) {
+            const JsonValue& value = object[key];
+            if (!value.isString() || value.asString().empty()) {
+                error(where + ": missing \"" + key + "\"");
+                return "";
+            }
+            return value.asString();
+        }
+
+        int number(const JsonValue& object, const std::string& key, int fallback,
+                   int minimum, const std::string& where) {
+            const JsonValue& value = object[key];
+            if (value.isNull()) {
+                return fallback;
+            }
+            if (!value.isNumber() || value.asInt() < minimum) {
+                error(where + ": \"" + key + "\" must be a number of at least " + std::to_string(minimum));
+                return fallback;
+            }
+            return value.asInt();
+        }
+
+        bool flag(const JsonValue& object, const std::string& key, bool fallback, const std::string& where) {
+            const JsonValue& value = object[key];
+            if (value.isNull()) {
+                return fallback;
+            }
+            if (!value.isBool()) {
+                error(where + ": \"" + key + "\" must be true or false");
+                return fallback;
+            }
+            return value.asBool();
+        }
+
+        static std::string literal(const std::string& value) {
+            std::string out = "\"";
+            for (char ch : value) {
+                switch (ch) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(ch) < 0x20) {
+                            char escaped[8];
+                            std::snprintf(escaped, sizeof(escaped), "\\%03o", static_cast<unsigned char>(ch));
+                            out += escaped;
+                        } else {
+                            out += ch;
+                        }
+                }
+            }
+            return out + "\"";
+        }
+
+        static const char* boolean(bool value) {
+            return value ? "true" : "false";
+        }
+
+        static std::string roomRef(uint32_t room) {
+            return room == NO_ROOM ? "EmbeddedWorld::NO_ROOM" : std::to_string(room);
+        }
+
+        // Only the types Item understands; WorldLoader maps unknown ones to
+        // misc at runtime, but a typo in the flagship world is a bug
+        static bool itemType(const std::string& name, std::string& enumerator) {
+            static const std::pair<const char*, const char*> TYPES[] = {
+                {"weapon", "WEAPON"}, {"armor", "ARMOR"}, {"key", "KEY"},
+                {"consumable", "CONSUMABLE"}, {"quest", "QUEST_ITEM"},
+                {"quest_item", "QUEST_ITEM"}, {"misc", "MISC"}};
+            for (const auto& type : TYPES) {
+                if (Utils::toLower(name) == type.first) {
+                    enumerator = std::string("ItemType::") + type.second;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        uint32_t findRoom(const std::string& id) const {
+            auto found = roomIndex_.find(id);
+            return found == roomIndex_.end() ? NO_ROOM : found->second;
+        }
+
+        void compileRooms(const JsonValue& document) {
+            const JsonValue& rooms = document["rooms"];
+            if (!rooms.isArray() || rooms.size() == 0) {
+                error("rooms.json: no rooms defined");
+                return;
+            }
+
+            for (size_t i = 0; i < rooms.size(); ++i) {
+                std::string where = "rooms.json: room " + std::to_string(i);
+                std::string id = text(rooms[i], "id", where);
+                if (!id.empty() && !roomIndex_.emplace(id, static_cast<uint32_t>(i)).second) {
+                    error("rooms.json: duplicate room id '" + id + "'");
+                }
+            }
+            exits_.resize(rooms.size());
+
+            const JsonValue& connections = document["connections"];
+            for (size_t i = 0; i < connections.size(); ++i) {
+                const JsonValue& link = connections[i];
+                std::string where = "rooms.json: connection " + std::to_string(i);
+                std::string fromId = text(link, "from", where);
+                std::string toId = text(link, "to", where);
+                std::string direction = Utils::toLower(text(link, "direction", where));
+                uint32_t from = findRoom(fromId);
+                uint32_t to = findRoom(toId);
+                if (from == NO_ROOM || to == NO_ROOM) {
+                    error(where + " references an unknown room");
+                    continue;
+                }
+                if (direction != "north" && direction != "south" && direction != "east" &&
+                    direction != "west" && direction != "up" && direction != "down") {
+                    error(where + ": the parser has no direction '" + direction + "'");
+                    continue;
+                }
+                for (const Exit& exit : exits_[from]) {
+                    if (exit.direction == direction) {
+                        error(where + ": '" + fromId + "' already has an exit " + direction);
+                    }
+                }
+                exits_[from].push_back({direction, to});
+            }
+
+            uint32_t firstExit = 0;
+            for (size_t i = 0; i < rooms.size(); ++i) {
+                const JsonValue& room = rooms[i];
+                std::string where = "rooms.json: room '" + room["id"].asString() + "'";
+                rooms_ << "            {" << literal(room["id"].asString()) << ", "
+                       << literal(text(room, "name", where)) << ",\n"
+                       << "             " << literal(text(room, "description", where)) << ",\n"
+                       << "             " << boolean(flag(room, "lit", true, where)) << ", "
+                       << boolean(flag(room, "locked", false, where)) << ", "
+                       << firstExit << ", " << exits_[i].size() << "},\n";
+                firstExit += static_cast<uint32_t>(exits_[i].size());
+            }
+
+            std::string start = document["start"].asString("west_of_house");
+            startRoom_ = findRoom(start);
+            if (startRoom_ == NO_ROOM) {
+                error("rooms.json: start room '" + start + "' does not exist");
+            }
+        }
+
+        void compileItems(const JsonValue& document) {
+            const JsonValue& items = document["items"];
+            std::set<std::string> names;
+            for (size_t i = 0; i < items.size(); ++i) {
+                const JsonValue& item = items[i];
+                std::string where = "items.json: item " + std::to_string(i);
+                std::string name = text(item, "name", where);
+                if (!name.empty()) {
+                    where = "items.json: item '" + name + "'";
+                    if (!names.insert(Utils::toLower(name)).second) {
+                        error(where + " is defined twice");
+                    }
+                }
+
+                std::string type;
+                if (!itemType(item["type"].asString("misc"), type)) {
+                    error(where + ": unknown type '" + item["type"].asString() + "'");
+                }
+
+                uint32_t room = NO_ROOM;
+                std::string location = item["location"].asString();
+                if (!location.empty()) {
+                    room = findRoom(location);
+                    if (room == NO_ROOM) {
+                        error(where + " is in unknown room '" + location + "'");
+                    }
+                }
+
+                bool lightSource = flag(item, "light_source", false, where);
+                if (!lightSource && (item.has("fuel") || item.has("on") || item.has("light_radius"))) {
+                    error(where + ": fuel and light settings need \"light_source\": true");
+                }
+
+                items_ << "            {" << literal(name) << ",\n"
+                       << "             " << literal(text(item, "description", where)) << ",\n"
+                       << "             " << number(item, "weight", 1, 0, where) << ", "
+                       << boolean(flag(item, "takeable", true, where)) << ", "
+                       << (type.empty() ? "ItemType::MISC" : type) << ", "
+                       << number(item, "value", 0, 0, where) << ", "
+                       << number(item, "damage", 0, 0, where) << ", "
+                       << number(item, "defense", 0, 0, where) << ", "
+                       << boolean(lightSource) << ", "
+                       << boolean(flag(item, "on", false, where)) << ", "
+                       << number(item, "fuel", -1, -1, where) << ", "
+                       << number(item, "light_radius", 0, 0, where) << ", "
+                       << roomRef(room) << "},\n";
+                ++itemCount_;
+            }
+        }
+
+        void compileEnemies(const JsonValue& document) {
+            const JsonValue& enemies = document["enemies"];
+            for (size_t i = 0; i < enemies.size(); ++i) {
+                const JsonValue& enemy = enemies[i];
+                std::string where = "enemies.json: enemy " + std::to_string(i);
+                std::string name = text(enemy, "name", where);
+                if (!name.empty()) {
+                    where = "enemies.json: enemy '" + name + "'";
+                }
+
+                uint32_t room = NO_ROOM;
+                std::string location = enemy["location"].asString();
+                bool darkRooms = location == DARK_ROOMS;
+                if (!location.empty() && !darkRooms) {
+                    room = findRoom(location);
+                    if (room == NO_ROOM) {
+                        error(where + " is in unknown room '" + location + "'");
+                    }
+                }
+
+                enemies_ << "            {" << literal(name) << ",\n"
+                         << "             " << literal(text(enemy, "description", where)) << ",\n"
+                         << "             " << number(enemy, "health", 1, 1, where) << ", "
+                         << number(enemy, "attack", 0, 0, where) << ", "
+                         << number(enemy, "defense", 0, 0, where) << ", "
+                         << number(enemy, "experience", 0, 0, where) << ", "
+                         << boolean(flag(enemy, "hostile", true, where)) << ", "
+                         << roomRef(room) << ", " << boolean(darkRooms) << "},\n";
+                ++enemyCount_;
+            }
+        }
+
+        bool parse(const std::string& path, bool required, JsonValue& document) {
+            std::string contents = Utils::readFile(path);
+            if (contents.empty()) {
+                if (required) {
+                    error("cannot read " + path);
+                }
+                return false;
+            }
+            std::string parseError;
+            if (!JsonValue::parse(contents, document, parseError)) {
+                error(path + ": " + parseError);
+                return false;
+            }
+            return true;
+        }
+
+    public:
+        bool compile(const std::string& directory) {
+            std::string base = directory;
+            if (!base.empty() && base.back() != '/') {
+                base += '/';
+            }
+
+            JsonValue rooms, items, enemies;
+            if (parse(base + "rooms.json", true, rooms)) {
+                compileRooms(rooms);
+            }
+            if (parse(base + "items.json", false, items)) {
+                compileItems(items);
+            }
+            if (parse(base + "enemies.json", false, enemies)) {
+                compileEnemies(enemies);
+            }
+            // Rules are compiled by the game itself; only check they parse
+            JsonValue rules;
+            if (parse(base + "rules.json", false, rules)) {
+                rules_ = Utils::readFile(base + "rules.json");
+            }
+            return errors_.empty();
+        }
+
+        const std::vector<std::string>& errors() const { return errors_; }
+
+        std::string source() const {
+            std::ostringstream out;
+            out << "// Generated by zork-worldgen from data/*.json. Do not edit.\n"
+                << "#include \"EmbeddedWorld.h\"\n\n"
+                << "namespace Zork {\n\n"
+                << "    namespace {\n"
+                << "        constexpr EmbeddedRoom ROOMS[] = {\n" << rooms_.str() << "        };\n";
+
+            size_t exitCount = 0;
+            for (const auto& exits : exits_) {
+                exitCount += exits.size();
+            }
+            if (exitCount > 0) {
+                out << "\n        constexpr EmbeddedExit EXITS[] = {\n";
+                for (const auto& exits : exits_) {
+                    for (const Exit& exit : exits) {
+                        out << "            {" << literal(exit.direction) << ", " << exit.room << "},\n";
+                    }
+                }
+                out << "        };\n";
+            }
+            if (itemCount_ > 0) {
+                out << "\n        constexpr EmbeddedItem ITEMS[] = {\n" << items_.str() << "        };\n";
+            }
+            if (enemyCount_ > 0) {
+                out << "\n        constexpr EmbeddedEnemy ENEMIES[] = {\n" << enemies_.str() << "        };\n";
+            }
+
+            out << "    }\n\n"
+                << "    const EmbeddedWorld EMBEDDED_WORLD = {\n"
+                << "        ROOMS, " << exits_.size() << ",\n"
+                << "        " << (exitCount > 0 ? "EXITS" : "nullptr") << ", " << exitCount << ",\n"
+                << "        " << (itemCount_ > 0 ? "ITEMS" : "nullptr") << ", " << itemCount_ << ",\n"
+                << "        " << (enemyCount_ > 0 ? "ENEMIES" : "nullptr") << ", " << enemyCount_ << ",\n"
+                << "        " << startRoom_ << ",\n"
+                << "        " << (rules_.empty() ? "nullptr" : literal(rules_)) << "\n"
+                << "    };\n"
+                << "}\n";
+            return out.str();
+        }
+    };
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <data directory> <output .cpp>" << std::endl;
+        return 2;
+    }
+
+    WorldCompiler compiler;
+    if (!compiler.compile(argv[1])) {
+        for (const auto& message : compiler.errors()) {
+            std::cerr << "zork-worldgen: " << message << std::endl;
+        }
+        return 1;
+    }
+
+    // Write beside the target and rename, so a failed run never leaves a
+    // half-written file that looks up to date
+    std::filesystem::path output(argv[2]);
+    std::error_code ignored;
+    if (output.has_parent_path()) {
+        std::filesystem::create_directories(output.parent_path(), ignored);
+    }
+    std::string temporary = output.string() + ".tmp";
+    if (!Utils::writeFile(temporary, compiler.source()) ||
+        std::rename(temporary.c_str(), output.string().c_str()) != 0) {
+        std::cerr << "zork-worldgen: cannot write " << output.string() << std::endl;
+        return 1;
+    }
+    return 0;
+}